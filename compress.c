@@ -1042,6 +1042,8 @@ struct MxOps mx_comp_ops = {
   .msg_commit       = comp_msg_commit,
   .msg_close        = comp_msg_close,
   .msg_padding_size = comp_msg_padding_size,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = comp_tags_edit,
   .tags_commit      = comp_tags_commit,
   .path_probe       = comp_path_probe,
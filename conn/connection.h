@@ -40,6 +40,9 @@ struct Connection
   char inbuf[LONG_STRING];
   int bufpos;
 
+  char outbuf[HUGE_STRING]; /**< data waiting to be sent, see mutt_socket_flush() */
+  int outlen;
+
   int fd;
   int available;
 
@@ -77,6 +77,38 @@ static int socket_preconnect(void)
   return 0;
 }
 
+/**
+ * socket_write_all - Write all the data to a socket
+ * @param conn Connection to a server
+ * @param buf  Buffer with data to write
+ * @param len  Length of data to write
+ * @retval >0 Number of bytes written
+ * @retval -1 Error
+ */
+static int socket_write_all(struct Connection *conn, const char *buf, int len)
+{
+  int sent = 0;
+
+  while (sent < len)
+  {
+    const int rc = conn->conn_write(conn, buf + sent, len - sent);
+    if (rc < 0)
+    {
+      mutt_debug(1, "error writing (%s), closing socket\n", strerror(errno));
+      mutt_socket_close(conn);
+
+      return -1;
+    }
+
+    if (rc < len - sent)
+      mutt_debug(3, "short write (%d of %d bytes)\n", rc, len - sent);
+
+    sent += rc;
+  }
+
+  return sent;
+}
+
 /**
  * mutt_socket_open - Simple wrapper
  * @param conn Connection to a server
@@ -90,6 +122,7 @@ int mutt_socket_open(struct Connection *conn)
   if (socket_preconnect())
     return -1;
 
+  conn->outlen = 0;
   rc = conn->conn_open(conn);
 
   mutt_debug(2, "Connected to %s:%d on fd=%d\n", conn->account.host,
@@ -111,14 +144,59 @@ int mutt_socket_close(struct Connection *conn)
   if (conn->fd < 0)
     mutt_debug(1, "Attempt to close closed connection.\n");
   else
+  {
+    /* Send anything still buffered.  Don't use mutt_socket_flush(): if the
+     * write failed, it would close the connection from under us. */
+    int len = conn->outlen;
+    conn->outlen = 0;
+    for (int sent = 0; sent < len;)
+    {
+      const int wrc = conn->conn_write(conn, conn->outbuf + sent, len - sent);
+      if (wrc <= 0)
+      {
+        mutt_debug(1, "error flushing (%s) before close\n", strerror(errno));
+        break;
+      }
+      sent += wrc;
+    }
+
     rc = conn->conn_close(conn);
+  }
 
   conn->fd = -1;
   conn->ssf = 0;
+  conn->outlen = 0;
 
   return rc;
 }
 
+/**
+ * mutt_socket_flush - Send any buffered data
+ * @param conn Connection to a server
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * mutt_socket_write_d() collects small writes so that they can be sent
+ * together.  The buffer is flushed before every read or poll, because the
+ * caller is about to wait for the server's reply.
+ */
+int mutt_socket_flush(struct Connection *conn)
+{
+  int len = conn->outlen;
+
+  if (len == 0)
+    return 0;
+
+  conn->outlen = 0;
+  if (conn->fd < 0)
+  {
+    mutt_debug(1, "attempt to write to closed connection\n");
+    return -1;
+  }
+
+  return (socket_write_all(conn, conn->outbuf, len) < 0) ? -1 : 0;
+}
+
 /**
  * mutt_socket_read - read from a Connection
  * @param conn Connection a server
@@ -129,6 +207,9 @@ int mutt_socket_close(struct Connection *conn)
  */
 int mutt_socket_read(struct Connection *conn, char *buf, size_t len)
 {
+  if (mutt_socket_flush(conn) < 0)
+    return -1;
+
   return conn->conn_read(conn, buf, len);
 }
 
@@ -142,6 +223,9 @@ int mutt_socket_read(struct Connection *conn, char *buf, size_t len)
  */
 int mutt_socket_write(struct Connection *conn, const char *buf, size_t len)
 {
+  if (mutt_socket_flush(conn) < 0)
+    return -1;
+
   return conn->conn_write(conn, buf, len);
 }
 
@@ -153,11 +237,11 @@ int mutt_socket_write(struct Connection *conn, const char *buf, size_t len)
  * @param dbg Debug level for logging
  * @retval >0 Number of bytes written
  * @retval -1 Error
+ *
+ * Small writes are buffered, see mutt_socket_flush().
  */
 int mutt_socket_write_d(struct Connection *conn, const char *buf, int len, int dbg)
 {
-  int sent = 0;
-
   mutt_debug(dbg, "%d> %s", conn->fd, buf);
 
   if (conn->fd < 0)
@@ -166,24 +250,16 @@ int mutt_socket_write_d(struct Connection *conn, const char *buf, int len, int d
     return -1;
   }
 
-  while (sent < len)
-  {
-    const int rc = conn->conn_write(conn, buf + sent, len - sent);
-    if (rc < 0)
-    {
-      mutt_debug(1, "error writing (%s), closing socket\n", strerror(errno));
-      mutt_socket_close(conn);
+  if ((conn->outlen + len > sizeof(conn->outbuf)) && (mutt_socket_flush(conn) < 0))
+    return -1;
 
-      return -1;
-    }
+  if (len >= sizeof(conn->outbuf))
+    return socket_write_all(conn, buf, len);
 
-    if (rc < len - sent)
-      mutt_debug(3, "short write (%d of %d bytes)\n", rc, len - sent);
+  memcpy(conn->outbuf + conn->outlen, buf, len);
+  conn->outlen += len;
 
-    sent += rc;
-  }
-
-  return sent;
+  return len;
 }
 
 /**
@@ -199,6 +275,9 @@ int mutt_socket_poll(struct Connection *conn, time_t wait_secs)
   if (conn->bufpos < conn->available)
     return conn->available - conn->bufpos;
 
+  if (mutt_socket_flush(conn) < 0)
+    return -1;
+
   if (conn->conn_poll)
     return conn->conn_poll(conn, wait_secs);
 
@@ -216,6 +295,9 @@ int mutt_socket_readchar(struct Connection *conn, char *c)
 {
   if (conn->bufpos >= conn->available)
   {
+    if (mutt_socket_flush(conn) < 0)
+      return -1;
+
     if (conn->fd >= 0)
       conn->available = conn->conn_read(conn, conn->inbuf, sizeof(conn->inbuf));
     else
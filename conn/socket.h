@@ -50,6 +50,7 @@ struct Connection *mutt_socket_new(enum ConnectionType type);
 
 int mutt_socket_open(struct Connection *conn);
 int mutt_socket_close(struct Connection *conn);
+int mutt_socket_flush(struct Connection *conn);
 int mutt_socket_read(struct Connection *conn, char *buf, size_t len);
 int mutt_socket_write(struct Connection *conn, const char *buf, size_t len);
 int mutt_socket_poll(struct Connection *conn, time_t wait_secs);
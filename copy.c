@@ -395,6 +395,7 @@ int mutt_copy_hdr(FILE *in, FILE *out, LOFF_T off_start, LOFF_T off_end,
  * * #CH_UPDATE_IRT   update the In-Reply-To: header
  * * #CH_UPDATE_REFS  update the References: header
  * * #CH_VIRTUAL      write virtual header lines too
+ * * #CH_PAD_STATUS   always write Status: and X-Status:, padded to full width
  *
  * prefix
  * * string to use if CH_PREFIX is set
@@ -444,23 +445,29 @@ int mutt_copy_header(FILE *in, struct Email *e, FILE *out, int flags, const char
 
   if ((flags & CH_UPDATE) && (flags & CH_NOSTATUS) == 0)
   {
-    if (e->old || e->read)
+    /* Padding leaves room for every flag, so that an mbox can change the
+     * flags later without rewriting the message, see mbox_update_status() */
+    if (e->old || e->read || (flags & CH_PAD_STATUS))
     {
       fputs("Status: ", out);
       if (e->read)
         fputs("RO", out);
       else if (e->old)
         fputc('O', out);
+      if (flags & CH_PAD_STATUS)
+        fputs(e->read ? "" : e->old ? " " : "  ", out);
       fputc('\n', out);
     }
 
-    if (e->flagged || e->replied)
+    if (e->flagged || e->replied || (flags & CH_PAD_STATUS))
     {
       fputs("X-Status: ", out);
       if (e->replied)
         fputc('A', out);
       if (e->flagged)
         fputc('F', out);
+      if (flags & CH_PAD_STATUS)
+        fputs((e->replied && e->flagged) ? "" : (e->replied || e->flagged) ? " " : "  ", out);
       fputc('\n', out);
     }
   }
@@ -832,6 +839,8 @@ static int append_message(struct Context *dest, FILE *fpin, struct Context *src,
   if (dest->mailbox->magic == MUTT_MBOX || dest->mailbox->magic == MUTT_MMDF)
     chflags |= CH_FROM | CH_FORCE_FROM;
   chflags |= (dest->mailbox->magic == MUTT_MAILDIR ? CH_NOSTATUS : CH_UPDATE);
+  if ((dest->mailbox->magic == MUTT_MBOX) || (dest->mailbox->magic == MUTT_MMDF))
+    chflags |= CH_PAD_STATUS;
   r = mutt_copy_message_fp(msg->fp, fpin, e, flags, chflags);
   if (mx_msg_commit(dest, msg) != 0)
     r = -1;
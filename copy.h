@@ -65,6 +65,7 @@ struct Context;
 #define CH_DISPLAY        (1 << 18) /**< display result to user */
 #define CH_UPDATE_LABEL   (1 << 19) /**< update X-Label: from hdr->env->x_label? */
 #define CH_VIRTUAL        (1 << 20) /**< write virtual header lines too */
+#define CH_PAD_STATUS     (1 << 21) /**< pad Status: and X-Status: so they can be updated in place */
 
 int mutt_copy_hdr(FILE *in, FILE *out, LOFF_T off_start, LOFF_T off_end,
                   int flags, const char *prefix);
@@ -49,6 +49,7 @@
 #include "menu.h"
 #include "mutt_curses.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_window.h"
 #include "muttlib.h"
 #include "opcodes.h"
@@ -62,9 +63,6 @@
 #ifdef USE_NOTMUCH
 #include "notmuch/mutt_notmuch.h"
 #endif
-#ifdef USE_INOTIFY
-#include "monitor.h"
-#endif
 
 /* These Config Variables are only used in curs_lib.c */
 bool MetaKey; ///< Config: Interpret 'ALT-x' as 'ESC-x'
@@ -137,13 +135,12 @@ void mutt_getch_timeout(int delay)
   timeout(delay);
 }
 
-#ifdef USE_INOTIFY
 /**
- * mutt_monitor_getch - Get a character and poll the filesystem monitor
+ * mutt_poll_getch - Get a character, handling other events while waiting
  * @retval num Character pressed
- * @retval ERR Timeout
+ * @retval ERR Timeout, or another event needs attention
  */
-static int mutt_monitor_getch(void)
+static int mutt_poll_getch(void)
 {
   /* ncurses has its own internal buffer, so before we perform a poll,
    * we need to make sure there isn't a character waiting */
@@ -152,14 +149,13 @@ static int mutt_monitor_getch(void)
   timeout(MuttGetchTimeout);
   if (ch == ERR)
   {
-    if (mutt_monitor_poll() != 0)
+    if (mutt_poll_wait(MuttGetchTimeout) != 0)
       ch = ERR;
     else
       ch = getch();
   }
   return ch;
 }
-#endif /* USE_INOTIFY */
 
 /**
  * mutt_getch - Read a character from the input buffer
@@ -194,11 +190,7 @@ struct Event mutt_getch(void)
   ch = KEY_RESIZE;
   while (ch == KEY_RESIZE)
 #endif /* KEY_RESIZE */
-#ifdef USE_INOTIFY
-    ch = mutt_monitor_getch();
-#else
-  ch = getch();
-#endif /* USE_INOTIFY */
+    ch = mutt_poll_getch();
   mutt_sig_allow_interrupt(0);
 
   if (SigInt)
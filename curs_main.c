@@ -51,6 +51,7 @@
 #include "mutt_curses.h"
 #include "mutt_header.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_thread.h"
 #include "mutt_window.h"
 #include "muttlib.h"
@@ -1171,14 +1172,18 @@ int mutt_index_menu(void)
         continue;
       }
 
+      /* the timers, e.g. $mail_check, run while we wait for a command */
+      mutt_poll_timers(MUTT_POLL_TIMER_COMMAND, true);
       op = km_dokey(MENU_MAIN);
+      mutt_poll_timers(MUTT_POLL_TIMER_COMMAND, false);
 
       mutt_debug(4, "[%d]: Got op %d\n", __LINE__, op);
 
-      /* either user abort or timeout */
+      /* either user abort, timeout or an event woke us */
       if (op < 0)
       {
-        mutt_timeout_hook();
+        if (!mutt_poll_woken())
+          mutt_timeout_hook();
         if (tag)
           mutt_window_clearline(MuttMessageWindow, 0);
         continue;
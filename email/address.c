@@ -29,8 +29,12 @@
 
 #include "config.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "mutt/mutt.h"
 #include "address.h"
 #include "idna2.h"
@@ -64,6 +68,26 @@ const char *const AddressErrors[] = {
   "bad route in <>", "bad address in <>",      "bad address spec",
 };
 
+#define ADDR_CACHE_MAX 1024           ///< Number of parsed lists to keep
+#define ADDR_CACHE_KEY_MAX HUGE_STRING ///< Longest header that will be cached
+
+/**
+ * AddrCache - Recently parsed address lists, keyed by the header text
+ *
+ * Mailing list traffic repeats the same To and Cc headers many times.  The
+ * cached lists are never handed out, only copied.
+ */
+static struct Hash *AddrCache = NULL;
+
+#ifdef USE_PTHREADS
+static pthread_mutex_t AddrCacheLock = PTHREAD_MUTEX_INITIALIZER;
+#define cache_lock() pthread_mutex_lock(&AddrCacheLock)
+#define cache_unlock() pthread_mutex_unlock(&AddrCacheLock)
+#else
+#define cache_lock()
+#define cache_unlock()
+#endif
+
 /**
  * free_address - Free a single Address
  * @param a Address to free
@@ -74,8 +98,16 @@ static void free_address(struct Address **a)
 {
   if (!a || !*a)
     return;
-  FREE(&(*a)->personal);
-  FREE(&(*a)->mailbox);
+  if ((*a)->interned)
+  {
+    mutt_str_intern_free(&(*a)->personal);
+    mutt_str_intern_free(&(*a)->mailbox);
+  }
+  else
+  {
+    FREE(&(*a)->personal);
+    FREE(&(*a)->mailbox);
+  }
   FREE(a);
 }
 
@@ -373,8 +405,10 @@ static const char *parse_addr_spec(const char *s, char *comment, size_t *comment
  * @param[out] comment    Buffer for any comments
  * @param[out] commentlen Length of any comments
  * @param[in]  commentmax Length of the comments buffer
+ * @retval true  Success
+ * @retval false The address is invalid, and wasn't added
  */
-static void add_addrspec(struct Address **top, struct Address **last, const char *phrase,
+static bool add_addrspec(struct Address **top, struct Address **last, const char *phrase,
                          char *comment, size_t *commentlen, size_t commentmax)
 {
   struct Address *cur = mutt_addr_new();
@@ -382,7 +416,7 @@ static void add_addrspec(struct Address **top, struct Address **last, const char
   if (!parse_addr_spec(phrase, comment, commentlen, commentmax, cur))
   {
     mutt_addr_free(&cur);
-    return;
+    return false;
   }
 
   if (*last)
@@ -390,6 +424,7 @@ static void add_addrspec(struct Address **top, struct Address **last, const char
   else
     *top = cur;
   *last = cur;
+  return true;
 }
 
 /**
@@ -456,13 +491,17 @@ void mutt_addr_free(struct Address **p)
 }
 
 /**
- * mutt_addr_parse_list - Parse a list of email addresses
- * @param top List to append addresses
- * @param s   String to parse
+ * parse_list - Parse a list of email addresses
+ * @param[in]  top     List to append addresses
+ * @param[in]  s       String to parse
+ * @param[out] skipped Set to true if an invalid address was skipped
  * @retval ptr  Top of the address list
  * @retval NULL Error
+ *
+ * Unlike #AddressError, which is shared, the result can be trusted when
+ * several threads are parsing.
  */
-struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
+static struct Address *parse_list(struct Address *top, const char *s, bool *skipped)
 {
   int ws_pending;
   const char *ps = NULL;
@@ -471,6 +510,7 @@ struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
   struct Address *cur = NULL;
 
   AddressError = 0;
+  *skipped = false;
 
   struct Address *last = top;
   while (last && last->next)
@@ -486,7 +526,8 @@ struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
       if (phraselen != 0)
       {
         terminate_buffer(phrase, phraselen);
-        add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1);
+        if (!add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1))
+          *skipped = true;
       }
       else if ((commentlen != 0) && last && !last->personal)
       {
@@ -544,7 +585,8 @@ struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
       if (phraselen != 0)
       {
         terminate_buffer(phrase, phraselen);
-        add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1);
+        if (!add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1))
+          *skipped = true;
       }
       else if ((commentlen != 0) && last && !last->personal)
       {
@@ -608,7 +650,8 @@ struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
   {
     terminate_buffer(phrase, phraselen);
     terminate_buffer(comment, commentlen);
-    add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1);
+    if (!add_addrspec(&top, &last, phrase, comment, &commentlen, sizeof(comment) - 1))
+      *skipped = true;
   }
   else if ((commentlen != 0) && last && !last->personal)
   {
@@ -619,6 +662,103 @@ struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
   return top;
 }
 
+/**
+ * addr_cache_free - Free a cached Address list - Implements ::hash_destructor_t
+ */
+static void addr_cache_free(int type, void *obj, intptr_t data)
+{
+  struct Address *a = obj;
+  mutt_addr_free(&a);
+}
+
+/**
+ * addr_cache_lookup - Find a previously parsed Address list
+ * @param s Header text
+ * @retval ptr  Copy of the cached list
+ * @retval NULL Not in the cache
+ */
+static struct Address *addr_cache_lookup(const char *s)
+{
+  struct Address *copy = NULL;
+
+  cache_lock();
+  struct Address *a = AddrCache ? mutt_hash_find(AddrCache, s) : NULL;
+  if (a)
+    copy = mutt_addr_copy_list(a, false);
+  cache_unlock();
+
+  return copy;
+}
+
+/**
+ * addr_cache_add - Remember a parsed Address list
+ * @param s    Header text
+ * @param addr Parsed Address list, which will be copied
+ *
+ * When the cache is full, it's emptied and started afresh.
+ */
+static void addr_cache_add(const char *s, struct Address *addr)
+{
+  struct Address *copy = mutt_addr_copy_list(addr, false);
+
+  cache_lock();
+  if (AddrCache && (AddrCache->num_keys >= ADDR_CACHE_MAX))
+    mutt_hash_destroy(&AddrCache);
+  if (!AddrCache)
+  {
+    AddrCache = mutt_hash_create(ADDR_CACHE_MAX, MUTT_HASH_STRDUP_KEYS);
+    mutt_hash_set_destructor(AddrCache, addr_cache_free, 0);
+  }
+  /* Another thread may have got here first */
+  if (mutt_hash_insert(AddrCache, s, copy))
+    copy = NULL;
+  cache_unlock();
+
+  mutt_addr_free(&copy);
+}
+
+/**
+ * mutt_addr_parse_list - Parse a list of email addresses
+ * @param top List to append addresses
+ * @param s   String to parse
+ * @retval ptr  Top of the address list
+ * @retval NULL Error
+ *
+ * A new list is first looked up in a cache of recently parsed headers.
+ */
+struct Address *mutt_addr_parse_list(struct Address *top, const char *s)
+{
+  /* Text appended to an existing list can change its last Address */
+  bool skipped = false;
+
+  if (top || (mutt_str_strlen(s) > ADDR_CACHE_KEY_MAX))
+    return parse_list(top, s, &skipped);
+
+  struct Address *addr = addr_cache_lookup(s);
+  if (addr)
+  {
+    AddressError = 0;
+    return addr;
+  }
+
+  addr = parse_list(NULL, s, &skipped);
+  /* A bad address is skipped, but the caller will see the error */
+  if (addr && !skipped)
+    addr_cache_add(s, addr);
+
+  return addr;
+}
+
+/**
+ * mutt_addr_cache_cleanup - Empty the cache of parsed Address lists
+ */
+void mutt_addr_cache_cleanup(void)
+{
+  cache_lock();
+  mutt_hash_destroy(&AddrCache);
+  cache_unlock();
+}
+
 /**
  * mutt_addr_parse_list2 - Parse a list of email addresses
  * @param p Add to this List of Addresses
@@ -637,7 +777,8 @@ struct Address *mutt_addr_parse_list2(struct Address *p, const char *s)
 
     mutt_str_strfcpy(tmp, s, sizeof(tmp));
     char *r = tmp;
-    while ((r = strtok(r, " \t")))
+    char *save = NULL;
+    while ((r = strtok_r(r, " \t", &save)))
     {
       p = mutt_addr_parse_list(p, r);
       r = NULL;
@@ -665,6 +806,7 @@ void mutt_addr_qualify(struct Address *addr, const char *host)
     {
       char *p = mutt_mem_malloc(mutt_str_strlen(addr->mailbox) + mutt_str_strlen(host) + 2);
       sprintf(p, "%s@%s", addr->mailbox, host);
+      mutt_addr_unshare(addr);
       FREE(&addr->mailbox);
       addr->mailbox = p;
     }
@@ -956,6 +1098,7 @@ int mutt_addr_mbox_to_udomain(const char *mbox, char **user, char **domain)
  */
 void mutt_addr_set_intl(struct Address *a, char *intl_mailbox)
 {
+  mutt_addr_unshare(a);
   FREE(&a->mailbox);
   a->mailbox = intl_mailbox;
   a->intl_checked = true;
@@ -969,12 +1112,51 @@ void mutt_addr_set_intl(struct Address *a, char *intl_mailbox)
  */
 void mutt_addr_set_local(struct Address *a, char *local_mailbox)
 {
+  mutt_addr_unshare(a);
   FREE(&a->mailbox);
   a->mailbox = local_mailbox;
   a->intl_checked = true;
   a->is_intl = false;
 }
 
+/**
+ * mutt_addr_intern - Share the strings of an Address list
+ * @param addr Address list
+ *
+ * Long-lived addresses, e.g. those of the emails in a Mailbox, repeat the same
+ * names and mailboxes many times.  Interning them stores each string once.
+ *
+ * @note The strings must not be changed in place afterwards, see
+ *       mutt_addr_unshare().
+ */
+void mutt_addr_intern(struct Address *addr)
+{
+  for (; addr; addr = addr->next)
+  {
+    if (addr->interned)
+      continue;
+    mutt_str_intern(&addr->personal);
+    mutt_str_intern(&addr->mailbox);
+    addr->interned = true;
+  }
+}
+
+/**
+ * mutt_addr_unshare - Give an Address private copies of its strings
+ * @param a Address
+ *
+ * This must be called before changing the strings of an interned Address.
+ */
+void mutt_addr_unshare(struct Address *a)
+{
+  if (!a || !a->interned)
+    return;
+
+  mutt_str_intern_unshare(&a->personal);
+  mutt_str_intern_unshare(&a->mailbox);
+  a->interned = false;
+}
+
 /**
  * mutt_addr_for_display - Convert an Address for display purposes
  * @param a Address to convert
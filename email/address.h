@@ -36,6 +36,7 @@ struct Address
   bool group : 1; /**< group mailbox? */
   bool is_intl : 1;
   bool intl_checked : 1;
+  bool interned : 1; /**< personal and mailbox are shared, see mutt_addr_intern() */
   struct Address *next;
 };
 
@@ -59,6 +60,7 @@ extern const char AddressSpecials[];
 #define address_error(x) AddressErrors[x]
 
 struct Address *mutt_addr_append(struct Address **a, struct Address *b, bool prune);
+void            mutt_addr_cache_cleanup(void);
 void            mutt_addr_cat(char *buf, size_t buflen, const char *value, const char *specials);
 bool            mutt_addr_cmp(struct Address *a, struct Address *b);
 bool            mutt_addr_cmp_strict(const struct Address *a, const struct Address *b);
@@ -74,10 +76,12 @@ struct Address *mutt_addr_new(void);
 struct Address *mutt_addr_parse_list(struct Address *top, const char *s);
 struct Address *mutt_addr_parse_list2(struct Address *p, const char *s);
 void            mutt_addr_qualify(struct Address *addr, const char *host);
+void            mutt_addr_intern(struct Address *addr);
 int             mutt_addr_remove_from_list(struct Address **a, const char *mailbox);
 bool            mutt_addr_search(struct Address *a, struct Address *lst);
 void            mutt_addr_set_intl(struct Address *a, char *intl_mailbox);
 void            mutt_addr_set_local(struct Address *a, char *local_mailbox);
+void            mutt_addr_unshare(struct Address *a);
 bool            mutt_addr_valid_msgid(const char *msgid);
 size_t          mutt_addr_write(char *buf, size_t buflen, struct Address *addr, bool display);
 void            mutt_addr_write_single(char *buf, size_t buflen, struct Address *addr, bool display);
@@ -67,6 +67,7 @@ struct Email
   /* bits used for caching when searching */
   bool searched : 1;
   bool matched : 1;
+  bool excluded : 1; /**< ruled out by a server-side search prefilter */
 
   /* tells whether the attachment count is valid */
   bool attach_valid : 1;
@@ -190,6 +190,28 @@ bool mutt_env_cmp_strict(const struct Envelope *e1, const struct Envelope *e2)
   }
 }
 
+/**
+ * mutt_env_intern - Share the strings of an Envelope's Address fields
+ * @param env Envelope
+ *
+ * Run mutt_addr_intern() on each of the Address fields in the Envelope.
+ */
+void mutt_env_intern(struct Envelope *env)
+{
+  if (!env)
+    return;
+
+  mutt_addr_intern(env->return_path);
+  mutt_addr_intern(env->from);
+  mutt_addr_intern(env->to);
+  mutt_addr_intern(env->cc);
+  mutt_addr_intern(env->bcc);
+  mutt_addr_intern(env->sender);
+  mutt_addr_intern(env->reply_to);
+  mutt_addr_intern(env->mail_followup_to);
+  mutt_addr_intern(env->x_original_to);
+}
+
 /**
  * mutt_env_to_local - Convert an Envelope's Address fields to local format
  * @param e Envelope to modify
@@ -472,20 +472,187 @@ void mutt_parse_content_type(char *s, struct Body *ct)
     pc = mutt_param_get(&ct->parameter, "charset");
     if (!pc)
     {
+      char fcharset[SHORT_STRING];
       mutt_param_set(&ct->parameter, "charset",
                      (AssumedCharset && *AssumedCharset) ?
-                         (const char *) mutt_ch_get_default_charset() :
+                         mutt_ch_get_default_charset(fcharset, sizeof(fcharset)) :
                          "us-ascii");
     }
   }
 }
 
+/**
+ * enum HeaderField - Header fields understood by mutt_rfc822_parse_line()
+ */
+enum HeaderField
+{
+  HDR_UNKNOWN = 0,
+  HDR_APPARENTLY_FROM,
+  HDR_APPARENTLY_TO,
+  HDR_BCC,
+  HDR_CC,
+  HDR_CONTENT_DESCRIPTION,
+  HDR_CONTENT_DISPOSITION,
+  HDR_CONTENT_LANGUAGE,
+  HDR_CONTENT_LENGTH,
+  HDR_CONTENT_TRANSFER_ENCODING,
+  HDR_CONTENT_TYPE,
+  HDR_DATE,
+  HDR_EXPIRES,
+  HDR_FOLLOWUP_TO,
+  HDR_FROM,
+  HDR_IN_REPLY_TO,
+  HDR_LINES,
+  HDR_LIST_POST,
+  HDR_MAIL_FOLLOWUP_TO,
+  HDR_MAIL_REPLY_TO,
+  HDR_MESSAGE_ID,
+  HDR_MIME_VERSION,
+  HDR_NEWSGROUPS,
+  HDR_ORGANIZATION,
+  HDR_RECEIVED,
+  HDR_REFERENCES,
+  HDR_REPLY_TO,
+  HDR_RETURN_PATH,
+  HDR_SENDER,
+  HDR_STATUS,
+  HDR_SUBJECT,
+  HDR_SUPERSEDES,
+  HDR_TO,
+  HDR_X_COMMENT_TO,
+  HDR_X_LABEL,
+  HDR_X_ORIGINAL_TO,
+  HDR_X_STATUS,
+  HDR_XREF,
+};
+
+/**
+ * header_match - Does a header name match (ignoring case)?
+ * @param name  Header name
+ * @param match Lower-case name to compare against, of the same length
+ * @param len   Length of the name
+ * @retval true The names match
+ */
+static inline bool header_match(const char *name, const char *match, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    if (tolower((unsigned char) name[i]) != match[i])
+      return false;
+  return true;
+}
+
+/**
+ * header_lookup - Identify a header field by its name
+ * @param name Header name, e.g. "Subject"
+ * @param len  Length of the name
+ * @retval enum Field, e.g. #HDR_SUBJECT, or #HDR_UNKNOWN
+ *
+ * The length and the first letter of the name narrow it down to one or two
+ * candidates, so at most a couple of comparisons are needed.
+ */
+static enum HeaderField header_lookup(const char *name, size_t len)
+{
+  if (len < 2)
+    return HDR_UNKNOWN;
+
+/* The compiler can see the lengths of the string literals */
+#define HDR_MATCH(str, field)                                                  \
+  if ((len == sizeof(str) - 1) && header_match(name, str, len))                \
+    return field;
+
+  switch (tolower((unsigned char) name[0]))
+  {
+    case 'a':
+      HDR_MATCH("apparently-to", HDR_APPARENTLY_TO);
+      HDR_MATCH("apparently-from", HDR_APPARENTLY_FROM);
+      break;
+    case 'b':
+      HDR_MATCH("bcc", HDR_BCC);
+      break;
+    case 'c':
+      HDR_MATCH("cc", HDR_CC);
+      if ((len < 12) || !header_match(name, "content-", 8))
+        break;
+      switch (tolower((unsigned char) name[8]))
+      {
+        case 'd':
+          HDR_MATCH("content-description", HDR_CONTENT_DESCRIPTION);
+          HDR_MATCH("content-disposition", HDR_CONTENT_DISPOSITION);
+          break;
+        case 'l':
+          HDR_MATCH("content-language", HDR_CONTENT_LANGUAGE);
+          HDR_MATCH("content-length", HDR_CONTENT_LENGTH);
+          break;
+        case 't':
+          HDR_MATCH("content-type", HDR_CONTENT_TYPE);
+          HDR_MATCH("content-transfer-encoding", HDR_CONTENT_TRANSFER_ENCODING);
+          break;
+      }
+      break;
+    case 'd':
+      HDR_MATCH("date", HDR_DATE);
+      break;
+    case 'e':
+      HDR_MATCH("expires", HDR_EXPIRES);
+      break;
+    case 'f':
+      HDR_MATCH("from", HDR_FROM);
+      HDR_MATCH("followup-to", HDR_FOLLOWUP_TO);
+      break;
+    case 'i':
+      HDR_MATCH("in-reply-to", HDR_IN_REPLY_TO);
+      break;
+    case 'l':
+      HDR_MATCH("lines", HDR_LINES);
+      HDR_MATCH("list-post", HDR_LIST_POST);
+      break;
+    case 'm':
+      HDR_MATCH("message-id", HDR_MESSAGE_ID);
+      HDR_MATCH("mime-version", HDR_MIME_VERSION);
+      HDR_MATCH("mail-reply-to", HDR_MAIL_REPLY_TO);
+      HDR_MATCH("mail-followup-to", HDR_MAIL_FOLLOWUP_TO);
+      break;
+    case 'n':
+      HDR_MATCH("newsgroups", HDR_NEWSGROUPS);
+      break;
+    case 'o':
+      HDR_MATCH("organization", HDR_ORGANIZATION);
+      break;
+    case 'r':
+      HDR_MATCH("received", HDR_RECEIVED);
+      HDR_MATCH("reply-to", HDR_REPLY_TO);
+      HDR_MATCH("references", HDR_REFERENCES);
+      HDR_MATCH("return-path", HDR_RETURN_PATH);
+      break;
+    case 's':
+      HDR_MATCH("subject", HDR_SUBJECT);
+      HDR_MATCH("sender", HDR_SENDER);
+      HDR_MATCH("status", HDR_STATUS);
+      HDR_MATCH("supersedes", HDR_SUPERSEDES);
+      HDR_MATCH("supercedes", HDR_SUPERSEDES);
+      break;
+    case 't':
+      HDR_MATCH("to", HDR_TO);
+      break;
+    case 'x':
+      HDR_MATCH("xref", HDR_XREF);
+      HDR_MATCH("x-label", HDR_X_LABEL);
+      HDR_MATCH("x-status", HDR_X_STATUS);
+      HDR_MATCH("x-comment-to", HDR_X_COMMENT_TO);
+      HDR_MATCH("x-original-to", HDR_X_ORIGINAL_TO);
+      break;
+  }
+#undef HDR_MATCH
+
+  return HDR_UNKNOWN;
+}
+
 /**
  * mutt_rfc822_parse_line - Parse an email header
  * @param env       Envelope of the email
  * @param e         Email
- * @param line      Header field, env.g. 'to'
- * @param p         Header value, env.g. 'john@example.com'
+ * @param line      Header field, e.g. 'From'
+ * @param p         Header value, e.g. 'john@example.com'
  * @param user_hdrs If true, save into the Envelope's userhdrs
  * @param weed      If true, perform header weeding (filtering)
  * @param do_2047   If true, perform RFC2047 decoding of the field
@@ -499,363 +666,315 @@ int mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line,
                            char *p, bool user_hdrs, bool weed, bool do_2047)
 {
   bool matched = false;
+  const size_t linelen = strlen(line);
 
-  switch (tolower(line[0]))
+  switch (header_lookup(line, linelen))
   {
-    case 'a':
-      if (mutt_str_strcasecmp(line + 1, "pparently-to") == 0)
-      {
-        env->to = mutt_addr_parse_list(env->to, p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "pparently-from") == 0)
-      {
-        env->from = mutt_addr_parse_list(env->from, p);
-        matched = true;
-      }
+    case HDR_APPARENTLY_TO:
+      env->to = mutt_addr_parse_list(env->to, p);
+      matched = true;
       break;
 
-    case 'b':
-      if (mutt_str_strcasecmp(line + 1, "cc") == 0)
+    case HDR_APPARENTLY_FROM:
+      env->from = mutt_addr_parse_list(env->from, p);
+      matched = true;
+      break;
+
+    case HDR_BCC:
+      env->bcc = mutt_addr_parse_list(env->bcc, p);
+      matched = true;
+      break;
+
+    case HDR_CC:
+      env->cc = mutt_addr_parse_list(env->cc, p);
+      matched = true;
+      break;
+
+    case HDR_CONTENT_TYPE:
+      if (e)
+        mutt_parse_content_type(p, e->content);
+      matched = true;
+      break;
+
+    case HDR_CONTENT_LANGUAGE:
+      if (e)
+        parse_content_language(p, e->content);
+      matched = true;
+      break;
+
+    case HDR_CONTENT_TRANSFER_ENCODING:
+      if (e)
+        e->content->encoding = mutt_check_encoding(p);
+      matched = true;
+      break;
+
+    case HDR_CONTENT_LENGTH:
+      if (e)
       {
-        env->bcc = mutt_addr_parse_list(env->bcc, p);
-        matched = true;
+        e->content->length = atol(p);
+        if (e->content->length < 0)
+          e->content->length = -1;
       }
+      matched = true;
       break;
 
-    case 'c':
-      if (mutt_str_strcasecmp(line + 1, "c") == 0)
+    case HDR_CONTENT_DESCRIPTION:
+      if (e)
       {
-        env->cc = mutt_addr_parse_list(env->cc, p);
-        matched = true;
-      }
-      else if (mutt_str_strncasecmp(line + 1, "ontent-", 7) == 0)
-      {
-        if (mutt_str_strcasecmp(line + 8, "type") == 0)
-        {
-          if (e)
-            mutt_parse_content_type(p, e->content);
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 8, "language") == 0)
-        {
-          if (e)
-            parse_content_language(p, e->content);
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 8, "transfer-encoding") == 0)
-        {
-          if (e)
-            e->content->encoding = mutt_check_encoding(p);
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 8, "length") == 0)
-        {
-          if (e)
-          {
-            e->content->length = atol(p);
-            if (e->content->length < 0)
-              e->content->length = -1;
-          }
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 8, "description") == 0)
-        {
-          if (e)
-          {
-            mutt_str_replace(&e->content->description, p);
-            rfc2047_decode(&e->content->description);
-          }
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 8, "disposition") == 0)
-        {
-          if (e)
-            parse_content_disposition(p, e->content);
-          matched = true;
-        }
+        mutt_str_replace(&e->content->description, p);
+        rfc2047_decode(&e->content->description);
       }
+      matched = true;
       break;
 
-    case 'd':
-      if (mutt_str_strcasecmp("ate", line + 1) == 0)
+    case HDR_CONTENT_DISPOSITION:
+      if (e)
+        parse_content_disposition(p, e->content);
+      matched = true;
+      break;
+
+    case HDR_DATE:
+      mutt_str_replace(&env->date, p);
+      if (e)
       {
-        mutt_str_replace(&env->date, p);
-        if (e)
+        struct Tz tz;
+        e->date_sent = mutt_date_parse_date(p, &tz);
+        if (e->date_sent > 0)
         {
-          struct Tz tz;
-          e->date_sent = mutt_date_parse_date(p, &tz);
-          if (e->date_sent > 0)
-          {
-            e->zhours = tz.zhours;
-            e->zminutes = tz.zminutes;
-            e->zoccident = tz.zoccident;
-          }
+          e->zhours = tz.zhours;
+          e->zminutes = tz.zminutes;
+          e->zoccident = tz.zoccident;
         }
-        matched = true;
       }
+      matched = true;
       break;
 
-    case 'e':
-      if ((mutt_str_strcasecmp("xpires", line + 1) == 0) && e &&
-          mutt_date_parse_date(p, NULL) < time(NULL))
-      {
+    case HDR_EXPIRES:
+      if (e && mutt_date_parse_date(p, NULL) < time(NULL))
         e->expired = true;
-      }
       break;
 
-    case 'f':
-      if (mutt_str_strcasecmp("rom", line + 1) == 0)
-      {
-        env->from = mutt_addr_parse_list(env->from, p);
-        matched = true;
-      }
+    case HDR_FROM:
+      env->from = mutt_addr_parse_list(env->from, p);
+      matched = true;
+      break;
+
 #ifdef USE_NNTP
-      else if (mutt_str_strcasecmp(line + 1, "ollowup-to") == 0)
+    case HDR_FOLLOWUP_TO:
+      if (!env->followup_to)
       {
-        if (!env->followup_to)
-        {
-          mutt_str_remove_trailing_ws(p);
-          env->followup_to = mutt_str_strdup(mutt_str_skip_whitespace(p));
-        }
-        matched = true;
+        mutt_str_remove_trailing_ws(p);
+        env->followup_to = mutt_str_strdup(mutt_str_skip_whitespace(p));
       }
+      matched = true;
+      break;
 #endif
+
+    case HDR_IN_REPLY_TO:
+      mutt_list_free(&env->in_reply_to);
+      parse_references(&env->in_reply_to, p);
+      matched = true;
       break;
 
-    case 'i':
-      if (mutt_str_strcasecmp(line + 1, "n-reply-to") == 0)
+    case HDR_LINES:
+      if (e)
       {
-        mutt_list_free(&env->in_reply_to);
-        parse_references(&env->in_reply_to, p);
-        matched = true;
+        /* HACK - neomutt has, for a very short time, produced negative
+         * Lines header values.  Ignore them.
+         */
+        if (mutt_str_atoi(p, &e->lines) < 0 || (e->lines < 0))
+          e->lines = 0;
       }
+
+      matched = true;
       break;
 
-    case 'l':
-      if (mutt_str_strcasecmp(line + 1, "ines") == 0)
+    case HDR_LIST_POST:
+      /* RFC2369.  FIXME: We should ignore whitespace, but don't. */
+      if (strncmp(p, "NO", 2) != 0)
       {
-        if (e)
+        char *beg = NULL, *end = NULL;
+        for (beg = strchr(p, '<'); beg; beg = strchr(end, ','))
         {
-          /* HACK - neomutt has, for a very short time, produced negative
-           * Lines header values.  Ignore them.
-           */
-          if (mutt_str_atoi(p, &e->lines) < 0 || (e->lines < 0))
-            e->lines = 0;
-        }
+          beg++;
+          end = strchr(beg, '>');
+          if (!end)
+            break;
 
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "ist-Post") == 0)
-      {
-        /* RFC2369.  FIXME: We should ignore whitespace, but don't. */
-        if (strncmp(p, "NO", 2) != 0)
-        {
-          char *beg = NULL, *end = NULL;
-          for (beg = strchr(p, '<'); beg; beg = strchr(end, ','))
+          /* Take the first mailto URL */
+          if (url_check_scheme(beg) == U_MAILTO)
           {
-            beg++;
-            end = strchr(beg, '>');
-            if (!end)
-              break;
-
-            /* Take the first mailto URL */
-            if (url_check_scheme(beg) == U_MAILTO)
-            {
-              FREE(&env->list_post);
-              env->list_post = mutt_str_substr_dup(beg, end);
-              break;
-            }
+            FREE(&env->list_post);
+            env->list_post = mutt_str_substr_dup(beg, end);
+            break;
           }
         }
-        matched = true;
       }
+      matched = true;
       break;
 
-    case 'm':
-      if (mutt_str_strcasecmp(line + 1, "ime-version") == 0)
-      {
-        if (e)
-          e->mime = true;
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "essage-id") == 0)
-      {
-        /* We add a new "Message-ID:" when building a message */
-        FREE(&env->message_id);
-        env->message_id = mutt_extract_message_id(p, NULL);
-        matched = true;
-      }
-      else if (mutt_str_strncasecmp(line + 1, "ail-", 4) == 0)
-      {
-        if (mutt_str_strcasecmp(line + 5, "reply-to") == 0)
-        {
-          /* override the Reply-To: field */
-          mutt_addr_free(&env->reply_to);
-          env->reply_to = mutt_addr_parse_list(env->reply_to, p);
-          matched = true;
-        }
-        else if (mutt_str_strcasecmp(line + 5, "followup-to") == 0)
-        {
-          env->mail_followup_to = mutt_addr_parse_list(env->mail_followup_to, p);
-          matched = true;
-        }
-      }
+    case HDR_MIME_VERSION:
+      if (e)
+        e->mime = true;
+      matched = true;
+      break;
+
+    case HDR_MESSAGE_ID:
+      /* We add a new "Message-ID:" when building a message */
+      FREE(&env->message_id);
+      env->message_id = mutt_extract_message_id(p, NULL);
+      matched = true;
+      break;
+
+    case HDR_MAIL_REPLY_TO:
+      /* override the Reply-To: field */
+      mutt_addr_free(&env->reply_to);
+      env->reply_to = mutt_addr_parse_list(env->reply_to, p);
+      matched = true;
+      break;
+
+    case HDR_MAIL_FOLLOWUP_TO:
+      env->mail_followup_to = mutt_addr_parse_list(env->mail_followup_to, p);
+      matched = true;
       break;
 
 #ifdef USE_NNTP
-    case 'n':
-      if (mutt_str_strcasecmp(line + 1, "ewsgroups") == 0)
-      {
-        FREE(&env->newsgroups);
-        mutt_str_remove_trailing_ws(p);
-        env->newsgroups = mutt_str_strdup(mutt_str_skip_whitespace(p));
-        matched = true;
-      }
+    case HDR_NEWSGROUPS:
+      FREE(&env->newsgroups);
+      mutt_str_remove_trailing_ws(p);
+      env->newsgroups = mutt_str_strdup(mutt_str_skip_whitespace(p));
+      matched = true;
       break;
 #endif
 
-    case 'o':
+    case HDR_ORGANIZATION:
       /* field `Organization:' saves only for pager! */
-      if (mutt_str_strcasecmp(line + 1, "rganization") == 0)
-      {
-        if (!env->organization && (mutt_str_strcasecmp(p, "unknown") != 0))
-          env->organization = mutt_str_strdup(p);
-      }
+      if (!env->organization && (mutt_str_strcasecmp(p, "unknown") != 0))
+        env->organization = mutt_str_strdup(p);
       break;
 
-    case 'r':
-      if (mutt_str_strcasecmp(line + 1, "eferences") == 0)
-      {
-        mutt_list_free(&env->references);
-        parse_references(&env->references, p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "eply-to") == 0)
-      {
-        env->reply_to = mutt_addr_parse_list(env->reply_to, p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "eturn-path") == 0)
-      {
-        env->return_path = mutt_addr_parse_list(env->return_path, p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "eceived") == 0)
-      {
-        if (e && !e->received)
-        {
-          char *d = strrchr(p, ';');
+    case HDR_REFERENCES:
+      mutt_list_free(&env->references);
+      parse_references(&env->references, p);
+      matched = true;
+      break;
 
-          if (d)
-            e->received = mutt_date_parse_date(d + 1, NULL);
-        }
-      }
+    case HDR_REPLY_TO:
+      env->reply_to = mutt_addr_parse_list(env->reply_to, p);
+      matched = true;
       break;
 
-    case 's':
-      if (mutt_str_strcasecmp(line + 1, "ubject") == 0)
-      {
-        if (!env->subject)
-          env->subject = mutt_str_strdup(p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "ender") == 0)
+    case HDR_RETURN_PATH:
+      env->return_path = mutt_addr_parse_list(env->return_path, p);
+      matched = true;
+      break;
+
+    case HDR_RECEIVED:
+      if (e && !e->received)
       {
-        env->sender = mutt_addr_parse_list(env->sender, p);
-        matched = true;
+        char *d = strrchr(p, ';');
+
+        if (d)
+          e->received = mutt_date_parse_date(d + 1, NULL);
       }
-      else if (mutt_str_strcasecmp(line + 1, "tatus") == 0)
+      break;
+
+    case HDR_SUBJECT:
+      if (!env->subject)
+        env->subject = mutt_str_strdup(p);
+      matched = true;
+      break;
+
+    case HDR_SENDER:
+      env->sender = mutt_addr_parse_list(env->sender, p);
+      matched = true;
+      break;
+
+    case HDR_STATUS:
+      if (e)
       {
-        if (e)
+        while (*p)
         {
-          while (*p)
+          switch (*p)
           {
-            switch (*p)
-            {
-              case 'O':
-                e->old = MarkOld ? true : false;
-                break;
-              case 'R':
-                e->read = true;
-                break;
-              case 'r':
-                e->replied = true;
-                break;
-            }
-            p++;
+            case 'O':
+              e->old = MarkOld ? true : false;
+              break;
+            case 'R':
+              e->read = true;
+              break;
+            case 'r':
+              e->replied = true;
+              break;
           }
+          p++;
         }
-        matched = true;
       }
-      else if (((mutt_str_strcasecmp("upersedes", line + 1) == 0) ||
-                (mutt_str_strcasecmp("upercedes", line + 1) == 0)) &&
-               e)
+      matched = true;
+      break;
+
+    case HDR_SUPERSEDES:
+      if (e)
       {
         FREE(&env->supersedes);
         env->supersedes = mutt_str_strdup(p);
       }
       break;
 
-    case 't':
-      if (mutt_str_strcasecmp(line + 1, "o") == 0)
-      {
-        env->to = mutt_addr_parse_list(env->to, p);
-        matched = true;
-      }
+    case HDR_TO:
+      env->to = mutt_addr_parse_list(env->to, p);
+      matched = true;
       break;
 
-    case 'x':
-      if (mutt_str_strcasecmp(line + 1, "-status") == 0)
+    case HDR_X_STATUS:
+      if (e)
       {
-        if (e)
+        while (*p)
         {
-          while (*p)
+          switch (*p)
           {
-            switch (*p)
-            {
-              case 'A':
-                e->replied = true;
-                break;
-              case 'D':
-                e->deleted = true;
-                break;
-              case 'F':
-                e->flagged = true;
-                break;
-              default:
-                break;
-            }
-            p++;
+            case 'A':
+              e->replied = true;
+              break;
+            case 'D':
+              e->deleted = true;
+              break;
+            case 'F':
+              e->flagged = true;
+              break;
+            default:
+              break;
           }
+          p++;
         }
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "-label") == 0)
-      {
-        FREE(&env->x_label);
-        env->x_label = mutt_str_strdup(p);
-        matched = true;
       }
+      matched = true;
+      break;
+
+    case HDR_X_LABEL:
+      FREE(&env->x_label);
+      env->x_label = mutt_str_strdup(p);
+      matched = true;
+      break;
+
 #ifdef USE_NNTP
-      else if (mutt_str_strcasecmp(line + 1, "-comment-to") == 0)
-      {
-        if (!env->x_comment_to)
-          env->x_comment_to = mutt_str_strdup(p);
-        matched = true;
-      }
-      else if (mutt_str_strcasecmp(line + 1, "ref") == 0)
-      {
-        if (!env->xref)
-          env->xref = mutt_str_strdup(p);
-        matched = true;
-      }
+    case HDR_X_COMMENT_TO:
+      if (!env->x_comment_to)
+        env->x_comment_to = mutt_str_strdup(p);
+      matched = true;
+      break;
+
+    case HDR_XREF:
+      if (!env->xref)
+        env->xref = mutt_str_strdup(p);
+      matched = true;
+      break;
 #endif
-      else if (mutt_str_strcasecmp(line + 1, "-original-to") == 0)
-      {
-        env->x_original_to = mutt_addr_parse_list(env->x_original_to, p);
-        matched = true;
-      }
+
+    case HDR_X_ORIGINAL_TO:
+      env->x_original_to = mutt_addr_parse_list(env->x_original_to, p);
+      matched = true;
+      break;
 
     default:
       break;
@@ -865,7 +984,7 @@ int mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line,
   if (!matched && user_hdrs)
   {
     /* restore the original line */
-    line[strlen(line)] = ':';
+    line[linelen] = ':';
 
     if (!(weed && Weed && mutt_matches_ignore(line)))
     {
@@ -947,6 +1066,166 @@ char *mutt_rfc822_read_line(FILE *f, char *line, size_t *linelen)
   /* not reached */
 }
 
+/**
+ * mutt_rfc822_init_content - Give an Email the default RFC1521 content
+ * @param e Email
+ *
+ * This does nothing if the Email already has a Body.
+ */
+void mutt_rfc822_init_content(struct Email *e)
+{
+  if (e->content)
+    return;
+
+  e->content = mutt_body_new();
+
+  /* set the defaults from RFC1521 */
+  e->content->type = TYPE_TEXT;
+  e->content->subtype = mutt_str_strdup("plain");
+  e->content->encoding = ENC_7BIT;
+  e->content->length = -1;
+
+  /* RFC2183 says this is arbitrary */
+  e->content->disposition = DISP_INLINE;
+}
+
+/**
+ * mutt_rfc822_finish_header - Tidy up an Envelope once all its fields are parsed
+ * @param env Envelope
+ * @param e   Email
+ *
+ * Decode the RFC2047 encoded fields, find the real subject and make sure the
+ * dates are sane.  This is needed by callers that feed the fields to
+ * mutt_rfc822_parse_line() themselves, rather than via mutt_rfc822_read_header().
+ */
+void mutt_rfc822_finish_header(struct Envelope *env, struct Email *e)
+{
+  /* do RFC2047 decoding */
+  rfc2047_decode_addrlist(env->from);
+  rfc2047_decode_addrlist(env->to);
+  rfc2047_decode_addrlist(env->cc);
+  rfc2047_decode_addrlist(env->bcc);
+  rfc2047_decode_addrlist(env->reply_to);
+  rfc2047_decode_addrlist(env->mail_followup_to);
+  rfc2047_decode_addrlist(env->return_path);
+  rfc2047_decode_addrlist(env->sender);
+  rfc2047_decode_addrlist(env->x_original_to);
+
+  if (env->subject)
+  {
+    regmatch_t pmatch[1];
+
+    rfc2047_decode(&env->subject);
+
+    if (ReplyRegex && ReplyRegex->regex &&
+        (regexec(ReplyRegex->regex, env->subject, 1, pmatch, 0) == 0))
+    {
+      env->real_subj = env->subject + pmatch[0].rm_eo;
+    }
+    else
+      env->real_subj = env->subject;
+  }
+
+  if (e->received < 0)
+  {
+    mutt_debug(1, "resetting invalid received time to 0\n");
+    e->received = 0;
+  }
+
+  /* check for missing or invalid date */
+  if (e->date_sent <= 0)
+  {
+    mutt_debug(1, "no date found, using received time from msg separator\n");
+    e->date_sent = e->received;
+  }
+}
+
+/**
+ * rfc822_parse_field - Parse one unfolded header field
+ * @param env       Envelope of the email
+ * @param e         Email (optional)
+ * @param line      Header field, e.g. "Subject: Hello"
+ * @param user_hdrs If set, store user headers
+ * @param weed      If set, honor the header weed list for user headers
+ * @retval true  The field was parsed (or ignored)
+ * @retval false The line isn't a header field, i.e. the header has ended
+ */
+static bool rfc822_parse_field(struct Envelope *env, struct Email *e,
+                               char *line, bool user_hdrs, bool weed)
+{
+  char buf[LONG_STRING + 1];
+
+  char *p = strpbrk(line, ": \t");
+  if (!p || (*p != ':'))
+  {
+    char return_path[LONG_STRING];
+    time_t t;
+
+    /* some bogus MTAs will quote the original "From " line */
+    if (mutt_str_strncmp(">From ", line, 6) == 0)
+      return true; /* just ignore */
+    else if (is_from(line, return_path, sizeof(return_path), &t))
+    {
+      /* MH sometimes has the From_ line in the middle of the header! */
+      if (e && !e->received)
+        e->received = t - mutt_date_local_tz(t);
+      return true;
+    }
+
+    return false; /* end of header */
+  }
+
+  *buf = '\0';
+
+  if (mutt_replacelist_match(&SpamList, buf, sizeof(buf), line))
+  {
+    if (!mutt_regexlist_match(&NoSpamList, line))
+    {
+      /* if spam tag already exists, figure out how to amend it */
+      if (env->spam && *buf)
+      {
+        /* If SpamSeparator defined, append with separator */
+        if (SpamSeparator)
+        {
+          mutt_buffer_addstr(env->spam, SpamSeparator);
+          mutt_buffer_addstr(env->spam, buf);
+        }
+
+        /* else overwrite */
+        else
+        {
+          env->spam->dptr = env->spam->data;
+          *env->spam->dptr = '\0';
+          mutt_buffer_addstr(env->spam, buf);
+        }
+      }
+
+      /* spam tag is new, and match expr is non-empty; copy */
+      else if (!env->spam && *buf)
+      {
+        env->spam = mutt_buffer_from(buf);
+      }
+
+      /* match expr is empty; plug in null string if no existing tag */
+      else if (!env->spam)
+      {
+        env->spam = mutt_buffer_from("");
+      }
+
+      if (env->spam && env->spam->data)
+        mutt_debug(5, "spam = %s\n", env->spam->data);
+    }
+  }
+
+  *p = 0;
+  p = mutt_str_skip_email_wsp(p + 1);
+  if (!*p)
+    return true; /* skip empty header fields */
+
+  mutt_rfc822_parse_line(env, e, line, p, user_hdrs, weed, true);
+  return true;
+}
+
 /**
  * mutt_rfc822_read_header - parses an RFC822 header
  * @param f         Stream to read from
@@ -964,149 +1243,150 @@ struct Envelope *mutt_rfc822_read_header(FILE *f, struct Email *e, bool user_hdr
 {
   struct Envelope *env = mutt_env_new();
   char *line = mutt_mem_malloc(LONG_STRING);
-  char *p = NULL;
   LOFF_T loc;
   size_t linelen = LONG_STRING;
-  char buf[LONG_STRING + 1];
 
   if (e)
-  {
-    if (!e->content)
-    {
-      e->content = mutt_body_new();
-
-      /* set the defaults from RFC1521 */
-      e->content->type = TYPE_TEXT;
-      e->content->subtype = mutt_str_strdup("plain");
-      e->content->encoding = ENC_7BIT;
-      e->content->length = -1;
-
-      /* RFC2183 says this is arbitrary */
-      e->content->disposition = DISP_INLINE;
-    }
-  }
+    mutt_rfc822_init_content(e);
 
   while ((loc = ftello(f)) != -1)
   {
     line = mutt_rfc822_read_line(f, line, &linelen);
     if (*line == '\0')
       break;
-    p = strpbrk(line, ": \t");
-    if (!p || (*p != ':'))
-    {
-      char return_path[LONG_STRING];
-      time_t t;
-
-      /* some bogus MTAs will quote the original "From " line */
-      if (mutt_str_strncmp(">From ", line, 6) == 0)
-        continue; /* just ignore */
-      else if (is_from(line, return_path, sizeof(return_path), &t))
-      {
-        /* MH sometimes has the From_ line in the middle of the header! */
-        if (e && !e->received)
-          e->received = t - mutt_date_local_tz(t);
-        continue;
-      }
 
+    if (!rfc822_parse_field(env, e, line, user_hdrs, weed))
+    {
       fseeko(f, loc, SEEK_SET);
       break; /* end of header */
     }
+  }
 
-    *buf = '\0';
+  FREE(&line);
 
-    if (mutt_replacelist_match(&SpamList, buf, sizeof(buf), line))
-    {
-      if (!mutt_regexlist_match(&NoSpamList, line))
-      {
-        /* if spam tag already exists, figure out how to amend it */
-        if (env->spam && *buf)
-        {
-          /* If SpamSeparator defined, append with separator */
-          if (SpamSeparator)
-          {
-            mutt_buffer_addstr(env->spam, SpamSeparator);
-            mutt_buffer_addstr(env->spam, buf);
-          }
+  if (e)
+  {
+    e->content->hdr_offset = e->offset;
+    e->content->offset = ftello(f);
+    mutt_rfc822_finish_header(env, e);
+  }
 
-          /* else overwrite */
-          else
-          {
-            env->spam->dptr = env->spam->data;
-            *env->spam->dptr = '\0';
-            mutt_buffer_addstr(env->spam, buf);
-          }
-        }
+  return env;
+}
 
-        /* spam tag is new, and match expr is non-empty; copy */
-        else if (!env->spam && *buf)
-        {
-          env->spam = mutt_buffer_from(buf);
-        }
+/**
+ * rfc822_span_line - Unfold a header line from a buffer
+ * @param[in]     buf     Buffer containing the header
+ * @param[in]     buflen  Length of the buffer
+ * @param[in]     pos     Offset of the start of the line
+ * @param[in,out] line    Buffer for the result, may be reallocated
+ * @param[in,out] linelen Length of the result buffer
+ * @retval num Offset of the first byte after the line
+ *
+ * This behaves like mutt_rfc822_read_line(), but the lines are found using
+ * memchr() and each piece of a folded line is copied once.  An empty result
+ * means that the end of the header was reached.
+ */
+static size_t rfc822_span_line(const char *buf, size_t buflen, size_t pos,
+                               char **line, size_t *linelen)
+{
+  size_t out = 0;
 
-        /* match expr is empty; plug in null string if no existing tag */
-        else if (!env->spam)
-        {
-          env->spam = mutt_buffer_from("");
-        }
+  if ((pos >= buflen) || ISSPACE(buf[pos]))
+  {
+    /* end of headers, consume the blank line */
+    const char *eol = (pos < buflen) ? memchr(buf + pos, '\n', buflen - pos) : NULL;
+    **line = '\0';
+    return eol ? (eol - buf + 1) : buflen;
+  }
 
-        if (env->spam && env->spam->data)
-          mutt_debug(5, "spam = %s\n", env->spam->data);
-      }
+  while (true)
+  {
+    const char *eol = memchr(buf + pos, '\n', buflen - pos);
+    if (!eol)
+    {
+      /* an incomplete line at the end of the buffer is ignored */
+      **line = '\0';
+      return buflen;
+    }
+
+    size_t len = eol - (buf + pos);
+    if (*linelen < (out + len + 2))
+    {
+      *linelen = out + len + STRING;
+      mutt_mem_realloc(line, *linelen);
     }
+    memcpy(*line + out, buf + pos, len);
+    out += len;
+    pos += len + 1;
 
-    *p = 0;
-    p = mutt_str_skip_email_wsp(p + 1);
-    if (!*p)
-      continue; /* skip empty header fields */
+    /* remove trailing space */
+    while ((out > 0) && ISSPACE((*line)[out - 1]))
+      out--;
 
-    mutt_rfc822_parse_line(env, e, line, p, user_hdrs, weed, true);
+    /* check to see if the next line is a continuation line */
+    if ((pos >= buflen) || ((buf[pos] != ' ') && (buf[pos] != '\t')))
+      break;
+
+    while ((pos < buflen) && ((buf[pos] == ' ') || (buf[pos] == '\t')))
+      pos++;
+    (*line)[out++] = ' ';
   }
 
-  FREE(&line);
+  (*line)[out] = '\0';
+  return pos;
+}
+
+/**
+ * mutt_rfc822_parse_header - Parse an RFC822 header held in memory
+ * @param buf       Buffer containing the header, e.g. a memory-mapped file
+ * @param buflen    Length of the buffer
+ * @param off       Offset of the buffer within its file
+ * @param e         Header structure of current message (optional)
+ * @param user_hdrs If set, store user headers
+ * @param weed      If set, honor the header weed list for user headers
+ * @retval ptr Newly allocated envelope structure
+ *
+ * This is the equivalent of mutt_rfc822_read_header() for a header that's
+ * already in memory.  The buffer may continue past the end of the header,
+ * parsing stops at the first blank line.  The Email's content offset is set
+ * to @a off plus the length of the header.
+ *
+ * Caller should free the Envelope using mutt_env_free().
+ */
+struct Envelope *mutt_rfc822_parse_header(const char *buf, size_t buflen, LOFF_T off,
+                                          struct Email *e, bool user_hdrs, bool weed)
+{
+  struct Envelope *env = mutt_env_new();
+  char *line = mutt_mem_malloc(LONG_STRING);
+  size_t linelen = LONG_STRING;
+  size_t pos = 0;
 
   if (e)
-  {
-    e->content->hdr_offset = e->offset;
-    e->content->offset = ftello(f);
+    mutt_rfc822_init_content(e);
 
-    /* do RFC2047 decoding */
-    rfc2047_decode_addrlist(env->from);
-    rfc2047_decode_addrlist(env->to);
-    rfc2047_decode_addrlist(env->cc);
-    rfc2047_decode_addrlist(env->bcc);
-    rfc2047_decode_addrlist(env->reply_to);
-    rfc2047_decode_addrlist(env->mail_followup_to);
-    rfc2047_decode_addrlist(env->return_path);
-    rfc2047_decode_addrlist(env->sender);
-    rfc2047_decode_addrlist(env->x_original_to);
-
-    if (env->subject)
+  while (true)
+  {
+    size_t next = rfc822_span_line(buf, buflen, pos, &line, &linelen);
+    if (*line == '\0')
     {
-      regmatch_t pmatch[1];
+      pos = next;
+      break;
+    }
 
-      rfc2047_decode(&env->subject);
+    if (!rfc822_parse_field(env, e, line, user_hdrs, weed))
+      break; /* end of header */
 
-      if (ReplyRegex && ReplyRegex->regex &&
-          (regexec(ReplyRegex->regex, env->subject, 1, pmatch, 0) == 0))
-      {
-        env->real_subj = env->subject + pmatch[0].rm_eo;
-      }
-      else
-        env->real_subj = env->subject;
-    }
+    pos = next;
+  }
 
-    if (e->received < 0)
-    {
-      mutt_debug(1, "resetting invalid received time to 0\n");
-      e->received = 0;
-    }
+  FREE(&line);
 
-    /* check for missing or invalid date */
-    if (e->date_sent <= 0)
-    {
-      mutt_debug(1, "no date found, using received time from msg separator\n");
-      e->date_sent = e->received;
-    }
+  if (e)
+  {
+    e->content->hdr_offset = e->offset;
+    e->content->offset = off + pos;
+    mutt_rfc822_finish_header(env, e);
   }
 
   return env;
@@ -39,6 +39,9 @@ void             mutt_parse_content_type(char *s, struct Body *ct);
 struct Body *    mutt_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off, bool digest);
 void             mutt_parse_part(FILE *fp, struct Body *b);
 struct Body *    mutt_read_mime_header(FILE *fp, bool digest);
+void             mutt_rfc822_finish_header(struct Envelope *env, struct Email *e);
+void             mutt_rfc822_init_content(struct Email *e);
+struct Envelope *mutt_rfc822_parse_header(const char *buf, size_t buflen, LOFF_T off, struct Email *e, bool user_hdrs, bool weed);
 int              mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line, char *p, bool user_hdrs, bool weed, bool do_2047);
 struct Body *    mutt_rfc822_parse_message(FILE *fp, struct Body *parent);
 struct Envelope *mutt_rfc822_read_header(FILE *f, struct Email *e, bool user_hdrs, bool weed);
@@ -32,8 +32,8 @@
 #include <assert.h>
 #include <errno.h>
 #include <iconv.h>
-#include <regex.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include "mutt/mutt.h"
 #include "rfc2047.h"
@@ -134,44 +134,42 @@ static size_t q_encoder(char *str, const char *buf, size_t buflen, const char *t
  * @param[out] textlen    Length of the encoded text found
  * @retval ptr Start of the RFC2047 encoded word
  * @retval NULL None was found
+ *
+ * An encoded word looks like: `=?charset?encoding?encoded-text?=`
+ *
+ * The charset mustn't contain any of: `[]()<>@,;:\"/?. =`, the encoding is one
+ * of 'Q' or 'B', and the encoded text is anything except '?'.  We accept
+ * whitespace in the encoded text, as some mailers do that, see #1189.
  */
 static char *parse_encoded_word(char *str, enum ContentEncoding *enc, char **charset,
                                 size_t *charsetlen, char **text, size_t *textlen)
 {
-  static struct Regex *re = NULL;
-  regmatch_t match[4];
-  size_t nmatch = 4;
-
-  if (!re)
+  /* Most header fields don't contain any encoded words at all */
+  for (char *beg = strstr(str, "=?"); beg; beg = strstr(beg + 1, "=?"))
   {
-    re = mutt_regex_compile("=\\?"
-                            "([^][()<>@,;:\\\"/?. =]+)" /* charset */
-                            "\\?"
-                            "([qQbB])" /* encoding */
-                            "\\?"
-                            "([^?]+)" /* encoded text - we accept whitespace
-                                         as some mailers do that, see #1189. */
-                            "\\?=",
-                            REG_EXTENDED);
-    assert(re && "Something is wrong with your RE engine.");
-  }
+    char *cs = beg + 2;
+    size_t cslen = strcspn(cs, "[]()<>@,;:\\\"/?. =");
+    if ((cslen == 0) || (cs[cslen] != '?'))
+      continue;
 
-  int rc = regexec(re->regex, str, nmatch, match, 0);
-  if (rc != 0)
-    return NULL;
+    char *e = cs + cslen + 1;
+    if ((*e == '\0') || !strchr("qQbB", *e) || (e[1] != '?'))
+      continue;
 
-  /* Charset */
-  *charset = str + match[1].rm_so;
-  *charsetlen = match[1].rm_eo - match[1].rm_so;
+    char *t = e + 2;
+    size_t tlen = strcspn(t, "?");
+    if ((tlen == 0) || (t[tlen] != '?') || (t[tlen + 1] != '='))
+      continue;
 
-  /* Encoding: either Q or B */
-  *enc = ((str[match[2].rm_so] == 'Q') || (str[match[2].rm_so] == 'q')) ?
-             ENC_QUOTED_PRINTABLE :
-             ENC_BASE64;
+    *charset = cs;
+    *charsetlen = cslen;
+    *enc = ((*e == 'Q') || (*e == 'q')) ? ENC_QUOTED_PRINTABLE : ENC_BASE64;
+    *text = t;
+    *textlen = tlen;
+    return beg;
+  }
 
-  *text = str + match[3].rm_so;
-  *textlen = match[3].rm_eo - match[3].rm_so;
-  return str + match[0].rm_so;
+  return NULL;
 }
 
 /**
@@ -204,7 +202,7 @@ static size_t try_block(const char *d, size_t dlen, const char *fromcode,
 
   if (fromcode)
   {
-    iconv_t cd = mutt_ch_iconv_open(tocode, fromcode, 0);
+    iconv_t cd = mutt_ch_iconv_get(tocode, fromcode, 0);
     assert(cd != (iconv_t)(-1));
     ib = d;
     ibl = dlen;
@@ -214,11 +212,11 @@ static size_t try_block(const char *d, size_t dlen, const char *fromcode,
         iconv(cd, NULL, NULL, &ob, &obl) == (size_t)(-1))
     {
       assert(errno == E2BIG);
-      iconv_close(cd);
+      mutt_ch_iconv_release(cd);
       assert(ib > d);
       return (ib - d == dlen) ? dlen : ib - d + 1;
     }
-    iconv_close(cd);
+    mutt_ch_iconv_release(cd);
   }
   else
   {
@@ -284,7 +282,7 @@ static size_t encode_block(char *str, char *buf, size_t buflen, const char *from
     return (*encoder)(str, buf, buflen, tocode);
   }
 
-  const iconv_t cd = mutt_ch_iconv_open(tocode, fromcode, 0);
+  const iconv_t cd = mutt_ch_iconv_get(tocode, fromcode, 0);
   assert(cd != (iconv_t)(-1));
   const char *ib = buf;
   size_t ibl = buflen;
@@ -294,7 +292,7 @@ static size_t encode_block(char *str, char *buf, size_t buflen, const char *from
   const size_t n1 = iconv(cd, (ICONV_CONST char **) &ib, &ibl, &ob, &obl);
   const size_t n2 = iconv(cd, NULL, NULL, &ob, &obl);
   assert(n1 != (size_t)(-1) && n2 != (size_t)(-1));
-  iconv_close(cd);
+  mutt_ch_iconv_release(cd);
   return (*encoder)(str, tmp, ob - tmp, tocode);
 }
 
@@ -335,6 +333,115 @@ static size_t choose_block(char *d, size_t dlen, int col, const char *fromcode,
   return n;
 }
 
+/**
+ * is_printable_ascii - Is a string made up of printable ASCII characters?
+ * @param s   String to check
+ * @param len Length of the string
+ * @retval true All the characters are in the range 0x20 - 0x7e
+ *
+ * Most encoded words hold plain ASCII, so the string is checked a word at a
+ * time.  A byte fails the test if it's below 0x20, above 0x7e, or has its high
+ * bit set.
+ */
+static bool is_printable_ascii(const char *s, size_t len)
+{
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  for (; len >= sizeof(uint64_t); s += sizeof(uint64_t), len -= sizeof(uint64_t))
+  {
+    uint64_t w;
+    memcpy(&w, s, sizeof(w));
+    if (((w - 0x20 * ones) | (w + ones) | w) & highs)
+      return false;
+  }
+
+  for (; len > 0; s++, len--)
+    if ((*s < 0x20) || (*s > 0x7e))
+      return false;
+
+  return true;
+}
+
+/**
+ * is_valid_utf8 - Is a string valid UTF-8?
+ * @param s   String to check
+ * @param len Length of the string
+ * @retval true String is valid UTF-8
+ *
+ * Overlong encodings, surrogates and code points above U+10FFFF are rejected,
+ * just as iconv would.
+ */
+static bool is_valid_utf8(const char *s, size_t len)
+{
+  const unsigned char *p = (const unsigned char *) s;
+  const unsigned char *end = p + len;
+
+  while (p < end)
+  {
+    unsigned char c = *p;
+    if (c < 0x80)
+    {
+      p++;
+      continue;
+    }
+
+    size_t n;
+    unsigned char lo = 0x80, hi = 0xbf; /* range of the second byte */
+    if ((c >= 0xc2) && (c <= 0xdf))
+      n = 1;
+    else if ((c >= 0xe0) && (c <= 0xef))
+    {
+      n = 2;
+      if (c == 0xe0)
+        lo = 0xa0;
+      else if (c == 0xed)
+        hi = 0x9f;
+    }
+    else if ((c >= 0xf0) && (c <= 0xf4))
+    {
+      n = 3;
+      if (c == 0xf0)
+        lo = 0x90;
+      else if (c == 0xf4)
+        hi = 0x8f;
+    }
+    else
+      return false;
+
+    if ((size_t)(end - p) <= n)
+      return false;
+    if ((p[1] < lo) || (p[1] > hi))
+      return false;
+    for (size_t i = 2; i <= n; i++)
+      if (!CONTINUATION_BYTE(p[i]))
+        return false;
+    p += n + 1;
+  }
+
+  return true;
+}
+
+/**
+ * is_ascii_charset - Does a charset encode ASCII as ASCII?
+ * @param charset Name of the charset
+ * @retval true The ASCII characters don't need converting
+ */
+static bool is_ascii_charset(const char *charset)
+{
+  static const char *const prefixes[] = {
+    "utf-8", "utf8", "us-ascii", "ascii", "iso-8859-", "iso8859-", "latin",
+    "windows-125", "cp125", "koi8-",
+  };
+
+  for (size_t i = 0; i < mutt_array_size(prefixes); i++)
+  {
+    if (mutt_str_strncasecmp(charset, prefixes[i], strlen(prefixes[i])) == 0)
+      return true;
+  }
+  return false;
+}
+
 /**
  * finalize_chunk - Perform charset conversion and filtering
  * @param[out] res        Buffer where the resulting string is appended
@@ -342,12 +449,42 @@ static size_t choose_block(char *d, size_t dlen, int col, const char *fromcode,
  * @param[in]  charset    Charset to use for the conversion
  * @param[in]  charsetlen Length of the charset parameter
  *
- * The buffer buf is reinitialized at the end of this function.
+ * The buffer buf is emptied at the end of this function.
+ *
+ * Text that doesn't need converting is copied straight into res.  Only text
+ * that's really in a different charset is passed to iconv.
  */
 static void finalize_chunk(struct Buffer *res, struct Buffer *buf, char *charset, size_t charsetlen)
 {
+  size_t len = buf->dptr - buf->data;
   char end = charset[charsetlen];
   charset[charsetlen] = '\0';
+
+  if (!mutt_ch_charset_lookup(charset))
+  {
+    if (is_printable_ascii(buf->data, len) && is_ascii_charset(charset) &&
+        (CharsetIsUtf8 || is_ascii_charset(NONULL(Charset))))
+    {
+      /* Nothing to convert, nothing to filter */
+      charset[charsetlen] = end;
+      mutt_buffer_add(res, buf->data, len);
+      mutt_buffer_reset(buf);
+      return;
+    }
+
+    if (CharsetIsUtf8 && mutt_ch_is_utf8(charset) && is_valid_utf8(buf->data, len))
+    {
+      /* Nothing to convert, but the text still needs filtering */
+      charset[charsetlen] = end;
+      char *str = mutt_str_substr_dup(buf->data, buf->dptr);
+      mutt_mb_filter_unprintable(&str);
+      mutt_buffer_addstr(res, str);
+      FREE(&str);
+      mutt_buffer_reset(buf);
+      return;
+    }
+  }
+
   mutt_ch_convert_string(&buf->data, charset, Charset, MUTT_ICONV_HOOK_FROM);
   charset[charsetlen] = end;
   mutt_mb_filter_unprintable(&buf->data);
@@ -358,57 +495,67 @@ static void finalize_chunk(struct Buffer *res, struct Buffer *buf, char *charset
 
 /**
  * decode_word - Decode an RFC2047-encoded string
+ * @param buf Buffer for the result
  * @param s   String to decode
  * @param len Length of the string
  * @param enc Encoding type
- * @retval ptr Decoded string
+ * @retval true  Success, the decoded text has been appended to buf
+ * @retval false Error, the string isn't valid
  *
- * @note The caller must free the returned string
+ * The text is decoded straight into the Buffer.  Decoding stops at an encoded
+ * NUL character.
  */
-static char *decode_word(const char *s, size_t len, enum ContentEncoding enc)
+static bool decode_word(struct Buffer *buf, const char *s, size_t len, enum ContentEncoding enc)
 {
   const char *it = s;
   const char *end = s + len;
 
+  /* The decoded text is never longer than the encoded text */
+  size_t used = buf->dptr - buf->data;
+  mutt_buffer_increase_size(buf, used + len + 1);
+  char *out = buf->dptr;
+
   if (enc == ENC_QUOTED_PRINTABLE)
   {
-    struct Buffer buf = { 0 };
     for (; it < end; ++it)
     {
+      char c;
       if (*it == '_')
       {
-        mutt_buffer_addch(&buf, ' ');
+        c = ' ';
       }
       else if ((*it == '=') && (!(it[1] & ~127) && hexval(it[1]) != -1) &&
                (!(it[2] & ~127) && hexval(it[2]) != -1))
       {
-        mutt_buffer_addch(&buf, (hexval(it[1]) << 4) | hexval(it[2]));
+        c = (hexval(it[1]) << 4) | hexval(it[2]);
         it += 2;
       }
       else
       {
-        mutt_buffer_addch(&buf, *it);
+        c = *it;
       }
+
+      if (c == '\0')
+        break;
+      *out++ = c;
     }
-    mutt_buffer_addch(&buf, '\0');
-    return buf.data;
   }
   else if (enc == ENC_BASE64)
   {
-    const int olen = 3 * len / 4 + 1;
-    char *out = mutt_mem_malloc(olen);
-    int dlen = mutt_b64_decode(it, out, olen);
+    int dlen = mutt_b64_decode(it, out, len);
     if (dlen == -1)
-    {
-      FREE(&out);
-      return NULL;
-    }
-    out[dlen] = '\0';
-    return out;
+      return false;
+    out += strnlen(out, dlen);
+  }
+  else
+  {
+    assert(0); /* The enc parameter has an invalid value */
+    return false;
   }
 
-  assert(0); /* The enc parameter has an invalid value */
-  return NULL;
+  *out = '\0';
+  buf->dptr = out;
+  return true;
 }
 
 /**
@@ -651,6 +798,13 @@ void rfc2047_decode(char **pd)
   if (!pd || !*pd)
     return;
 
+  /* Plain text, that doesn't need converting, is left alone */
+  if (!strstr(*pd, "=?") &&
+      (!AssumedCharset || !*AssumedCharset || mutt_str_is_ascii(*pd, strlen(*pd))))
+  {
+    return;
+  }
+
   struct Buffer buf = { 0 }; /* Output buffer                          */
   char *s = *pd;             /* Read pointer                           */
   char *beg = NULL;          /* Begin of encoded word                  */
@@ -684,7 +838,7 @@ void rfc2047_decode(char **pd)
       }
 
       /* If we have some previously decoded text, add it now */
-      if (prev.data)
+      if (prev.dptr != prev.data)
       {
         finalize_chunk(&buf, &prev, prev_charset, prev_charsetlen);
       }
@@ -708,22 +862,25 @@ void rfc2047_decode(char **pd)
     if (beg)
     {
       /* Some encoded text was found */
-      text[textlen] = '\0';
-      char *decoded = decode_word(text, textlen, enc);
-      if (!decoded)
-      {
-        return;
-      }
-      if (prev.data && ((prev_charsetlen != charsetlen) ||
-                        (strncmp(prev_charset, charset, charsetlen) != 0)))
+      if ((prev.dptr != prev.data) &&
+          ((prev_charsetlen != charsetlen) ||
+           (strncmp(prev_charset, charset, charsetlen) != 0)))
       {
         /* Different charset, convert the previous chunk and add it to the
          * final result */
         finalize_chunk(&buf, &prev, prev_charset, prev_charsetlen);
       }
 
-      mutt_buffer_addstr(&prev, decoded);
-      FREE(&decoded);
+      char end = text[textlen];
+      text[textlen] = '\0';
+      bool ok = decode_word(&prev, text, textlen, enc);
+      text[textlen] = end;
+      if (!ok)
+      {
+        FREE(&buf.data);
+        FREE(&prev.data);
+        return;
+      }
       prev_charset = charset;
       prev_charsetlen = charsetlen;
       s = text + textlen + 2; /* Skip final ?= */
@@ -731,10 +888,11 @@ void rfc2047_decode(char **pd)
   }
 
   /* Save the last chunk */
-  if (prev.data)
+  if (prev.dptr != prev.data)
   {
     finalize_chunk(&buf, &prev, prev_charset, prev_charsetlen);
   }
+  FREE(&prev.data);
 
   mutt_buffer_addch(&buf, '\0');
   FREE(pd);
@@ -753,6 +911,7 @@ void rfc2047_encode_addrlist(struct Address *addr, const char *tag)
 
   while (ptr)
   {
+    mutt_addr_unshare(ptr);
     if (ptr->personal)
       rfc2047_encode(&ptr->personal, AddressSpecials, col, SendCharset);
     else if (ptr->group && ptr->mailbox)
@@ -771,10 +930,14 @@ void rfc2047_decode_addrlist(struct Address *a)
   {
     if (a->personal && ((strstr(a->personal, "=?")) || (AssumedCharset && *AssumedCharset)))
     {
+      mutt_addr_unshare(a);
       rfc2047_decode(&a->personal);
     }
     else if (a->group && a->mailbox && strstr(a->mailbox, "=?"))
+    {
+      mutt_addr_unshare(a);
       rfc2047_decode(&a->mailbox);
+    }
     a = a->next;
   }
 }
@@ -339,11 +339,14 @@ void mutt_set_flag_update(struct Context *ctx, struct Email *e, int flag, bool b
   /* if the message status has changed, we need to invalidate the cached
    * search results so that any future search will match the current status
    * of this message and not what it was at the time it was last searched.
+   * A server-side prefilter saw the old flags, too, whether or not the
+   * message has been searched since.
    */
-  if (e->searched && (changed != e->changed || deleted != ctx->deleted ||
-                      tagged != ctx->tagged || mailbox != ctx->mailbox->msg_flagged))
+  if (update || (changed != e->changed) || (deleted != ctx->deleted) ||
+      (tagged != ctx->tagged) || (mailbox != ctx->mailbox->msg_flagged))
   {
     e->searched = false;
+    e->excluded = false;
   }
 }
 
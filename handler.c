@@ -1726,9 +1726,10 @@ void mutt_decode_attachment(struct Body *b, struct State *s)
 
   if (istext && s->flags & MUTT_CHARCONV)
   {
+    char fcharset[SHORT_STRING];
     char *charset = mutt_param_get(&b->parameter, "charset");
     if (!charset && AssumedCharset && *AssumedCharset)
-      charset = mutt_ch_get_default_charset();
+      charset = mutt_ch_get_default_charset(fcharset, sizeof(fcharset));
     if (charset && Charset)
       cd = mutt_ch_iconv_open(Charset, charset, MUTT_ICONV_HOOK_FROM);
   }
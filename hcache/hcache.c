@@ -454,6 +454,79 @@ int mutt_hcache_delete(header_cache_t *hc, const char *key, size_t keylen)
   return ops->delete (hc->ctx, path, keylen);
 }
 
+/**
+ * hcache_parts_key - Get the database key of an Email's MIME parts
+ * @param hc     Header cache handle
+ * @param key    Message identification string of the Email
+ * @param keylen Length of the key
+ * @param buf    Buffer for the result
+ * @param buflen Length of the buffer
+ * @retval num Length of the database key
+ */
+static size_t hcache_parts_key(header_cache_t *hc, const char *key,
+                               size_t keylen, char *buf, size_t buflen)
+{
+  return snprintf(buf, buflen, "%s%.*s/parts", hc->folder, (int) keylen, key);
+}
+
+/**
+ * mutt_hcache_fetch_parts - Fetch the MIME parts of an Email
+ */
+void *mutt_hcache_fetch_parts(header_cache_t *hc, const char *key, size_t keylen)
+{
+  char path[PATH_MAX];
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return NULL;
+
+  keylen = hcache_parts_key(hc, key, keylen, path, sizeof(path));
+  void *data = ops->fetch(hc->ctx, path, keylen);
+  if (data && !crc_matches(data, hc->crc))
+  {
+    mutt_hcache_free(hc, &data);
+    return NULL;
+  }
+
+  return data;
+}
+
+/**
+ * mutt_hcache_store_parts - Store the MIME parts of an Email
+ */
+int mutt_hcache_store_parts(header_cache_t *hc, const char *key, size_t keylen,
+                            struct Body *parts, unsigned int uidvalidity)
+{
+  char path[PATH_MAX];
+  const struct HcacheOps *ops = hcache_get_ops();
+  int dlen;
+
+  if (!hc || !ops)
+    return -1;
+
+  keylen = hcache_parts_key(hc, key, keylen, path, sizeof(path));
+  void *data = mutt_hcache_dump_parts(hc, parts, &dlen, uidvalidity);
+  int ret = ops->store(hc->ctx, path, keylen, data, dlen);
+
+  FREE(&data);
+  return ret;
+}
+
+/**
+ * mutt_hcache_delete_parts - Delete the MIME parts of an Email
+ */
+int mutt_hcache_delete_parts(header_cache_t *hc, const char *key, size_t keylen)
+{
+  char path[PATH_MAX];
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return -1;
+
+  keylen = hcache_parts_key(hc, key, keylen, path, sizeof(path));
+  return ops->delete (hc->ctx, path, keylen);
+}
+
 /**
  * mutt_hcache_backend_list - Get a list of backend names
  * @retval ptr Comma-space-separated list of names
@@ -52,6 +52,7 @@
 #include <stddef.h>
 #include <sys/time.h>
 
+struct Body;
 struct Email;
 
 /**
@@ -156,6 +157,56 @@ void mutt_hcache_free(header_cache_t *hc, void **data);
  */
 struct Email *mutt_hcache_restore(const unsigned char *d);
 
+/**
+ * mutt_hcache_restore_parts - restore the MIME parts of an Email from the cache
+ * @param d Data retrieved using mutt_hcache_fetch_parts
+ * @retval ptr  The first MIME part
+ * @retval NULL The Email has no MIME parts
+ *
+ * @note The returned parts must be free'd by caller code with
+ *       mutt_body_free().
+ */
+struct Body *mutt_hcache_restore_parts(const unsigned char *d);
+
+/**
+ * mutt_hcache_fetch_parts - fetch the MIME parts of an Email
+ * @param hc     Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @param key    Message identification string of the Email
+ * @param keylen Length of the string pointed to by key
+ * @retval ptr  Success, the data if found and valid
+ * @retval NULL Otherwise
+ *
+ * The parts are stored apart from the header, under "<key>/parts".
+ *
+ * @note This function does not check the validity of the data found.  Pass
+ *       it to mutt_hcache_restore_parts(), then free it with
+ *       mutt_hcache_free().
+ */
+void *mutt_hcache_fetch_parts(header_cache_t *hc, const char *key, size_t keylen);
+
+/**
+ * mutt_hcache_store_parts - store the MIME parts of an Email
+ * @param hc          Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @param key         Message identification string of the Email
+ * @param keylen      Length of the string pointed to by key
+ * @param parts       First MIME part
+ * @param uidvalidity IMAP-specific UIDVALIDITY value, or 0 to use the current time
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ */
+int mutt_hcache_store_parts(header_cache_t *hc, const char *key, size_t keylen,
+                            struct Body *parts, unsigned int uidvalidity);
+
+/**
+ * mutt_hcache_delete_parts - delete the MIME parts of an Email
+ * @param hc     Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @param key    Message identification string of the Email
+ * @param keylen Length of the string pointed to by key
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ */
+int mutt_hcache_delete_parts(header_cache_t *hc, const char *key, size_t keylen);
+
 /**
  * mutt_hcache_store - store a Header along with a validity datum
  * @param hc          Pointer to the header_cache_t structure got by mutt_hcache_open
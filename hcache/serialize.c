@@ -421,10 +421,14 @@ unsigned char *serial_dump_body(struct Body *c, unsigned char *d, int *off, bool
   /* some fields are not safe to cache */
   nb.content = NULL;
   nb.charset = NULL;
+  nb.language = NULL;
   nb.next = NULL;
   nb.parts = NULL;
   nb.email = NULL;
   nb.aptr = NULL;
+  nb.unlink = false;
+  nb.tagged = false;
+  nb.deleted = false;
 
   lazy_realloc(&d, *off + sizeof(struct Body));
   memcpy(d + *off, &nb, sizeof(struct Body));
@@ -562,21 +566,132 @@ void serial_restore_envelope(struct Envelope *e, const unsigned char *d, int *of
 }
 
 /**
- * mutt_hcache_dump - Serialise a Header object
- * @param hc          Header cache handle
- * @param e           Email to serialise
- * @param off         Size of the binary blob
- * @param uidvalidity IMAP server identifier
- * @retval ptr Binary blob representing the Header
+ * serial_dump_embedded - Pack the Email of a message/rfc822 part
+ * @param e       Email to pack
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
  *
- * This function transforms a e into a char so that it is useable by
- * db_store.
+ * Only the fields that the parser sets are kept.
  */
-void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity)
+static unsigned char *serial_dump_embedded(struct Email *e, unsigned char *d,
+                                           int *off, bool convert)
 {
-  struct Email nh;
-  bool convert = !CharsetIsUtf8;
+  struct Email nh = { 0 };
+
+  nh.security = e->security;
+  nh.mime = e->mime;
+  nh.zhours = e->zhours;
+  nh.zminutes = e->zminutes;
+  nh.zoccident = e->zoccident;
+  nh.date_sent = e->date_sent;
+  nh.received = e->received;
+  nh.lines = e->lines;
+  nh.offset = e->offset;
+
+  lazy_realloc(&d, *off + sizeof(struct Email));
+  memcpy(d + *off, &nh, sizeof(struct Email));
+  *off += sizeof(struct Email);
+
+  return serial_dump_envelope(e->env, d, off, convert);
+}
+
+/**
+ * serial_restore_embedded - Unpack the Email of a message/rfc822 part
+ * @param d       Binary blob to read from
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted from utf-8
+ * @retval ptr Email, without its content
+ */
+static struct Email *serial_restore_embedded(const unsigned char *d, int *off, bool convert)
+{
+  struct Email *e = mutt_email_new();
+
+  memcpy(e, d + *off, sizeof(struct Email));
+  *off += sizeof(struct Email);
+
+  STAILQ_INIT(&e->tags);
+#ifdef MIXMASTER
+  STAILQ_INIT(&e->chain);
+#endif
 
+  e->env = mutt_env_new();
+  serial_restore_envelope(e->env, d, off, convert);
+  return e;
+}
+
+/**
+ * serial_dump_parts - Pack a tree of MIME parts into a binary blob
+ * @param b       First part
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * Each part is followed by the Email of a message/rfc822 part, if any, then
+ * its own sub-parts.
+ */
+unsigned char *serial_dump_parts(struct Body *b, unsigned char *d, int *off, bool convert)
+{
+  unsigned int count = 0;
+  for (struct Body *p = b; p; p = p->next)
+    count++;
+
+  d = serial_dump_int(count, d, off);
+
+  for (; b; b = b->next)
+  {
+    d = serial_dump_body(b, d, off, convert);
+    d = serial_dump_int(b->email ? 1 : 0, d, off);
+    if (b->email)
+      d = serial_dump_embedded(b->email, d, off, convert);
+    d = serial_dump_parts(b->parts, d, off, convert);
+  }
+
+  return d;
+}
+
+/**
+ * serial_restore_parts - Unpack a tree of MIME parts from a binary blob
+ * @param b       Store the first part here
+ * @param d       Binary blob to read from
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted from utf-8
+ */
+void serial_restore_parts(struct Body **b, const unsigned char *d, int *off, bool convert)
+{
+  unsigned int count = 0;
+  unsigned int has_email = 0;
+
+  serial_restore_int(&count, d, off);
+
+  for (; count > 0; count--)
+  {
+    *b = mutt_body_new();
+    serial_restore_body(*b, d, off, convert);
+
+    serial_restore_int(&has_email, d, off);
+    if (has_email)
+      (*b)->email = serial_restore_embedded(d, off, convert);
+
+    serial_restore_parts(&(*b)->parts, d, off, convert);
+    if ((*b)->email)
+      (*b)->email->content = (*b)->parts;
+
+    b = &(*b)->next;
+  }
+}
+
+/**
+ * hcache_dump_validate - Start a binary blob with its validity and CRC
+ * @param hc          Header cache handle
+ * @param off         Size of the binary blob
+ * @param uidvalidity IMAP server identifier, or 0 to use the current time
+ * @retval ptr Binary blob
+ */
+static unsigned char *hcache_dump_validate(header_cache_t *hc, int *off, unsigned int uidvalidity)
+{
   *off = 0;
   unsigned char *d = lazy_malloc(sizeof(union Validate));
 
@@ -590,7 +705,26 @@ void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsi
     memcpy(d, &uidvalidity, sizeof(uidvalidity));
   *off += sizeof(union Validate);
 
-  d = serial_dump_int(hc->crc, d, off);
+  return serial_dump_int(hc->crc, d, off);
+}
+
+/**
+ * mutt_hcache_dump - Serialise a Header object
+ * @param hc          Header cache handle
+ * @param e           Email to serialise
+ * @param off         Size of the binary blob
+ * @param uidvalidity IMAP server identifier
+ * @retval ptr Binary blob representing the Header
+ *
+ * This function transforms a e into a char so that it is useable by
+ * db_store.  The MIME parts aren't included, see mutt_hcache_dump_parts().
+ */
+void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity)
+{
+  struct Email nh;
+  bool convert = !CharsetIsUtf8;
+
+  unsigned char *d = hcache_dump_validate(hc, off, uidvalidity);
 
   lazy_realloc(&d, *off + sizeof(struct Email));
   memcpy(&nh, e, sizeof(struct Email));
@@ -602,6 +736,7 @@ void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsi
   nh.recip_valid = false;
   nh.searched = false;
   nh.matched = false;
+  nh.excluded = false;
   nh.collapsed = false;
   nh.limited = false;
   nh.num_hidden = 0;
@@ -662,3 +797,36 @@ struct Email *mutt_hcache_restore(const unsigned char *d)
 
   return e;
 }
+
+/**
+ * mutt_hcache_dump_parts - Serialise the MIME parts of an Email
+ * @param hc          Header cache handle
+ * @param parts       First MIME part
+ * @param off         Size of the binary blob
+ * @param uidvalidity IMAP server identifier, or 0 to use the current time
+ * @retval ptr Binary blob representing the parts
+ *
+ * The parts are stored in a record of their own, so that storing the header
+ * of an Email, e.g. after a flag change, doesn't lose them.
+ */
+void *mutt_hcache_dump_parts(header_cache_t *hc, struct Body *parts, int *off,
+                             unsigned int uidvalidity)
+{
+  unsigned char *d = hcache_dump_validate(hc, off, uidvalidity);
+  return serial_dump_parts(parts, d, off, !CharsetIsUtf8);
+}
+
+/**
+ * mutt_hcache_restore_parts - Deserialise the MIME parts of an Email
+ * @param d Binary blob
+ * @retval ptr  First MIME part
+ * @retval NULL The Email has no parts
+ */
+struct Body *mutt_hcache_restore_parts(const unsigned char *d)
+{
+  int off = sizeof(union Validate) + sizeof(unsigned int);
+  struct Body *parts = NULL;
+
+  serial_restore_parts(&parts, d, &off, !CharsetIsUtf8);
+  return parts;
+}
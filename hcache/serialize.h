@@ -46,6 +46,7 @@ unsigned char *serial_dump_char_size(char *c, unsigned char *d, int *off, ssize_
 unsigned char *serial_dump_envelope(struct Envelope *e, unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_int(unsigned int i, unsigned char *d, int *off);
 unsigned char *serial_dump_parameter(struct ParameterList *p, unsigned char *d, int *off, bool convert);
+unsigned char *serial_dump_parts(struct Body *b, unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_stailq(struct ListHead *l, unsigned char *d, int *off, bool convert);
 
 void           serial_restore_address(struct Address **a, const unsigned char *d, int *off, bool convert);
@@ -55,9 +56,12 @@ void           serial_restore_char(char **c, const unsigned char *d, int *off, b
 void           serial_restore_envelope(struct Envelope *e, const unsigned char *d, int *off, bool convert);
 void           serial_restore_int(unsigned int *i, const unsigned char *d, int *off);
 void           serial_restore_parameter(struct ParameterList *p, const unsigned char *d, int *off, bool convert);
+void           serial_restore_parts(struct Body **b, const unsigned char *d, int *off, bool convert);
 void           serial_restore_stailq(struct ListHead *l, const unsigned char *d, int *off, bool convert);
 
 void *        mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity);
+void *        mutt_hcache_dump_parts(header_cache_t *hc, struct Body *parts, int *off, unsigned int uidvalidity);
 struct Email *mutt_hcache_restore(const unsigned char *d);
+struct Body * mutt_hcache_restore_parts(const unsigned char *d);
 
 #endif /* MUTT_HCACHE_SERIALIZE_H */
@@ -52,6 +52,7 @@
 #include "message.h"
 #include "mutt_account.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_socket.h"
 #include "mx.h"
 
@@ -73,7 +74,8 @@ static const char *const Capabilities[] = {
   "AUTH=GSSAPI", "AUTH=ANONYMOUS", "AUTH=OAUTHBEARER",
   "STARTTLS",    "LOGINDISABLED",  "IDLE",
   "SASL-IR",     "ENABLE",         "CONDSTORE",
-  "QRESYNC",     "X-GM-EXT-1",     "X-GM-EXT1",
+  "QRESYNC",     "ESEARCH",        "SEARCHRES",
+  "NOTIFY",      "X-GM-EXT-1",     "X-GM-EXT1",
   NULL,
 };
 
@@ -157,6 +159,7 @@ static int cmd_queue(struct ImapAccountData *adata, const char *cmdstr, int flag
 static void cmd_handle_fatal(struct ImapAccountData *adata)
 {
   adata->status = IMAP_FATAL;
+  mutt_poll_remove(adata->conn->fd);
 
   if ((adata->state >= IMAP_SELECTED) && (adata->reopen & IMAP_REOPEN_ALLOW))
   {
@@ -208,6 +211,9 @@ static int cmd_start(struct ImapAccountData *adata, const char *cmdstr, int flag
                           (flags & IMAP_CMD_PASS) ? IMAP_LOG_PASS : IMAP_LOG_CMD);
   adata->cmdbuf->dptr = adata->cmdbuf->data;
 
+  /* the caller reads the responses from now on */
+  mutt_poll_remove(adata->conn->fd);
+
   /* unidle when command queue is flushed */
   if (adata->state == IMAP_IDLE)
     adata->state = IMAP_SELECTED;
@@ -737,6 +743,29 @@ static void cmd_parse_myrights(struct ImapAccountData *adata, const char *s)
   }
 }
 
+/**
+ * cmd_search_mark - Record a message returned by a SEARCH
+ * @param adata Imap Account data
+ * @param uid   UID of the matching message
+ *
+ * The results of a prefilter search (see imap_search()) mark the candidates
+ * for local evaluation, all other searches set the match bit directly.
+ */
+static void cmd_search_mark(struct ImapAccountData *adata, unsigned int uid)
+{
+  struct Email *e = mutt_hash_int_find(adata->uid_hash, uid);
+  if (!e)
+    return;
+
+  if (adata->cmddata && adata->cmdtype == IMAP_CT_PREFILTER)
+  {
+    e->excluded = false;
+    (*(unsigned int *) adata->cmddata)++;
+  }
+  else
+    e->matched = true;
+}
+
 /**
  * cmd_parse_search - store SEARCH response for later use
  * @param adata Imap Account data
@@ -745,7 +774,6 @@ static void cmd_parse_myrights(struct ImapAccountData *adata, const char *s)
 static void cmd_parse_search(struct ImapAccountData *adata, const char *s)
 {
   unsigned int uid;
-  struct Email *e = NULL;
 
   mutt_debug(2, "Handling SEARCH\n");
 
@@ -753,9 +781,52 @@ static void cmd_parse_search(struct ImapAccountData *adata, const char *s)
   {
     if (mutt_str_atoui(s, &uid) < 0)
       continue;
-    e = mutt_hash_int_find(adata->uid_hash, uid);
-    if (e)
-      e->matched = true;
+    cmd_search_mark(adata, uid);
+  }
+}
+
+/**
+ * cmd_parse_esearch - store ESEARCH response for later use
+ * @param adata Imap Account data
+ * @param s     Command string with search results
+ *
+ * e.g. `ESEARCH (TAG "a0005") UID ALL 4,7:11`
+ *
+ * Only the ALL return option is requested, see imap_search().
+ */
+static void cmd_parse_esearch(struct ImapAccountData *adata, char *s)
+{
+  unsigned int uid;
+
+  mutt_debug(2, "Handling ESEARCH\n");
+
+  s = imap_next_word(s);
+  /* skip the search correlator */
+  if (*s == '(')
+  {
+    s = strchr(s, ')');
+    if (!s)
+      return;
+    s = imap_next_word(s);
+  }
+
+  while (*s)
+  {
+    if (mutt_str_word_casecmp("ALL", s) == 0)
+    {
+      s = imap_next_word(s);
+      char *end = s + strcspn(s, " ");
+      char c = *end;
+      *end = '\0';
+
+      struct SeqsetIterator *iter = mutt_seqset_iterator_new(s);
+      while (mutt_seqset_iterator_next(iter, &uid) == 0)
+        cmd_search_mark(adata, uid);
+      mutt_seqset_iterator_free(&iter);
+
+      *end = c;
+    }
+    s = imap_next_word(s);
   }
 }
 
@@ -776,6 +847,7 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
   unsigned int litlen;
   short new = 0;
   short new_msg_count = 0;
+  bool has_unseen = false;
 
   char *mailbox = imap_next_word(s);
 
@@ -841,7 +913,10 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
     else if (mutt_str_strncmp("UIDVALIDITY", s, 11) == 0)
       status->uidvalidity = count;
     else if (mutt_str_strncmp("UNSEEN", s, 6) == 0)
+    {
       status->unseen = count;
+      has_unseen = true;
+    }
 
     s = value;
     if (*s && *s != ')')
@@ -851,6 +926,10 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
              status->name, status->uidvalidity, status->uidnext,
              status->messages, status->recent, status->unseen);
 
+  /* NOTIFY only promises MESSAGES and UIDNEXT, so imap_status_refresh() will
+   * have to ask for the rest */
+  status->stale = !has_unseen;
+
   /* caller is prepared to handle the result herself */
   if (adata->cmddata && adata->cmdtype == IMAP_CT_STATUS)
   {
@@ -858,6 +937,19 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
     return;
   }
 
+  /* The open mailbox keeps its own counts */
+  if (adata->mbox_name && (imap_mxcmp(mailbox, adata->mbox_name) == 0))
+    return;
+
+  /* Without UNSEEN, we can't tell if there's new mail.  Keep the old UIDNEXT,
+   * so that the refresh can. */
+  if (status->stale)
+  {
+    status->uidnext = oldun;
+    adata->status_stale = true;
+    return;
+  }
+
   mutt_debug(3, "Running default STATUS handler\n");
 
   /* should perhaps move this code back to imap_mailbox_check */
@@ -1031,6 +1123,8 @@ static int cmd_handle_untagged(struct ImapAccountData *adata)
     cmd_parse_myrights(adata, s);
   else if (mutt_str_strncasecmp("SEARCH", s, 6) == 0)
     cmd_parse_search(adata, s);
+  else if (mutt_str_strncasecmp("ESEARCH", s, 7) == 0)
+    cmd_parse_esearch(adata, s);
   else if (mutt_str_strncasecmp("STATUS", s, 6) == 0)
     cmd_parse_status(adata, s);
   else if (mutt_str_strncasecmp("ENABLED", s, 7) == 0)
@@ -1276,6 +1370,24 @@ int imap_exec(struct ImapAccountData *adata, const char *cmdstr, int flags)
   if (flags & IMAP_CMD_QUEUE)
     return 0;
 
+  return imap_cmd_wait(adata, flags);
+}
+
+/**
+ * imap_cmd_wait - Wait for the responses to the commands already sent
+ * @param adata Imap Account data
+ * @param flags Flags, e.g. #IMAP_CMD_POLL
+ * @retval  0 Success
+ * @retval -1 Failure
+ * @retval -2 OK Failure
+ *
+ * This is the second half of imap_exec().  It lets a caller send commands to
+ * several servers, with imap_cmd_start(), before waiting for any of them.
+ */
+int imap_cmd_wait(struct ImapAccountData *adata, int flags)
+{
+  int rc;
+
   if ((flags & IMAP_CMD_POLL) && (ImapPollTimeout > 0) &&
       (mutt_socket_poll(adata->conn, ImapPollTimeout)) == 0)
   {
@@ -1358,6 +1470,67 @@ void imap_cmd_finish(struct ImapAccountData *adata)
   adata->status = 0;
 }
 
+/**
+ * cmd_push_event - Read unsolicited responses as they arrive - Implements ::poll_fd_t
+ *
+ * The server pushes responses while we're IDLE, or at any time once NOTIFY
+ * is set.  They're only recorded here.  They're acted upon by imap_check(),
+ * or imap_mailbox_check(), once the UI has woken up.
+ */
+static int cmd_push_event(int fd, void *data)
+{
+  struct ImapAccountData *adata = data;
+
+  /* Don't steal the response to a command that's in progress */
+  if ((adata->state != IMAP_IDLE) && (adata->lastcmd != adata->nextcmd))
+    return -1;
+
+  if (imap_cmd_unsolicited(adata) < 0)
+    return -1;
+
+  imap_status_refresh(adata);
+  return 1;
+}
+
+/**
+ * imap_cmd_unsolicited - Read any responses the server has pushed to us
+ * @param adata Imap Account data
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * This must only be called while IDLE, or when no commands are running.
+ */
+int imap_cmd_unsolicited(struct ImapAccountData *adata)
+{
+  int rc;
+
+  while ((rc = mutt_socket_poll(adata->conn, 0)) > 0)
+  {
+    rc = imap_cmd_step(adata);
+    /* outside IDLE no command is running, so a step just returns OK */
+    if ((rc < 0) || ((adata->state == IMAP_IDLE) && (rc != IMAP_CMD_CONTINUE)))
+    {
+      mutt_debug(1, "Error reading unsolicited response\n");
+      return -1;
+    }
+  }
+
+  return (rc < 0) ? -1 : 0;
+}
+
+/**
+ * imap_cmd_watch - Read the server's unsolicited responses while we wait
+ * @param adata Imap Account data
+ *
+ * The watch lasts until the next command is sent.
+ */
+void imap_cmd_watch(struct ImapAccountData *adata)
+{
+  /* A selected mailbox that isn't IDLE is checked by imap_check() */
+  if (adata->conn && ((adata->state == IMAP_AUTHENTICATED) || (adata->state == IMAP_IDLE)))
+    mutt_poll_add(adata->conn->fd, cmd_push_event, adata);
+}
+
 /**
  * imap_cmd_idle - Enter the IDLE state
  * @param adata Imap Account data
@@ -1389,6 +1562,7 @@ int imap_cmd_idle(struct ImapAccountData *adata)
   {
     /* successfully entered IDLE state */
     adata->state = IMAP_IDLE;
+    imap_cmd_watch(adata);
     /* queue automatic exit when next command is issued */
     mutt_buffer_addstr(adata->cmdbuf, "DONE\r\n");
     rc = IMAP_CMD_OK;
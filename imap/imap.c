@@ -55,6 +55,7 @@
 #include "message.h"
 #include "mutt_account.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_socket.h"
 #include "muttlib.h"
 #include "mx.h"
@@ -509,6 +510,164 @@ static int compile_search(struct Mailbox *m, const struct Pattern *pat, struct B
   return 0;
 }
 
+/**
+ * search_needs_message - Must the messages be fetched to evaluate a Pattern?
+ * @param pat Pattern to check
+ * @retval true At least one part of the Pattern is matched against the message
+ *
+ * String matches against headers and bodies are done by the server, see
+ * do_search().  Regexes and MIME tests need the full message locally.
+ */
+static bool search_needs_message(const struct Pattern *pat)
+{
+  for (; pat; pat = pat->next)
+  {
+    switch (pat->op)
+    {
+      case MUTT_BODY:
+      case MUTT_HEADER:
+      case MUTT_WHOLE_MSG:
+        if (!pat->stringmatch)
+          return true;
+        break;
+      case MUTT_MIMEATTACH:
+      case MUTT_MIMETYPE:
+        return true;
+      default:
+        if (pat->child && search_needs_message(pat->child))
+          return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * compile_prefilter_term - Convert one Pattern to a looser IMAP search key
+ * @param m   Mailbox
+ * @param pat Pattern to convert
+ * @param buf Buffer for result
+ * @retval true  A search key was added to buf
+ * @retval false The Pattern can't be narrowed by the server
+ *
+ * The search key must match every message that pat matches locally, but may
+ * match more.  The local evaluation makes the final decision.
+ */
+static bool compile_prefilter_term(struct Mailbox *m, const struct Pattern *pat,
+                                   struct Buffer *buf)
+{
+  char term[STRING];
+  const char *key = NULL;
+
+  switch (pat->op)
+  {
+    case MUTT_FLAG:
+      key = "FLAGGED";
+      break;
+    case MUTT_DELETED:
+      key = "DELETED";
+      break;
+    case MUTT_REPLIED:
+      key = "ANSWERED";
+      break;
+    case MUTT_READ:
+      key = "SEEN";
+      break;
+    case MUTT_UNREAD:
+      key = "UNSEEN";
+      break;
+    case MUTT_DATE:
+    case MUTT_DATE_RECEIVED:
+    {
+      if (pat->not)
+        return false;
+
+      /* The server compares dates without the time or timezone,
+       * so widen the range by a day on either side */
+      bool sent = (pat->op == MUTT_DATE);
+      bool added = false;
+      if (pat->min > 2 * 86400)
+      {
+        mutt_date_make_imap_search(term, sizeof(term), (time_t) pat->min - 86400);
+        mutt_buffer_addstr(buf, sent ? " SENTSINCE " : " SINCE ");
+        mutt_buffer_addstr(buf, term);
+        added = true;
+      }
+      if ((time_t) pat->max < time(NULL))
+      {
+        mutt_date_make_imap_search(term, sizeof(term), (time_t) pat->max + 2 * 86400);
+        mutt_buffer_addstr(buf, sent ? " SENTBEFORE " : " BEFORE ");
+        mutt_buffer_addstr(buf, term);
+        added = true;
+      }
+      return added;
+    }
+    case MUTT_SIZE:
+      /* Once a message has been fetched its local size only covers the body,
+       * so only the lower bound is safe to send to the server */
+      if (pat->not || (pat->min < 1))
+        return false;
+      snprintf(term, sizeof(term), " LARGER %d", pat->min - 1);
+      mutt_buffer_addstr(buf, term);
+      return true;
+    case MUTT_FROM:
+    case MUTT_TO:
+    case MUTT_CC:
+    case MUTT_RECIPIENT:
+      if (pat->not || !pat->stringmatch || pat->groupmatch || pat->isalias || pat->alladdr)
+        return false;
+      imap_quote_string(term, sizeof(term), pat->p.str, false);
+      if (pat->op == MUTT_FROM)
+        mutt_buffer_addstr(buf, " FROM ");
+      else if (pat->op == MUTT_TO)
+        mutt_buffer_addstr(buf, " TO ");
+      else if (pat->op == MUTT_CC)
+        mutt_buffer_addstr(buf, " CC ");
+      else
+      {
+        mutt_buffer_addstr(buf, " OR TO ");
+        mutt_buffer_addstr(buf, term);
+        mutt_buffer_addstr(buf, " CC ");
+      }
+      mutt_buffer_addstr(buf, term);
+      return true;
+    default:
+      return false;
+  }
+
+  /* Unsynced local changes mean that the server's flags are out of date */
+  if (m->changed)
+    return false;
+
+  mutt_buffer_addstr(buf, pat->not ? " NOT " : " ");
+  mutt_buffer_addstr(buf, key);
+  return true;
+}
+
+/**
+ * compile_prefilter - Build an IMAP search that narrows down a Pattern
+ * @param m   Mailbox
+ * @param pat Pattern to convert
+ * @param buf Buffer for result
+ * @retval num Number of search keys added to buf
+ *
+ * Only the top-level conjuncts of the Pattern are considered.  Any message
+ * that the server doesn't return can't match the Pattern as a whole.
+ */
+static int compile_prefilter(struct Mailbox *m, const struct Pattern *pat, struct Buffer *buf)
+{
+  int terms = 0;
+
+  if ((pat->op != MUTT_AND) || pat->not)
+    return compile_prefilter_term(m, pat, buf);
+
+  for (pat = pat->child; pat; pat = pat->next)
+    if (compile_prefilter_term(m, pat, buf))
+      terms++;
+
+  return terms;
+}
+
 /**
  * longest_common_prefix - Find longest prefix common to two strings
  * @param dest  Destination buffer
@@ -1179,9 +1338,12 @@ void imap_close_connection(struct ImapAccountData *adata)
 {
   if (adata->state != IMAP_DISCONNECTED)
   {
+    mutt_poll_remove(adata->conn->fd);
     mutt_socket_close(adata->conn);
     adata->state = IMAP_DISCONNECTED;
   }
+  adata->notify = false;
+  FREE(&adata->notify_mboxes);
   adata->seqno = false;
   adata->nextcmd = false;
   adata->lastcmd = false;
@@ -1487,6 +1649,9 @@ int imap_check(struct ImapAccountData *adata, bool force)
     return -1;
   }
 
+  /* the NOOP or IDLE may have brought pushes about other mailboxes */
+  imap_status_refresh(adata);
+
   /* We call this even when we haven't run NOOP in case we have pending
    * changes to process, since we can reopen here. */
   imap_cmd_finish(adata);
@@ -1503,6 +1668,144 @@ int imap_check(struct ImapAccountData *adata, bool force)
   return result;
 }
 
+/**
+ * check_mailbox_conn - Get the connection for a mailbox that's being checked
+ * @param[in]  m      Mailbox
+ * @param[out] adata  Imap Account data
+ * @param[out] buf    Buffer for the mailbox name
+ * @param[in]  buflen Length of the buffer
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The Account's connection is reused between checks, so that the server can
+ * keep us up to date, see notify_set().
+ */
+static int check_mailbox_conn(struct Mailbox *m, struct ImapAccountData **adata,
+                              char *buf, size_t buflen)
+{
+  struct ImapMbox mx;
+
+  *adata = imap_adata_get(m);
+  if (!*adata)
+    return get_mailbox(m->path, adata, buf, buflen);
+
+  if (imap_parse_path(m->path, &mx))
+  {
+    mutt_debug(1, "Error parsing %s\n", m->path);
+    return -1;
+  }
+
+  if ((*adata)->state < IMAP_AUTHENTICATED)
+  {
+    if (ImapPassive)
+    {
+      FREE(&mx.mbox);
+      return -1;
+    }
+
+    if (!(*adata)->conn)
+      (*adata)->conn = mutt_conn_new(&mx.account);
+    mutt_account_hook(m->realpath);
+    if (!(*adata)->conn || (imap_conn_find2(*adata) < 0))
+    {
+      FREE(&mx.mbox);
+      return -1;
+    }
+  }
+
+  imap_fix_path(*adata, mx.mbox, buf, buflen);
+  if (!*buf)
+    mutt_str_strfcpy(buf, "INBOX", buflen);
+  FREE(&mx.mbox);
+
+  return 0;
+}
+
+/**
+ * struct ImapCheck - The mailboxes to check on one server
+ */
+struct ImapCheck
+{
+  struct ImapAccountData *adata;
+  struct ListHead mboxes; ///< Names of the mailboxes to STATUS
+  struct Buffer *watch;   ///< Munged names of all the mailboxes, for NOTIFY
+  bool queued;            ///< STATUS commands have been queued
+};
+
+/**
+ * notify_set - Ask the server to tell us about changes to mailboxes
+ * @param adata  Imap Account data
+ * @param mboxes Munged mailbox names, separated by spaces
+ * @retval true The mailboxes weren't being watched before
+ *
+ * The command is only sent if the list of mailboxes has changed.  If the
+ * server refuses, we'll carry on polling.
+ */
+static bool notify_set(struct ImapAccountData *adata, const char *mboxes)
+{
+  if (adata->notify_mboxes && (mutt_str_strcmp(adata->notify_mboxes, mboxes) == 0))
+    return false;
+
+  struct Buffer *cmd = mutt_buffer_pool_get();
+  mutt_buffer_printf(cmd,
+                     "NOTIFY SET (SELECTED (MessageNew MessageExpunge FlagChange)) "
+                     "(MAILBOXES (%s) (MessageNew MessageExpunge FlagChange))",
+                     mboxes);
+  adata->notify = (imap_exec(adata, cmd->data, IMAP_CMD_FAIL_OK | IMAP_CMD_POLL) == 0);
+  mutt_buffer_pool_release(&cmd);
+
+  mutt_str_replace(&adata->notify_mboxes, mboxes);
+  mutt_debug(2, "NOTIFY %s on %s\n", adata->notify ? "set" : "refused",
+             adata->conn->account.host);
+  return true;
+}
+
+/**
+ * imap_status_refresh - Ask for the counts that a NOTIFY push left out
+ * @param adata Imap Account data
+ *
+ * A pushed STATUS only promises MESSAGES and UIDNEXT.  Without UNSEEN, we
+ * can't tell if there's new mail, so ask for it now, rather than waiting for
+ * the next imap_mailbox_check().
+ *
+ * This must only be called when no commands are running.
+ */
+void imap_status_refresh(struct ImapAccountData *adata)
+{
+  char command[LONG_STRING * 2];
+  char munged[LONG_STRING];
+  bool queued = false;
+
+  if (!adata->status_stale)
+    return;
+  adata->status_stale = false;
+
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, &adata->mboxcache, entries)
+  {
+    struct ImapStatus *status = (struct ImapStatus *) np->data;
+    if (!status->stale)
+      continue;
+
+    /* The open mailbox keeps its own counts */
+    if (adata->mbox_name && (imap_mxcmp(status->name, adata->mbox_name) == 0))
+      continue;
+
+    imap_munge_mbox_name(adata, munged, sizeof(munged), status->name);
+    snprintf(command, sizeof(command),
+             "STATUS %s (UIDNEXT UIDVALIDITY UNSEEN RECENT MESSAGES)", munged);
+    if (imap_exec(adata, command, IMAP_CMD_QUEUE | IMAP_CMD_POLL) < 0)
+    {
+      mutt_debug(1, "Error queueing command\n");
+      return;
+    }
+    queued = true;
+  }
+
+  if (queued && (imap_exec(adata, NULL, IMAP_CMD_POLL) < 0))
+    mutt_debug(1, "Error refreshing STATUS\n");
+}
+
 /**
  * imap_mailbox_check - Check for new mail in subscribed folders
  * @param check_stats Check for message stats too
@@ -1510,12 +1813,19 @@ int imap_check(struct ImapAccountData *adata, bool force)
  * @retval 0   Failure
  *
  * Given a list of mailboxes rather than called once for each so that it can
- * batch the commands and save on round trips.
+ * batch the commands and save on round trips.  The STATUS commands are sent to
+ * every server before waiting for any replies, so the servers work on them in
+ * parallel.
+ *
+ * If a server supports NOTIFY (RFC5465), it's asked to push changes to the
+ * mailboxes instead.  Then, STATUS is only needed when the push didn't
+ * include the counts.
  */
 int imap_mailbox_check(bool check_stats)
 {
   struct ImapAccountData *adata = NULL;
-  struct ImapAccountData *lastdata = NULL;
+  struct ImapCheck *checks = NULL;
+  size_t num_checks = 0;
   char name[LONG_STRING];
   char command[LONG_STRING * 2];
   char munged[LONG_STRING];
@@ -1534,13 +1844,37 @@ int imap_mailbox_check(bool check_stats)
     if (np->m->magic != MUTT_IMAP)
       continue;
 
-    // XXX redundant if we already have adata
-    if (get_mailbox(np->m->path, &adata, name, sizeof(name)) < 0)
+    if (check_mailbox_conn(np->m, &adata, name, sizeof(name)) < 0)
     {
       np->m->has_new = false;
       continue;
     }
 
+    if (!mutt_bit_isset(adata->capabilities, IMAP4REV1) &&
+        !mutt_bit_isset(adata->capabilities, STATUS))
+    {
+      mutt_debug(2, "Server doesn't support STATUS\n");
+      continue;
+    }
+
+    size_t i;
+    for (i = 0; (i < num_checks) && (checks[i].adata != adata); i++)
+      ;
+    if (i == num_checks)
+    {
+      mutt_mem_realloc(&checks, (num_checks + 1) * sizeof(*checks));
+      checks[i].adata = adata;
+      STAILQ_INIT(&checks[i].mboxes);
+      checks[i].watch = mutt_buffer_new();
+      checks[i].queued = false;
+      num_checks++;
+    }
+
+    imap_munge_mbox_name(adata, munged, sizeof(munged), name);
+    if (checks[i].watch->dptr != checks[i].watch->data)
+      mutt_buffer_addch(checks[i].watch, ' ');
+    mutt_buffer_addstr(checks[i].watch, munged);
+
     /* Don't issue STATUS on the selected mailbox, it will be NOOPed or
      * IDLEd elsewhere.
      * adata->mailbox may be NULL for connections other than the current
@@ -1551,50 +1885,85 @@ int imap_mailbox_check(bool check_stats)
       continue;
     }
 
-    if (!mutt_bit_isset(adata->capabilities, IMAP4REV1) &&
-        !mutt_bit_isset(adata->capabilities, STATUS))
+    mutt_list_insert_tail(&checks[i].mboxes, mutt_str_strdup(name));
+  }
+
+  for (size_t i = 0; i < num_checks; i++)
+  {
+    adata = checks[i].adata;
+
+    bool all = true;
+    if (mutt_bit_isset(adata->capabilities, NOTIFY))
     {
-      mutt_debug(2, "Server doesn't support STATUS\n");
-      continue;
+      /* catch up with what the server has already pushed */
+      if ((adata->state != IMAP_SELECTED) && (imap_cmd_unsolicited(adata) < 0))
+        continue;
+      all = notify_set(adata, checks[i].watch->data) || !adata->notify;
     }
 
-    if (lastdata && (adata != lastdata))
+    struct ListNode *ln = NULL;
+    STAILQ_FOREACH(ln, &checks[i].mboxes, entries)
     {
-      /* Send commands to previous server. Sorting the mailbox list
-       * may prevent some infelicitous interleavings */
-      if (imap_exec(lastdata, NULL, IMAP_CMD_FAIL_OK | IMAP_CMD_POLL) == -1)
-        mutt_debug(1, "#1 Error polling mailboxes\n");
+      if (!all)
+      {
+        struct ImapStatus *status = imap_mboxcache_get(adata, ln->data, false);
+        if (status && !status->stale)
+          continue;
+      }
 
-      lastdata = NULL;
+      imap_munge_mbox_name(adata, munged, sizeof(munged), ln->data);
+      if (check_stats)
+      {
+        snprintf(command, sizeof(command),
+                 "STATUS %s (UIDNEXT UIDVALIDITY UNSEEN RECENT MESSAGES)", munged);
+      }
+      else
+      {
+        snprintf(command, sizeof(command),
+                 "STATUS %s (UIDNEXT UIDVALIDITY UNSEEN RECENT)", munged);
+      }
+
+      if (imap_exec(adata, command, IMAP_CMD_QUEUE | IMAP_CMD_POLL) < 0)
+      {
+        mutt_debug(1, "Error queueing command\n");
+        break;
+      }
+      checks[i].queued = true;
     }
+  }
 
-    if (!lastdata)
-      lastdata = adata;
+  /* Send the commands to every server, then collect the replies */
+  for (size_t i = 0; i < num_checks; i++)
+  {
+    if (!checks[i].queued)
+      continue;
 
-    imap_munge_mbox_name(adata, munged, sizeof(munged), name);
-    if (check_stats)
+    /* imap_cmd_start() only buffers the commands */
+    if ((imap_cmd_start(checks[i].adata, NULL) < 0) ||
+        (mutt_socket_flush(checks[i].adata->conn) < 0))
     {
-      snprintf(command, sizeof(command),
-               "STATUS %s (UIDNEXT UIDVALIDITY UNSEEN RECENT MESSAGES)", munged);
-    }
-    else
-    {
-      snprintf(command, sizeof(command),
-               "STATUS %s (UIDNEXT UIDVALIDITY UNSEEN RECENT)", munged);
+      mutt_debug(1, "Error sending STATUS to %s\n", checks[i].adata->conn->account.host);
+      checks[i].queued = false;
     }
+  }
 
-    if (imap_exec(adata, command, IMAP_CMD_QUEUE | IMAP_CMD_POLL) < 0)
+  for (size_t i = 0; i < num_checks; i++)
+  {
+    adata = checks[i].adata;
+    if (checks[i].queued &&
+        (imap_cmd_wait(adata, IMAP_CMD_FAIL_OK | IMAP_CMD_POLL) == -1))
     {
-      mutt_debug(1, "Error queueing command\n");
-      return 0;
+      mutt_debug(1, "Error polling mailboxes on %s\n", adata->conn->account.host);
     }
-  }
 
-  if (lastdata && (imap_exec(lastdata, NULL, IMAP_CMD_FAIL_OK | IMAP_CMD_POLL) == -1))
-  {
-    mutt_debug(1, "#2 Error polling mailboxes\n");
-    return 0;
+    /* listen for the server's pushes while we wait for the user */
+    if (adata->notify)
+      imap_cmd_watch(adata);
+
+    mutt_list_free(&checks[i].mboxes);
+    mutt_buffer_free(&checks[i].watch);
   }
+  FREE(&checks);
 
   /* collect results */
   STAILQ_FOREACH(np, &AllMailboxes, entries)
@@ -1701,7 +2070,10 @@ struct ImapStatus *imap_mboxcache_get(struct ImapAccountData *adata,
   }
 
 #ifdef USE_HCACHE
-  header_cache_t *hc = imap_hcache_open(adata, mbox);
+  /* don't open the selected mailbox's header cache twice */
+  bool selected = adata->hcache && adata->mbox_name &&
+                  (imap_mxcmp(mbox, adata->mbox_name) == 0);
+  header_cache_t *hc = selected ? adata->hcache : imap_hcache_open(adata, mbox);
   if (hc)
   {
     void *uidvalidity = mutt_hcache_fetch_raw(hc, "/UIDVALIDITY", 12);
@@ -1714,7 +2086,8 @@ struct ImapStatus *imap_mboxcache_get(struct ImapAccountData *adata,
         mutt_hcache_free(hc, &uidvalidity);
         mutt_hcache_free(hc, &uidnext);
         mutt_hcache_free(hc, (void **) &modseq);
-        mutt_hcache_close(hc);
+        if (!selected)
+          mutt_hcache_close(hc);
         return imap_mboxcache_get(adata, mbox, true);
       }
       status->uidvalidity = *(unsigned int *) uidvalidity;
@@ -1726,7 +2099,8 @@ struct ImapStatus *imap_mboxcache_get(struct ImapAccountData *adata,
     mutt_hcache_free(hc, &uidvalidity);
     mutt_hcache_free(hc, &uidnext);
     mutt_hcache_free(hc, (void **) &modseq);
-    mutt_hcache_close(hc);
+    if (!selected)
+      mutt_hcache_close(hc);
   }
 #endif
 
@@ -1762,14 +2136,70 @@ int imap_search(struct Mailbox *m, const struct Pattern *pat)
 {
   struct Buffer buf;
   struct ImapAccountData *adata = imap_adata_get(m);
+  bool esearch = mutt_bit_isset(adata->capabilities, ESEARCH);
+  bool saved = false;
+
   for (int i = 0; i < m->msg_count; i++)
+  {
     m->hdrs[i]->matched = false;
+    m->hdrs[i]->excluded = false;
+  }
+
+  mutt_buffer_init(&buf);
+
+  /* Let the server rule out messages before we download them */
+  if (search_needs_message(pat))
+  {
+    struct Buffer terms;
+    mutt_buffer_init(&terms);
+    if (compile_prefilter(m, pat, &terms) > 0)
+    {
+      unsigned int candidates = 0;
+      bool searchres = mutt_bit_isset(adata->capabilities, SEARCHRES);
+
+      mutt_buffer_addstr(&buf, "UID SEARCH");
+      if (searchres)
+        mutt_buffer_addstr(&buf, " RETURN (SAVE ALL)");
+      else if (esearch)
+        mutt_buffer_addstr(&buf, " RETURN (ALL)");
+      mutt_buffer_addstr(&buf, terms.data);
+
+      for (int i = 0; i < m->msg_count; i++)
+        m->hdrs[i]->excluded = true;
+
+      adata->cmdtype = IMAP_CT_PREFILTER;
+      adata->cmddata = &candidates;
+      int rc = imap_exec(adata, buf.data, IMAP_CMD_FAIL_OK);
+      adata->cmddata = NULL;
+
+      if (rc == 0)
+      {
+        mutt_debug(2, "prefilter left %u of %d messages\n", candidates, m->msg_count);
+        saved = searchres;
+      }
+      else
+      {
+        /* Not fatal, everything will be searched locally */
+        for (int i = 0; i < m->msg_count; i++)
+          m->hdrs[i]->excluded = false;
+      }
+      mutt_buffer_reset(&buf);
+    }
+    FREE(&terms.data);
+  }
 
   if (do_search(pat, 1) == 0)
+  {
+    FREE(&buf.data);
     return 0;
+  }
 
-  mutt_buffer_init(&buf);
   mutt_buffer_addstr(&buf, "UID SEARCH ");
+  if (esearch)
+    mutt_buffer_addstr(&buf, "RETURN (ALL) ");
+  /* Every message matching pat is in the saved result, see compile_prefilter() */
+  if (saved)
+    mutt_buffer_addstr(&buf, "UID $ ");
   if (compile_search(m, pat, &buf) < 0)
   {
     FREE(&buf.data);
@@ -2796,6 +3226,9 @@ static int imap_mbox_close(struct Context *ctx)
     }
 
     mutt_bcache_close(&adata->bcache);
+#ifdef USE_HCACHE
+    imap_hcache_close(adata);
+#endif
   }
 
   return 0;
@@ -2984,6 +3417,43 @@ static int imap_tags_commit(struct Context *ctx, struct Email *e, char *buf)
   return 0;
 }
 
+/**
+ * imap_msg_save_parts - Save a message's MIME parts to the header cache - Implements MxOps::msg_save_parts()
+ */
+static int imap_msg_save_parts(struct Context *ctx, struct Email *e)
+{
+  int rc = 0;
+#ifdef USE_HCACHE
+  struct ImapAccountData *adata = imap_adata_get(ctx->mailbox);
+  if (!adata || (adata->mailbox != ctx->mailbox))
+    return -1;
+
+  /* keep the header cache open, it's closed with the mailbox */
+  if (!adata->hcache)
+    adata->hcache = imap_hcache_open(adata, NULL);
+  rc = imap_hcache_put_parts(adata, e);
+#endif
+  return rc;
+}
+
+/**
+ * imap_msg_load_parts - Load a message's MIME parts from the header cache - Implements MxOps::msg_load_parts()
+ */
+static int imap_msg_load_parts(struct Context *ctx, struct Email *e)
+{
+#ifdef USE_HCACHE
+  struct ImapAccountData *adata = imap_adata_get(ctx->mailbox);
+  if (!adata || (adata->mailbox != ctx->mailbox))
+    return -1;
+
+  /* keep the header cache open, it's closed with the mailbox */
+  if (!adata->hcache)
+    adata->hcache = imap_hcache_open(adata, NULL);
+  e->content->parts = imap_hcache_get_parts(adata, imap_edata_get(e)->uid);
+#endif
+  return e->content->parts ? 0 : -1;
+}
+
 /**
  * imap_path_probe - Is this an IMAP mailbox? - Implements MxOps::path_probe()
  */
@@ -3083,6 +3553,8 @@ struct MxOps mx_imap_ops = {
   .msg_commit       = imap_msg_commit,
   .msg_close        = imap_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = imap_msg_save_parts,
+  .msg_load_parts   = imap_msg_load_parts,
   .tags_edit        = imap_tags_edit,
   .tags_commit      = imap_tags_commit,
   .path_probe       = imap_path_probe,
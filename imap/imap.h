@@ -117,6 +117,8 @@ void imap_pretty_mailbox(char *path, const char *folder);
 
 int imap_wait_keepalive(pid_t pid);
 void imap_keepalive(void);
+time_t imap_keepalive_due(void);
+int imap_keepalive_timer(void);
 
 void imap_get_parent_path(const char *path, char *buf, size_t buflen);
 void imap_clean_path(char *path, size_t plen);
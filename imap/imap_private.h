@@ -34,6 +34,7 @@
 #include "hcache/hcache.h"
 #endif
 
+struct Body;
 struct Context;
 struct Email;
 struct ImapEmailData;
@@ -139,6 +140,9 @@ enum ImapCaps
   ENABLE,                /**< RFC5161 */
   CONDSTORE,             /**< RFC7162 */
   QRESYNC,               /**< RFC7162 */
+  ESEARCH,               /**< RFC4731: SEARCH RETURN options */
+  SEARCHRES,             /**< RFC5182: Referencing the last SEARCH result */
+  NOTIFY,                /**< RFC5465: Notification of mailbox events */
   X_GM_EXT1,             /**< https://developers.google.com/gmail/imap/imap-extensions */
   X_GM_ALT1 = X_GM_EXT1, /**< Alternative capability string */
 
@@ -171,6 +175,7 @@ struct ImapStatus
   unsigned int uidvalidity;
   unsigned int unseen;
   unsigned long long modseq;  /* Used by CONDSTORE. 1 <= modseq < 2^63 */
+  bool stale;                 /* NOTIFY reported a change, without the UNSEEN count */
 };
 
 /**
@@ -200,7 +205,8 @@ enum ImapCommandType
 {
   IMAP_CT_NONE = 0,
   IMAP_CT_LIST,
-  IMAP_CT_STATUS
+  IMAP_CT_STATUS,
+  IMAP_CT_PREFILTER
 };
 
 /**
@@ -233,6 +239,9 @@ struct ImapAccountData
 
   bool unicode; /* If true, we can send UTF-8, and the server will use UTF8 rather than mUTF7 */
   bool qresync; /* true, if QRESYNC is successfully ENABLE'd */
+  bool notify;  /* true, if NOTIFY SET is watching notify_mboxes */
+  char *notify_mboxes; /* mailbox list of the last NOTIFY SET */
+  bool status_stale; /* a pushed STATUS lacked UNSEEN, see imap_status_refresh() */
 
   /* if set, the response parser will store results for complicated commands
    * here. */
@@ -295,12 +304,14 @@ int imap_check(struct ImapAccountData *adata, bool force);
 int imap_create_mailbox(struct ImapAccountData *adata, char *mailbox);
 int imap_rename_mailbox(struct ImapAccountData *adata, struct ImapMbox *mx, const char *newname);
 struct ImapStatus *imap_mboxcache_get(struct ImapAccountData *adata, const char *mbox, bool create);
+void imap_status_refresh(struct ImapAccountData *adata);
 void imap_mboxcache_free(struct ImapAccountData *adata);
 int imap_exec_msgset(struct ImapAccountData *adata, const char *pre, const char *post,
                      int flag, bool changed, bool invert);
 int imap_open_connection(struct ImapAccountData *adata);
 void imap_close_connection(struct ImapAccountData *adata);
 struct ImapAccountData *imap_conn_find(const struct ConnAccount *account, int flags);
+int imap_conn_find2(struct ImapAccountData *adata);
 int imap_read_literal(FILE *fp, struct ImapAccountData *adata, unsigned long bytes, struct Progress *pbar);
 void imap_expunge_mailbox(struct ImapAccountData *adata);
 void imap_logout(struct ImapAccountData **adata);
@@ -317,7 +328,10 @@ void imap_cmd_finish(struct ImapAccountData *adata);
 bool imap_code(const char *s);
 const char *imap_cmd_trailer(struct ImapAccountData *adata);
 int imap_exec(struct ImapAccountData *adata, const char *cmdstr, int flags);
+int imap_cmd_wait(struct ImapAccountData *adata, int flags);
 int imap_cmd_idle(struct ImapAccountData *adata);
+void imap_cmd_watch(struct ImapAccountData *adata);
+int imap_cmd_unsolicited(struct ImapAccountData *adata);
 
 /* message.c */
 void imap_edata_free(void **ptr);
@@ -338,7 +352,9 @@ struct ImapAccountData *imap_adata_get(struct Mailbox *m);
 header_cache_t *imap_hcache_open(struct ImapAccountData *adata, const char *path);
 void imap_hcache_close(struct ImapAccountData *adata);
 struct Email *imap_hcache_get(struct ImapAccountData *adata, unsigned int uid);
+struct Body *imap_hcache_get_parts(struct ImapAccountData *adata, unsigned int uid);
 int imap_hcache_put(struct ImapAccountData *adata, struct Email *e);
+int imap_hcache_put_parts(struct ImapAccountData *adata, struct Email *e);
 int imap_hcache_del(struct ImapAccountData *adata, unsigned int uid);
 int imap_hcache_store_uid_seqset(struct ImapAccountData *adata);
 int imap_hcache_clear_uid_seqset(struct ImapAccountData *adata);
@@ -78,6 +78,7 @@ void imap_adata_free(void **ptr)
   struct ImapAccountData *adata = *ptr;
 
   FREE(&adata->capstr);
+  FREE(&adata->notify_mboxes);
   mutt_list_free(&adata->flags);
   imap_mboxcache_free(adata);
   mutt_buffer_free(&adata->cmdbuf);
@@ -303,6 +304,9 @@ static int imap_hcache_namer(const char *path, char *dest, size_t dlen)
  * @param path  Path to the header cache
  * @retval ptr HeaderCache
  * @retval NULL Failure
+ *
+ * If path is NULL, the selected mailbox's header cache is opened.  If it's
+ * open already, e.g. to load MIME parts, that handle is returned.
  */
 header_cache_t *imap_hcache_open(struct ImapAccountData *adata, const char *path)
 {
@@ -313,6 +317,8 @@ header_cache_t *imap_hcache_open(struct ImapAccountData *adata, const char *path
 
   if (path)
     imap_cachepath(adata, path, mbox, sizeof(mbox));
+  else if (adata->hcache)
+    return adata->hcache;
   else
   {
     if (!adata->mailbox || imap_parse_path(adata->mailbox->path, &mx) < 0)
@@ -378,6 +384,34 @@ struct Email *imap_hcache_get(struct ImapAccountData *adata, unsigned int uid)
   return e;
 }
 
+/**
+ * imap_hcache_get_parts - Get the MIME parts of a header cache entry
+ * @param adata Imap Account data
+ * @param uid   UID to find
+ * @retval ptr  First MIME part
+ * @retval NULL Failure, or the parts weren't cached
+ */
+struct Body *imap_hcache_get_parts(struct ImapAccountData *adata, unsigned int uid)
+{
+  char key[16];
+  void *uv = NULL;
+  struct Body *parts = NULL;
+
+  if (!adata->hcache)
+    return NULL;
+
+  sprintf(key, "/%u", uid);
+  uv = mutt_hcache_fetch_parts(adata->hcache, key, imap_hcache_keylen(key));
+  if (uv)
+  {
+    if (*(unsigned int *) uv == adata->uid_validity)
+      parts = mutt_hcache_restore_parts(uv);
+    mutt_hcache_free(adata->hcache, &uv);
+  }
+
+  return parts;
+}
+
 /**
  * imap_hcache_put - Add an entry to the header cache
  * @param adata Imap Account data
@@ -396,6 +430,25 @@ int imap_hcache_put(struct ImapAccountData *adata, struct Email *e)
   return mutt_hcache_store(adata->hcache, key, imap_hcache_keylen(key), e, adata->uid_validity);
 }
 
+/**
+ * imap_hcache_put_parts - Add an Email's MIME parts to the header cache
+ * @param adata Imap Account data
+ * @param e     Email
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+int imap_hcache_put_parts(struct ImapAccountData *adata, struct Email *e)
+{
+  char key[16];
+
+  if (!adata->hcache)
+    return -1;
+
+  sprintf(key, "/%u", imap_edata_get(e)->uid);
+  return mutt_hcache_store_parts(adata->hcache, key, imap_hcache_keylen(key),
+                                 e->content->parts, adata->uid_validity);
+}
+
 /**
  * imap_hcache_del - Delete an item from the header cache
  * @param adata Imap Account data
@@ -411,6 +464,7 @@ int imap_hcache_del(struct ImapAccountData *adata, unsigned int uid)
     return -1;
 
   sprintf(key, "/%u", uid);
+  mutt_hcache_delete_parts(adata->hcache, key, imap_hcache_keylen(key));
   return mutt_hcache_delete(adata->hcache, key, imap_hcache_keylen(key));
 }
 
@@ -1033,6 +1087,42 @@ void imap_keepalive(void)
   }
 }
 
+/**
+ * imap_keepalive_due - When is the next keepalive due? - Implements ::poll_due_t
+ */
+time_t imap_keepalive_due(void)
+{
+  if (ImapKeepalive == 0)
+    return 0;
+
+  time_t due = 0;
+  struct Account *np = NULL;
+  TAILQ_FOREACH(np, &AllAccounts, entries)
+  {
+    if (np->magic != MUTT_IMAP)
+      continue;
+
+    struct ImapAccountData *adata = np->adata;
+    if (!adata || (adata->state < IMAP_AUTHENTICATED))
+      continue;
+
+    time_t t = adata->lastread + ImapKeepalive;
+    if ((due == 0) || (t < due))
+      due = t;
+  }
+
+  return due;
+}
+
+/**
+ * imap_keepalive_timer - Send the keepalives that are due - Implements ::poll_fire_t
+ */
+int imap_keepalive_timer(void)
+{
+  imap_keepalive();
+  return 0;
+}
+
 /**
  * imap_wait_keepalive - Wait for a process to change state
  * @param pid Process ID to listen to
@@ -36,16 +36,11 @@
 #include "globals.h"
 #include "mutt_curses.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_window.h"
 #include "ncrypt/ncrypt.h"
 #include "opcodes.h"
 #include "options.h"
-#ifdef USE_IMAP
-#include "imap/imap.h"
-#endif
-#ifdef USE_INOTIFY
-#include "monitor.h"
-#endif
 
 /**
  * Menus - Menu name lookup table
@@ -575,44 +570,13 @@ int km_dokey(int menu)
 
   while (true)
   {
-    int i = Timeout > 0 ? Timeout : 60;
-#ifdef USE_IMAP
-    /* keepalive may need to run more frequently than Timeout allows */
-    if (ImapKeepalive)
-    {
-      if (ImapKeepalive >= i)
-        imap_keepalive();
-      else
-      {
-        while (ImapKeepalive && ImapKeepalive < i)
-        {
-          mutt_getch_timeout(ImapKeepalive * 1000);
-          tmp = mutt_getch();
-          mutt_getch_timeout(-1);
-          /* If a timeout was not received, or the window was resized, exit the
-           * loop now.  Otherwise, continue to loop until reaching a total of
-           * $timeout seconds.
-           */
-#ifdef USE_INOTIFY
-          if (tmp.ch != -2 || SigWinch || MonitorFilesChanged)
-#else
-          if (tmp.ch != -2 || SigWinch)
-#endif
-            goto gotkey;
-          i -= ImapKeepalive;
-          imap_keepalive();
-        }
-      }
-    }
-#endif
-
-    mutt_getch_timeout(i * 1000);
+    /* the keepalive timers run while we wait for a key, in any menu */
+    mutt_getch_timeout((Timeout > 0) ? (Timeout * 1000) : -1);
+    mutt_poll_timers(MUTT_POLL_TIMER_KEY, true);
     tmp = mutt_getch();
+    mutt_poll_timers(MUTT_POLL_TIMER_KEY, false);
     mutt_getch_timeout(-1);
 
-#ifdef USE_IMAP
-  gotkey:
-#endif
     /* hide timeouts, but not window resizes, from the line editor. */
     if (menu == MENU_EDITOR && tmp.ch == -2 && !SigWinch)
       continue;
@@ -645,7 +609,7 @@ int km_dokey(int menu)
 
       /* Sigh. Valid function but not in this context.
        * Find the literal string and push it back */
-      for (i = 0; Menus[i].name; i++)
+      for (int i = 0; Menus[i].name; i++)
       {
         bindings = km_get_table(Menus[i].value);
         if (bindings)
@@ -24,12 +24,19 @@
 
 #include "config.h"
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utime.h>
 #include "mutt/mutt.h"
 #include "config/lib.h"
@@ -42,6 +49,7 @@
 #include "maildir/maildir.h"
 #include "mbox/mbox.h"
 #include "menu.h"
+#include "mutt_poll.h"
 #include "mutt_window.h"
 #include "muttlib.h"
 #include "mx.h"
@@ -75,9 +83,80 @@ static time_t MailboxTime = 0; /**< last time we started checking for mail */
 static time_t MailboxStatsTime = 0; /**< last time we check performed mail_check_stats */
 static short MailboxCount = 0;  /**< how many boxes with new mail */
 static short MailboxNotify = 0; /**< # of unnotified new boxes */
+static bool MailboxChanged = false; /**< a mailbox's new mail or counts changed */
+static bool MailboxPolled = false;  /**< some mailboxes can only be checked by polling */
 
 struct MailboxList AllMailboxes = STAILQ_HEAD_INITIALIZER(AllMailboxes);
 
+/**
+ * struct MailboxCheck - The filesystem half of a new mail check
+ *
+ * The inputs are copies, so the check can be run on a worker thread while the
+ * UI carries on using the Mailbox and the config.
+ */
+struct MailboxCheck
+{
+  struct Mailbox *m;            ///< Mailbox being checked, NULL if it's been freed
+  char path[PATH_MAX];          ///< Path of the Mailbox
+  enum MailboxType magic;       ///< Type of the Mailbox
+  struct timespec last_visited; ///< Time of last exit from the Mailbox
+  bool check_stats;             ///< Count the total, new and flagged messages
+  bool check_recent;            ///< Copy of $mail_check_recent
+  bool check_cur;               ///< Copy of $maildir_check_cur
+  bool scan;                    ///< Read the Maildir's directories
+
+  int stat_rc;                  ///< Result of stat(2)
+  struct stat sb;               ///< stat(2) info about the Mailbox
+  bool scanned;                 ///< The Maildir's directories were read
+  bool gone;                    ///< A Maildir directory couldn't be opened
+  bool has_new;                 ///< The Maildir has new mail
+  int msg_count;                ///< Total number of messages
+  int msg_unread;               ///< Number of unread messages
+  int msg_flagged;              ///< Number of flagged messages
+  STAILQ_ENTRY(MailboxCheck) entries;
+};
+STAILQ_HEAD(MailboxCheckList, MailboxCheck);
+
+#ifdef USE_PTHREADS
+#define MAILBOX_CHECK_THREADS 4
+
+/* The background checker.  The lists are protected by CheckLock. */
+static pthread_mutex_t CheckLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t CheckCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t CheckIdle = PTHREAD_COND_INITIALIZER; ///< Signalled when a check finishes
+static struct MailboxCheckList CheckQueue = STAILQ_HEAD_INITIALIZER(CheckQueue); ///< Checks waiting for a worker
+static struct MailboxCheckList CheckRunning = STAILQ_HEAD_INITIALIZER(CheckRunning); ///< Checks being run by a worker
+static struct MailboxCheckList CheckDone = STAILQ_HEAD_INITIALIZER(CheckDone); ///< Checks waiting to be applied
+static int CheckThreads = 0;    ///< Number of workers, -1 if they can't be started
+static bool CheckStop = false;  ///< Workers should exit
+static int CheckPipe[2] = { -1, -1 }; ///< Workers wake the UI by writing to this pipe
+#endif
+
+#ifdef USE_PTHREADS
+/**
+ * mailbox_check_forget - Detach a Mailbox from its background check
+ * @param m Mailbox that's being freed, or whose check is out of date
+ *
+ * The check's result will be thrown away.
+ */
+static void mailbox_check_forget(struct Mailbox *m)
+{
+  struct MailboxCheckList *lists[] = { &CheckQueue, &CheckRunning, &CheckDone };
+  struct MailboxCheck *mc = NULL;
+
+  pthread_mutex_lock(&CheckLock);
+  for (size_t i = 0; i < mutt_array_size(lists); i++)
+  {
+    STAILQ_FOREACH(mc, lists[i], entries)
+    {
+      if (mc->m == m)
+        mc->m = NULL;
+    }
+  }
+  pthread_mutex_unlock(&CheckLock);
+}
+#endif
+
 /**
  * mailbox_new - Create a new Mailbox
  * @retval ptr New Mailbox
@@ -105,6 +184,11 @@ void mailbox_free(struct Mailbox **m)
   if (!m || !*m)
     return;
 
+#ifdef USE_PTHREADS
+  if ((*m)->checking)
+    mailbox_check_forget(*m);
+#endif
+
   FREE(&(*m)->desc);
   if ((*m)->mdata && (*m)->free_mdata)
     (*m)->free_mdata(&(*m)->mdata);
@@ -112,50 +196,73 @@ void mailbox_free(struct Mailbox **m)
 }
 
 /**
- * mailbox_maildir_check_dir - Check for new mail / mail counts
+ * mailbox_check_init - Prepare the filesystem half of a new mail check
+ * @param mc          Check to initialise
  * @param m           Mailbox to check
- * @param dir_name    Path to Mailbox
- * @param check_new   if true, check for new mail
- * @param check_stats if true, count total, new, and flagged messages
+ * @param check_stats If true, also count total, new, and flagged messages
+ *
+ * Everything the check needs is copied from the Mailbox and the config, so
+ * that mailbox_check_probe() can run without touching either.
+ */
+static void mailbox_check_init(struct MailboxCheck *mc, struct Mailbox *m, bool check_stats)
+{
+  memset(mc, 0, sizeof(*mc));
+  mc->m = m;
+  mutt_str_strfcpy(mc->path, m->path, sizeof(mc->path));
+  mc->magic = m->magic;
+  mc->last_visited = m->last_visited;
+  mc->check_stats = check_stats;
+  mc->check_recent = MailCheckRecent;
+  mc->check_cur = MaildirCheckCur;
+  mc->scan = (m->magic == MUTT_MAILDIR);
+  mc->stat_rc = -1;
+}
+
+/**
+ * mailbox_check_dir - Check a Maildir subdir for new mail / mail counts
+ * @param mc        Check in progress
+ * @param dir_name  Subdir to check, "cur" or "new"
+ * @param check_new if true, check for new mail
  * @retval 1 if the dir has new mail
  *
- * Checks the specified maildir subdir (cur or new) for new mail or mail counts.
+ * Only the filesystem and @a mc are used, so this is safe on a worker thread.
  */
-static int mailbox_maildir_check_dir(struct Mailbox *m, const char *dir_name,
-                                     bool check_new, bool check_stats)
+static int mailbox_check_dir(struct MailboxCheck *mc, const char *dir_name, bool check_new)
 {
   DIR *dirp = NULL;
   struct dirent *de = NULL;
   char *p = NULL;
   int rc = 0;
   struct stat sb;
+  char path[PATH_MAX];
+  char msgpath[PATH_MAX];
 
-  struct Buffer *path = mutt_buffer_pool_get();
-  struct Buffer *msgpath = mutt_buffer_pool_get();
-  mutt_buffer_printf(path, "%s/%s", m->path, dir_name);
+  if ((size_t) snprintf(path, sizeof(path), "%s/%s", mc->path, dir_name) >= sizeof(path))
+  {
+    mc->gone = true;
+    return 0;
+  }
 
   /* when $mail_check_recent is set, if the new/ directory hasn't been modified since
    * the user last exited the m, then we know there is no recent mail.
    */
-  if (check_new && MailCheckRecent)
+  if (check_new && mc->check_recent)
   {
-    if (stat(mutt_b2s(path), &sb) == 0 &&
-        mutt_stat_timespec_compare(&sb, MUTT_STAT_MTIME, &m->last_visited) < 0)
+    if (stat(path, &sb) == 0 &&
+        mutt_stat_timespec_compare(&sb, MUTT_STAT_MTIME, &mc->last_visited) < 0)
     {
-      rc = 0;
       check_new = false;
     }
   }
 
-  if (!(check_new || check_stats))
-    goto cleanup;
+  if (!(check_new || mc->check_stats))
+    return 0;
 
-  dirp = opendir(mutt_b2s(path));
+  dirp = opendir(path);
   if (!dirp)
   {
-    m->magic = MUTT_UNKNOWN;
-    rc = 0;
-    goto cleanup;
+    mc->gone = true;
+    return 0;
   }
 
   while ((de = readdir(dirp)))
@@ -167,32 +274,31 @@ static int mailbox_maildir_check_dir(struct Mailbox *m, const char *dir_name,
     if (p && strchr(p + 3, 'T'))
       continue;
 
-    if (check_stats)
+    if (mc->check_stats)
     {
-      m->msg_count++;
+      mc->msg_count++;
       if (p && strchr(p + 3, 'F'))
-        m->msg_flagged++;
+        mc->msg_flagged++;
     }
     if (!p || !strchr(p + 3, 'S'))
     {
-      if (check_stats)
-        m->msg_unread++;
+      if (mc->check_stats)
+        mc->msg_unread++;
       if (check_new)
       {
-        if (MailCheckRecent)
+        if (mc->check_recent)
         {
-          mutt_buffer_printf(msgpath, "%s/%s", mutt_b2s(path), de->d_name);
+          const size_t len = snprintf(msgpath, sizeof(msgpath), "%s/%s", path, de->d_name);
           /* ensure this message was received since leaving this m */
-          if (stat(mutt_b2s(msgpath), &sb) == 0 &&
-              (mutt_stat_timespec_compare(&sb, MUTT_STAT_CTIME, &m->last_visited) <= 0))
+          if ((len < sizeof(msgpath)) && (stat(msgpath, &sb) == 0) &&
+              (mutt_stat_timespec_compare(&sb, MUTT_STAT_CTIME, &mc->last_visited) <= 0))
           {
             continue;
           }
         }
-        m->has_new = true;
         rc = 1;
         check_new = false;
-        if (!check_stats)
+        if (!mc->check_stats)
           break;
       }
     }
@@ -200,39 +306,82 @@ static int mailbox_maildir_check_dir(struct Mailbox *m, const char *dir_name,
 
   closedir(dirp);
 
-cleanup:
-  mutt_buffer_pool_release(&path);
-  mutt_buffer_pool_release(&msgpath);
-
   return rc;
 }
 
 /**
- * mailbox_maildir_check - Check for new mail in a maildir mailbox
- * @param m           Mailbox to check
- * @param check_stats if true, also count total, new, and flagged messages
+ * mailbox_check_scan - Check a Maildir's new/ and cur/ for new mail
+ * @param mc Check in progress
+ */
+static void mailbox_check_scan(struct MailboxCheck *mc)
+{
+  mc->has_new = mailbox_check_dir(mc, "new", true);
+
+  bool check_new = !mc->has_new && mc->check_cur;
+  if (check_new || mc->check_stats)
+    if (mailbox_check_dir(mc, "cur", check_new))
+      mc->has_new = true;
+
+  mc->scanned = true;
+}
+
+/**
+ * mailbox_check_probe - Do the filesystem half of a new mail check
+ * @param mc Check to perform
+ *
+ * This may block for a long time, e.g. on a slow NFS mount, but it only
+ * touches @a mc, so it can be run on a worker thread.
+ */
+static void mailbox_check_probe(struct MailboxCheck *mc)
+{
+  mc->stat_rc = stat(mc->path, &mc->sb);
+  if ((mc->stat_rc == 0) && mc->scan)
+    mailbox_check_scan(mc);
+}
+
+/**
+ * mailbox_check_result - Copy the results of a Maildir scan to its Mailbox
+ * @param m  Mailbox
+ * @param mc Finished check
  * @retval 1 if the mailbox has new mail
  */
-static int mailbox_maildir_check(struct Mailbox *m, bool check_stats)
+static int mailbox_check_result(struct Mailbox *m, struct MailboxCheck *mc)
 {
-  int rc = 1;
-  bool check_new = true;
+  if (mc->gone)
+    m->magic = MUTT_UNKNOWN;
 
-  if (check_stats)
+  if (mc->check_stats)
   {
-    m->msg_count = 0;
-    m->msg_unread = 0;
-    m->msg_flagged = 0;
+    m->msg_count = mc->msg_count;
+    m->msg_unread = mc->msg_unread;
+    m->msg_flagged = mc->msg_flagged;
   }
 
-  rc = mailbox_maildir_check_dir(m, "new", check_new, check_stats);
+  if (mc->has_new)
+    m->has_new = true;
 
-  check_new = !rc && MaildirCheckCur;
-  if (check_new || check_stats)
-    if (mailbox_maildir_check_dir(m, "cur", check_new, check_stats))
-      rc = 1;
+  return mc->has_new ? 1 : 0;
+}
 
-  return rc;
+/**
+ * mailbox_maildir_check - Check for new mail in a maildir mailbox
+ * @param m           Mailbox to check
+ * @param check_stats if true, also count total, new, and flagged messages
+ * @retval 1 if the mailbox has new mail
+ */
+static int mailbox_maildir_check(struct Mailbox *m, bool check_stats)
+{
+#ifdef USE_INOTIFY
+  /* the monitor keeps count, as the files come and go */
+  int rc = mutt_monitor_maildir_check(m, check_stats);
+  if (rc >= 0)
+    return rc;
+#endif
+
+  struct MailboxCheck mc;
+  mailbox_check_init(&mc, m, check_stats);
+  mailbox_check_scan(&mc);
+  return mailbox_check_result(m, &mc);
 }
 
 /**
@@ -297,19 +446,22 @@ static int mailbox_mbox_check(struct Mailbox *m, struct stat *sb, bool check_sta
 /**
  * mailbox_check - Check a mailbox for new mail
  * @param m           Mailbox to check
+ * @param mc          Finished filesystem check of a local mailbox, may be NULL
  * @param ctx_sb      stat() info for the current mailbox (Context)
  * @param check_stats If true, also count the total, new and flagged messages
+ *
+ * If @a mc is NULL, the filesystem is checked here and now.
  */
-static void mailbox_check(struct Mailbox *m, struct stat *ctx_sb, bool check_stats)
+static void mailbox_check(struct Mailbox *m, struct MailboxCheck *mc,
+                          struct stat *ctx_sb, bool check_stats)
 {
   struct stat sb = { 0 };
+  int stat_rc;
 
-#ifdef USE_SIDEBAR
   short orig_new = m->has_new;
   int orig_count = m->msg_count;
   int orig_unread = m->msg_unread;
   int orig_flagged = m->msg_flagged;
-#endif
 
   if (m->magic != MUTT_IMAP)
   {
@@ -335,15 +487,25 @@ static void mailbox_check(struct Mailbox *m, struct stat *ctx_sb, bool check_sta
     }
     else
 #endif
-        if (stat(m->path, &sb) != 0 || (S_ISREG(sb.st_mode) && sb.st_size == 0) ||
-            ((m->magic == MUTT_UNKNOWN) && (m->magic = mx_path_probe(m->path, NULL)) <= 0))
     {
-      /* if the mailbox still doesn't exist, set the newly created flag to be
-       * ready for when it does. */
-      m->newly_created = true;
-      m->magic = MUTT_UNKNOWN;
-      m->size = 0;
-      return;
+      if (mc)
+      {
+        stat_rc = mc->stat_rc;
+        sb = mc->sb;
+      }
+      else
+        stat_rc = stat(m->path, &sb);
+
+      if ((stat_rc != 0) || (S_ISREG(sb.st_mode) && sb.st_size == 0) ||
+          ((m->magic == MUTT_UNKNOWN) && (m->magic = mx_path_probe(m->path, NULL)) <= 0))
+      {
+        /* if the mailbox still doesn't exist, set the newly created flag to be
+         * ready for when it does. */
+        m->newly_created = true;
+        m->magic = MUTT_UNKNOWN;
+        m->size = 0;
+        return;
+      }
     }
   }
 
@@ -364,18 +526,18 @@ static void mailbox_check(struct Mailbox *m, struct stat *ctx_sb, bool check_sta
     {
       case MUTT_MBOX:
       case MUTT_MMDF:
-        if (mailbox_mbox_check(m, &sb, check_stats) > 0)
-          MailboxCount++;
+        mailbox_mbox_check(m, &sb, check_stats);
         break;
 
       case MUTT_MAILDIR:
-        if (mailbox_maildir_check(m, check_stats) > 0)
-          MailboxCount++;
+        if (mc && mc->scanned)
+          mailbox_check_result(m, mc);
+        else
+          mailbox_maildir_check(m, check_stats);
         break;
 
       case MUTT_MH:
-        if (mh_mailbox(m, check_stats))
-          MailboxCount++;
+        mh_mailbox(m, check_stats);
         break;
 #ifdef USE_NOTMUCH
       case MUTT_NOTMUCH:
@@ -384,10 +546,7 @@ static void mailbox_check(struct Mailbox *m, struct stat *ctx_sb, bool check_sta
         m->msg_flagged = 0;
         nm_nonctx_get_count(m->path, &m->msg_count, &m->msg_unread);
         if (m->msg_unread > 0)
-        {
-          MailboxCount++;
           m->has_new = true;
-        }
         break;
 #endif
       default:; /* do nothing */
@@ -396,18 +555,306 @@ static void mailbox_check(struct Mailbox *m, struct stat *ctx_sb, bool check_sta
   else if (CheckMboxSize && Context && (Context->mailbox->path[0] != '\0'))
     m->size = (off_t) sb.st_size; /* update the size of current folder */
 
-#ifdef USE_SIDEBAR
   if ((orig_new != m->has_new) || (orig_count != m->msg_count) ||
       (orig_unread != m->msg_unread) || (orig_flagged != m->msg_flagged))
   {
+    MailboxChanged = true;
+#ifdef USE_SIDEBAR
     mutt_menu_set_current_redraw(REDRAW_SIDEBAR);
-  }
 #endif
+  }
 
   if (!m->has_new)
     m->notified = false;
-  else if (!m->notified)
-    MailboxNotify++;
+}
+
+#ifdef USE_PTHREADS
+/**
+ * mailbox_check_worker - Run queued mailbox checks - Implements pthread start_routine
+ * @param arg Unused
+ * @retval NULL Always
+ *
+ * The workers only run mailbox_check_probe(), which doesn't touch any shared
+ * state.  The results are left on CheckDone for the UI thread to apply.
+ */
+static void *mailbox_check_worker(void *arg)
+{
+  pthread_mutex_lock(&CheckLock);
+  while (true)
+  {
+    while (!CheckStop && STAILQ_EMPTY(&CheckQueue))
+      pthread_cond_wait(&CheckCond, &CheckLock);
+    if (CheckStop)
+      break;
+
+    struct MailboxCheck *mc = STAILQ_FIRST(&CheckQueue);
+    STAILQ_REMOVE_HEAD(&CheckQueue, entries);
+    STAILQ_INSERT_TAIL(&CheckRunning, mc, entries);
+    pthread_mutex_unlock(&CheckLock);
+
+    mailbox_check_probe(mc);
+
+    pthread_mutex_lock(&CheckLock);
+    STAILQ_REMOVE(&CheckRunning, mc, MailboxCheck, entries);
+    if (CheckStop)
+      FREE(&mc);
+    else
+    {
+      STAILQ_INSERT_TAIL(&CheckDone, mc, entries);
+      if (write(CheckPipe[1], "", 1) < 0)
+      {
+        /* the pipe is full, so the UI is already awake */
+      }
+    }
+    pthread_cond_broadcast(&CheckIdle);
+  }
+  pthread_mutex_unlock(&CheckLock);
+
+  return NULL;
+}
+
+/**
+ * mailbox_check_event - Wake the UI when checks have finished - Implements ::poll_fd_t
+ *
+ * The results are applied by the next mutt_mailbox_check().
+ */
+static int mailbox_check_event(int fd, void *data)
+{
+  char buf[64];
+
+  while (read(fd, buf, sizeof(buf)) > 0)
+    ;
+
+  return 1;
+}
+
+/**
+ * mailbox_check_start - Start the background workers
+ * @retval true The workers are running
+ *
+ * The workers are detached, so that a check stuck on a dead NFS server can't
+ * stop NeoMutt from exiting.  They block all signals, which are left to the
+ * UI thread.
+ */
+static bool mailbox_check_start(void)
+{
+  if (CheckThreads != 0)
+    return CheckThreads > 0;
+
+  if ((pipe(CheckPipe) != 0) || (fcntl(CheckPipe[0], F_SETFL, O_NONBLOCK) != 0) ||
+      (fcntl(CheckPipe[1], F_SETFL, O_NONBLOCK) != 0))
+  {
+    mutt_debug(1, "pipe() failed, errno=%d %s\n", errno, strerror(errno));
+    CheckThreads = -1;
+    return false;
+  }
+  fcntl(CheckPipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(CheckPipe[1], F_SETFD, FD_CLOEXEC);
+  mutt_poll_add(CheckPipe[0], mailbox_check_event, NULL);
+
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  for (int i = 0; i < MAILBOX_CHECK_THREADS; i++)
+  {
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, mailbox_check_worker, NULL) != 0)
+      break;
+    CheckThreads++;
+  }
+  pthread_attr_destroy(&attr);
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  mutt_debug(2, "started %d mailbox check threads\n", CheckThreads);
+  if (CheckThreads == 0)
+    CheckThreads = -1;
+
+  return CheckThreads > 0;
+}
+
+/**
+ * mailbox_check_submit - Queue a mailbox check for the background workers
+ * @param m           Mailbox to check
+ * @param check_stats If true, also count the total, new and flagged messages
+ * @retval true  The check was queued, or one is already running
+ * @retval false The mailbox must be checked now
+ *
+ * Only local mailboxes of a known type are checked in the background.
+ */
+static bool mailbox_check_submit(struct Mailbox *m, bool check_stats)
+{
+  if (m->checking)
+    return true;
+
+  switch (m->magic)
+  {
+    case MUTT_MBOX:
+    case MUTT_MMDF:
+    case MUTT_MAILDIR:
+    case MUTT_MH:
+      break;
+    default:
+      return false;
+  }
+
+  if (!mailbox_check_start())
+    return false;
+
+  struct MailboxCheck *mc = mutt_mem_malloc(sizeof(*mc));
+  mailbox_check_init(mc, m, check_stats);
+#ifdef USE_INOTIFY
+  /* the monitor already knows the counts, don't read the directories */
+  if (mutt_monitor_maildir_watched(m))
+    mc->scan = false;
+#endif
+
+  m->checking = true;
+  pthread_mutex_lock(&CheckLock);
+  STAILQ_INSERT_TAIL(&CheckQueue, mc, entries);
+  pthread_cond_signal(&CheckCond);
+  pthread_mutex_unlock(&CheckLock);
+
+  return true;
+}
+
+/**
+ * mailbox_check_busy - Are any checks still queued or running?
+ * @retval true A check of a Mailbox hasn't finished
+ *
+ * Checks that have been forgotten don't count.  The caller must hold CheckLock.
+ */
+static bool mailbox_check_busy(void)
+{
+  struct MailboxCheckList *lists[] = { &CheckQueue, &CheckRunning };
+  struct MailboxCheck *mc = NULL;
+
+  for (size_t i = 0; i < mutt_array_size(lists); i++)
+  {
+    STAILQ_FOREACH(mc, lists[i], entries)
+    {
+      if (mc->m)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * mailbox_check_wait - Wait for all the queued checks to finish
+ *
+ * Like a check on the UI thread, this blocks for as long as the filesystem
+ * does, but the mailboxes are still checked in parallel.
+ */
+static void mailbox_check_wait(void)
+{
+  if (CheckThreads <= 0)
+    return;
+
+  pthread_mutex_lock(&CheckLock);
+  while (!CheckStop && mailbox_check_busy())
+    pthread_cond_wait(&CheckIdle, &CheckLock);
+  pthread_mutex_unlock(&CheckLock);
+}
+#endif
+
+/**
+ * mailbox_check_apply - Apply the results of the background checks
+ * @param ctx_sb stat() info for the current mailbox (Context)
+ * @retval true Some results were applied
+ *
+ * All the finished checks are taken at once, so the UI sees a consistent set
+ * of results.
+ */
+static bool mailbox_check_apply(struct stat *ctx_sb)
+{
+#ifdef USE_PTHREADS
+  struct MailboxCheckList done = STAILQ_HEAD_INITIALIZER(done);
+
+  if (CheckThreads <= 0)
+    return false;
+
+  pthread_mutex_lock(&CheckLock);
+  STAILQ_SWAP(&done, &CheckDone, MailboxCheck);
+  pthread_mutex_unlock(&CheckLock);
+
+  if (STAILQ_EMPTY(&done))
+    return false;
+
+  struct MailboxCheck *mc = STAILQ_FIRST(&done);
+  while (mc)
+  {
+    struct MailboxCheck *next = STAILQ_NEXT(mc, entries);
+    if (mc->m)
+    {
+      mc->m->checking = false;
+      /* the mailbox may have been reopened as something else */
+      if (mc->m->magic == mc->magic)
+        mailbox_check(mc->m, mc, ctx_sb, mc->check_stats);
+    }
+    FREE(&mc);
+    mc = next;
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * mailbox_check_pending - Are there any background results to apply?
+ * @retval true Results are waiting
+ */
+static bool mailbox_check_pending(void)
+{
+#ifdef USE_PTHREADS
+  if (CheckThreads <= 0)
+    return false;
+
+  pthread_mutex_lock(&CheckLock);
+  bool pending = !STAILQ_EMPTY(&CheckDone);
+  pthread_mutex_unlock(&CheckLock);
+  return pending;
+#else
+  return false;
+#endif
+}
+
+/**
+ * mutt_mailbox_check_cleanup - Stop the background mailbox checks
+ *
+ * Any checks still in progress are abandoned.
+ */
+void mutt_mailbox_check_cleanup(void)
+{
+#ifdef USE_PTHREADS
+  if (CheckThreads <= 0)
+    return;
+
+  struct MailboxCheckList *lists[] = { &CheckQueue, &CheckDone };
+
+  pthread_mutex_lock(&CheckLock);
+  CheckStop = true;
+  for (size_t i = 0; i < mutt_array_size(lists); i++)
+  {
+    struct MailboxCheck *mc = STAILQ_FIRST(lists[i]);
+    while (mc)
+    {
+      struct MailboxCheck *next = STAILQ_NEXT(mc, entries);
+      FREE(&mc);
+      mc = next;
+    }
+    STAILQ_INIT(lists[i]);
+  }
+  pthread_cond_broadcast(&CheckCond);
+  pthread_mutex_unlock(&CheckLock);
+#endif
 }
 
 /**
@@ -765,6 +1212,46 @@ int mutt_parse_unmailboxes(struct Buffer *buf, struct Buffer *s,
   return 0;
 }
 
+/**
+ * mailbox_context_stat - Get the device and inode of the current mailbox
+ * @param[out] ctx_sb stat() info for the current mailbox (Context)
+ */
+static void mailbox_context_stat(struct stat *ctx_sb)
+{
+  /* check device ID and serial number instead of comparing paths */
+  if (!Context || !Context->mailbox || (Context->mailbox->magic == MUTT_IMAP) ||
+      (Context->mailbox->magic == MUTT_POP)
+#ifdef USE_NNTP
+      || (Context->mailbox->magic == MUTT_NNTP)
+#endif
+      || stat(Context->mailbox->path, ctx_sb) != 0)
+  {
+    ctx_sb->st_dev = 0;
+    ctx_sb->st_ino = 0;
+  }
+}
+
+/**
+ * mailbox_count - Count the mailboxes with new mail
+ *
+ * Sets MailboxCount and MailboxNotify.
+ */
+static void mailbox_count(void)
+{
+  MailboxCount = 0;
+  MailboxNotify = 0;
+
+  struct MailboxNode *np = NULL;
+  STAILQ_FOREACH(np, &AllMailboxes, entries)
+  {
+    if (!np->m->has_new)
+      continue;
+    MailboxCount++;
+    if (!np->m->notified)
+      MailboxNotify++;
+  }
+}
+
 /**
  * mutt_mailbox_check - Check all AllMailboxes for new mail
  * @param force Force flags, see below
@@ -773,16 +1260,20 @@ int mutt_parse_unmailboxes(struct Buffer *buf, struct Buffer *s,
  * The force argument may be any combination of the following values:
  * - MUTT_MAILBOX_CHECK_FORCE        ignore MailboxTime and check for new mail
  * - MUTT_MAILBOX_CHECK_FORCE_STATS  ignore MailboxTime and calculate statistics
+ * - MUTT_MAILBOX_CHECK_IMMEDIATE    check local mailboxes now, not in the background
  *
  * Check all AllMailboxes for new mail and total/new/flagged messages
+ *
+ * Local mailboxes are normally checked by background workers, so a slow
+ * filesystem can't block the UI.  Their results are applied by a later call.
+ * A forced check waits for a fresh result from every mailbox: any check that
+ * was already queued or running is thrown away and run again.
  */
 int mutt_mailbox_check(int force)
 {
-  struct stat contex_sb;
+  struct stat contex_sb = { 0 };
   time_t t;
   bool check_stats = false;
-  contex_sb.st_dev = 0;
-  contex_sb.st_ino = 0;
 
 #ifdef USE_IMAP
   /* update postponed count as well, on force */
@@ -796,7 +1287,16 @@ int mutt_mailbox_check(int force)
 
   t = time(NULL);
   if (!force && (t - MailboxTime < MailCheck))
+  {
+    /* pick up any results that arrived in the meantime */
+    if (mailbox_check_pending())
+    {
+      mailbox_context_stat(&contex_sb);
+      mailbox_check_apply(&contex_sb);
+      mailbox_count();
+    }
     return MailboxCount;
+  }
 
   if ((force & MUTT_MAILBOX_CHECK_FORCE_STATS) ||
       (MailCheckStats && ((t - MailboxStatsTime) >= MailCheckStatsInterval)))
@@ -806,34 +1306,85 @@ int mutt_mailbox_check(int force)
   }
 
   MailboxTime = t;
-  MailboxCount = 0;
-  MailboxNotify = 0;
+#ifdef USE_INOTIFY
+  MonitorFilesChanged = 0;
+#endif
 
 #ifdef USE_IMAP
-  MailboxCount += imap_mailbox_check(check_stats);
+  imap_mailbox_check(check_stats);
 #endif
 
-  /* check device ID and serial number instead of comparing paths */
-  if (!Context || !Context->mailbox || (Context->mailbox->magic == MUTT_IMAP) ||
-      (Context->mailbox->magic == MUTT_POP)
-#ifdef USE_NNTP
-      || (Context->mailbox->magic == MUTT_NNTP)
-#endif
-      || stat(Context->mailbox->path, &contex_sb) != 0)
-  {
-    contex_sb.st_dev = 0;
-    contex_sb.st_ino = 0;
-  }
+  mailbox_context_stat(&contex_sb);
+  mailbox_check_apply(&contex_sb);
 
+  MailboxPolled = false;
   struct MailboxNode *np = NULL;
   STAILQ_FOREACH(np, &AllMailboxes, entries)
   {
-    mailbox_check(np->m, &contex_sb, check_stats);
+#ifdef USE_INOTIFY
+    if (!mutt_monitor_maildir_watched(np->m))
+#endif
+      MailboxPolled = true;
+
+#ifdef USE_PTHREADS
+    if ((force & MUTT_MAILBOX_CHECK_FORCE) && np->m->checking)
+    {
+      /* it may have looked at the mailbox before the change we're checking for */
+      mailbox_check_forget(np->m);
+      np->m->checking = false;
+    }
+    if (!(force & MUTT_MAILBOX_CHECK_IMMEDIATE) && mailbox_check_submit(np->m, check_stats))
+      continue;
+#endif
+    mailbox_check(np->m, NULL, &contex_sb, check_stats);
+  }
+
+#ifdef USE_PTHREADS
+  if (force & MUTT_MAILBOX_CHECK_FORCE)
+  {
+    mailbox_check_wait();
+    mailbox_check_apply(&contex_sb);
   }
+#endif
 
+  mailbox_count();
   return MailboxCount;
 }
 
+/**
+ * mutt_mailbox_check_due - When is the next mailbox check due? - Implements ::poll_due_t
+ *
+ * Maildirs watched by the monitor don't need to be polled.  If they're all
+ * there is, they're only checked after some files have changed.
+ */
+time_t mutt_mailbox_check_due(void)
+{
+  if (STAILQ_EMPTY(&AllMailboxes))
+    return 0;
+
+#ifdef USE_INOTIFY
+  if (!MailboxPolled && !MonitorFilesChanged)
+    return 0;
+#endif
+
+  return MailboxTime + MailCheck;
+}
+
+/**
+ * mutt_mailbox_check_timer - Check for new mail - Implements ::poll_fire_t
+ * @retval 1 The UI should wake up, something has changed
+ */
+int mutt_mailbox_check_timer(void)
+{
+  int count = MailboxCount;
+  int notify = MailboxNotify;
+
+  MailboxChanged = false;
+  mutt_mailbox_check(0);
+
+  return (MailboxChanged || (MailboxCount != count) || (MailboxNotify > notify)) ? 1 : 0;
+}
+
 /**
  * mutt_mailbox_list - List the mailboxes with new mail
  * @retval true If there is new mail
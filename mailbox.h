@@ -94,6 +94,7 @@ struct Mailbox
   int vcount;               /**< the number of virtual messages */
 
   bool notified;             /**< user has been notified */
+  bool checking;             /**< a new mail check is running in the background */
   enum MailboxType magic;    /**< mailbox type */
   bool newly_created;        /**< mbox or mmdf just popped into existence */
   struct timespec mtime;
@@ -157,10 +158,14 @@ void mutt_mailbox_setnotified(const char *path);
 /* force flags passed to mutt_mailbox_check() */
 #define MUTT_MAILBOX_CHECK_FORCE       (1 << 0)
 #define MUTT_MAILBOX_CHECK_FORCE_STATS (1 << 1)
+#define MUTT_MAILBOX_CHECK_IMMEDIATE   (1 << 2)
 
 void mutt_mailbox(char *s, size_t slen);
 bool mutt_mailbox_list(void);
 int mutt_mailbox_check(int force);
+void mutt_mailbox_check_cleanup(void);
+time_t mutt_mailbox_check_due(void);
+int mutt_mailbox_check_timer(void);
 bool mutt_mailbox_notify(void);
 int mutt_parse_mailboxes(struct Buffer *path, struct Buffer *s, unsigned long data, struct Buffer *err);
 int mutt_parse_unmailboxes(struct Buffer *path, struct Buffer *s, unsigned long data, struct Buffer *err);
@@ -26,6 +26,9 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include <time.h>
+#ifdef USE_HCACHE
+#include "hcache/hcache.h"
+#endif
 
 /**
  * struct MaildirMboxData - MH-specific mailbox data
@@ -34,6 +37,9 @@ struct MaildirMboxData
 {
   struct timespec mtime_cur;
   mode_t mh_umask;
+#ifdef USE_HCACHE
+  header_cache_t *hcache; ///< Header cache, kept open for saving MIME parts
+#endif
 };
 
 /**
@@ -85,6 +85,41 @@ char *MhSeqUnseen;  ///< Config: MH sequence for unseen messages
 #define MH_SEQ_REPLIED (1 << 1)
 #define MH_SEQ_FLAGGED (1 << 2)
 
+#define MD_SCAN_FLAGGED (1 << 0) ///< 'F' Flagged
+#define MD_SCAN_REPLIED (1 << 1) ///< 'R' Replied
+#define MD_SCAN_SEEN    (1 << 2) ///< 'S' Seen
+#define MD_SCAN_TRASHED (1 << 3) ///< 'T' Trashed, and so deleted
+#define MD_SCAN_OTHER   (1 << 4) ///< Other flags, see Email::maildir_flags
+#define MD_SCAN_OLD     (1 << 5) ///< In cur/, with $mark_old set
+#define MD_SCAN_MATCHED (1 << 6) ///< Matches an Email that's already loaded
+
+/**
+ * struct MdFile - A file found by maildir_scan_dir()
+ */
+struct MdFile
+{
+  ino_t inode;  ///< Inode number
+  size_t path;  ///< Offset of the path, e.g. "cur/123:2,S", in MdScan::names
+  size_t canon; ///< Offset of the canonical name, e.g. "123", in MdScan::names
+  int flags;    ///< Flags, e.g. #MD_SCAN_SEEN
+};
+
+/**
+ * struct MdScan - The files in one or more Maildir directories
+ *
+ * The names are kept in a single block, so a scan only needs a handful of
+ * allocations, however many files there are.
+ */
+struct MdScan
+{
+  struct MdFile *files; ///< Files found
+  size_t num_files;     ///< Number of files
+  size_t files_len;     ///< Allocated length of files
+  char *names;          ///< Paths and canonical names, each NUL-terminated
+  size_t names_used;    ///< Bytes used in names
+  size_t names_len;     ///< Allocated length of names
+};
+
 /**
  * maildir_mdata_free - Free data attached to the Mailbox
  * @param ptr Maildir data
@@ -94,7 +129,10 @@ void maildir_mdata_free(void **ptr)
   if (!ptr || !*ptr)
     return;
 
-  // struct MaildirMboxData *mdata = *ptr;
+#ifdef USE_HCACHE
+  struct MaildirMboxData *mdata = *ptr;
+  mutt_hcache_close(mdata->hcache);
+#endif
   FREE(ptr);
 }
 
@@ -723,23 +761,109 @@ static void maildir_update_mtime(struct Mailbox *m)
 }
 
 /**
- * maildir_parse_dir - Read a Maildir mailbox
+ * maildir_scan_add - Remember a file found in a Maildir
+ * @param scan   Scan results
+ * @param magic  Mailbox type, e.g. #MUTT_MAILDIR
+ * @param subdir Subdirectory, e.g. 'new', may be NULL
+ * @param name   File name
+ * @param inode  Inode number
+ * @param is_old true if the email should be marked old
+ */
+static void maildir_scan_add(struct MdScan *scan, enum MailboxType magic,
+                             const char *subdir, const char *name, ino_t inode, bool is_old)
+{
+  size_t slen = subdir ? strlen(subdir) + 1 : 0;
+  size_t nlen = strlen(name);
+  size_t need = (2 * (slen + nlen + 1));
+
+  if (scan->num_files == scan->files_len)
+  {
+    scan->files_len = MAX(2 * scan->files_len, 256);
+    mutt_mem_realloc(&scan->files, scan->files_len * sizeof(struct MdFile));
+  }
+  if (scan->names_used + need > scan->names_len)
+  {
+    scan->names_len = MAX(2 * scan->names_len, scan->names_used + need + 8192);
+    mutt_mem_realloc(&scan->names, scan->names_len);
+  }
+
+  struct MdFile *f = &scan->files[scan->num_files++];
+  f->inode = inode;
+  f->flags = is_old ? MD_SCAN_OLD : 0;
+
+  /* the path, e.g. "cur/123:2,S" */
+  char *path = scan->names + scan->names_used;
+  f->path = scan->names_used;
+  if (subdir)
+  {
+    memcpy(path, subdir, slen - 1);
+    path[slen - 1] = '/';
+  }
+  memcpy(path + slen, name, nlen + 1);
+  scan->names_used += slen + nlen + 1;
+
+  if (magic != MUTT_MAILDIR)
+  {
+    f->canon = f->path;
+    return;
+  }
+
+  /* the canonical name, e.g. "123" */
+  const char *colon = strrchr(name, ':');
+  size_t clen = colon ? (size_t)(colon - name) : nlen;
+  f->canon = scan->names_used;
+  memcpy(scan->names + f->canon, name, clen);
+  scan->names[f->canon + clen] = '\0';
+  scan->names_used += clen + 1;
+
+  if (!colon || (mutt_str_strncmp(colon + 1, "2,", 2) != 0))
+    return;
+
+  /* Parse the flags like maildir_parse_flags() does */
+  for (const char *p = colon + 3; *p; p++)
+  {
+    switch (*p)
+    {
+      case 'F':
+        f->flags |= MD_SCAN_FLAGGED;
+        break;
+      case 'R':
+        f->flags |= MD_SCAN_REPLIED;
+        break;
+      case 'S':
+        f->flags |= MD_SCAN_SEEN;
+        break;
+      case 'T':
+        if (!(f->flags & MD_SCAN_FLAGGED) || !FlagSafe)
+          f->flags |= MD_SCAN_TRASHED;
+        break;
+      default:
+        f->flags |= MD_SCAN_OTHER;
+        break;
+    }
+  }
+}
+
+/**
+ * maildir_scan_dir - Read the file names in a Maildir or MH directory
  * @param m        Mailbox
- * @param last     Last Maildir
- * @param subdir   Subdirectory, e.g. 'new'
+ * @param subdir   Subdirectory, e.g. 'new', may be NULL
+ * @param scan     Scan results to add to
  * @param count    Counter for the progress bar
- * @param progress Progress bar
+ * @param progress Progress bar, may be NULL
  * @retval  0 Success
  * @retval -1 Error
  * @retval -2 Aborted
+ *
+ * Only the names are read, so no Emails are created.  readdir() already
+ * fetches the directory entries from the kernel in large batches.
  */
-static int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
-                             const char *subdir, int *count, struct Progress *progress)
+static int maildir_scan_dir(struct Mailbox *m, const char *subdir,
+                            struct MdScan *scan, int *count, struct Progress *progress)
 {
   struct dirent *de = NULL;
-  int rc = 0, is_old = 0;
-  struct Maildir *entry = NULL;
-  struct Email *e = NULL;
+  int rc = 0;
+  bool is_old = false;
 
   struct Buffer *buf = mutt_buffer_pool_get();
 
@@ -766,13 +890,8 @@ static int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
       continue;
     }
 
-    /* FOO - really ignore the return value? */
     mutt_debug(2, "queueing %s\n", de->d_name);
-
-    e = mutt_email_new();
-    e->old = is_old;
-    if (m->magic == MUTT_MAILDIR)
-      maildir_parse_flags(e, de->d_name);
+    maildir_scan_add(scan, m->magic, subdir, de->d_name, de->d_ino, is_old);
 
     if (count)
     {
@@ -780,33 +899,172 @@ static int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
       if (!m->quiet && progress)
         mutt_progress_update(progress, *count, -1);
     }
+  }
+
+  closedir(dirp);
+
+  if (SigInt == 1)
+  {
+    SigInt = 0;
+    rc = -2; /* action aborted */
+  }
+
+cleanup:
+  mutt_buffer_pool_release(&buf);
+
+  return rc;
+}
+
+/**
+ * maildir_scan_sort - Sort the files found by inode number
+ * @param scan Scan results
+ *
+ * Reading the files in inode order is much faster on many filesystems.
+ * This is a radix sort, a byte at a time, skipping the bytes that are the
+ * same in every inode number.
+ */
+static void maildir_scan_sort(struct MdScan *scan)
+{
+  size_t n = scan->num_files;
+  if (n < 2)
+    return;
+
+  size_t(*counts)[256] = mutt_mem_calloc(sizeof(ino_t), sizeof(*counts));
+  for (size_t i = 0; i < n; i++)
+  {
+    ino_t ino = scan->files[i].inode;
+    for (size_t b = 0; b < sizeof(ino_t); b++)
+      counts[b][(ino >> (8 * b)) & 0xff]++;
+  }
+
+  struct MdFile *tmp = mutt_mem_malloc(n * sizeof(struct MdFile));
+  struct MdFile *src = scan->files;
+  struct MdFile *dst = tmp;
+
+  for (size_t b = 0; b < sizeof(ino_t); b++)
+  {
+    /* every inode number has the same byte here */
+    if (counts[b][(src[0].inode >> (8 * b)) & 0xff] == n)
+      continue;
 
-    if (subdir)
+    size_t pos = 0;
+    for (size_t d = 0; d < 256; d++)
     {
-      mutt_buffer_printf(buf, "%s/%s", subdir, de->d_name);
-      e->path = mutt_str_strdup(mutt_b2s(buf));
+      size_t c = counts[b][d];
+      counts[b][d] = pos;
+      pos += c;
     }
-    else
-      e->path = mutt_str_strdup(de->d_name);
 
-    entry = mutt_mem_calloc(1, sizeof(struct Maildir));
+    for (size_t i = 0; i < n; i++)
+      dst[counts[b][(src[i].inode >> (8 * b)) & 0xff]++] = src[i];
+
+    struct MdFile *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != scan->files)
+  {
+    FREE(&scan->files);
+    scan->files = src;
+    scan->files_len = n;
+  }
+  else
+    FREE(&tmp);
+
+  FREE(&counts);
+}
+
+/**
+ * maildir_scan_email - Create an Email for a file found by a scan
+ * @param scan Scan results
+ * @param f    File
+ * @param e    Email to fill in
+ */
+static void maildir_scan_email(struct MdScan *scan, struct MdFile *f, struct Email *e)
+{
+  e->old = (f->flags & MD_SCAN_OLD);
+
+  if (f->flags & MD_SCAN_OTHER)
+  {
+    maildir_parse_flags(e, scan->names + f->path);
+    return;
+  }
+
+  e->flagged = (f->flags & MD_SCAN_FLAGGED);
+  e->replied = (f->flags & MD_SCAN_REPLIED);
+  e->read = (f->flags & MD_SCAN_SEEN);
+  if (f->flags & MD_SCAN_TRASHED)
+  {
+    e->trash = true;
+    e->deleted = true;
+  }
+}
+
+/**
+ * maildir_scan_to_list - Create a Maildir list from a scan
+ * @param scan Scan results
+ * @param last Last Maildir, where the list is appended
+ *
+ * Files matched to an existing Email are skipped.
+ */
+static void maildir_scan_to_list(struct MdScan *scan, struct Maildir ***last)
+{
+  for (size_t i = 0; i < scan->num_files; i++)
+  {
+    struct MdFile *f = &scan->files[i];
+    if (f->flags & MD_SCAN_MATCHED)
+      continue;
+
+    struct Email *e = mutt_email_new();
+    maildir_scan_email(scan, f, e);
+    e->path = mutt_str_strdup(scan->names + f->path);
+
+    struct Maildir *entry = mutt_mem_calloc(1, sizeof(struct Maildir));
     entry->email = e;
-    entry->inode = de->d_ino;
+    entry->inode = f->inode;
     **last = entry;
     *last = &entry->next;
   }
+}
 
-  closedir(dirp);
+/**
+ * maildir_scan_free - Free the results of a scan
+ * @param scan Scan results
+ */
+static void maildir_scan_free(struct MdScan *scan)
+{
+  FREE(&scan->files);
+  FREE(&scan->names);
+  memset(scan, 0, sizeof(*scan));
+}
 
-  if (SigInt == 1)
+/**
+ * maildir_parse_dir - Read a Maildir mailbox
+ * @param m        Mailbox
+ * @param last     Last Maildir
+ * @param subdir   Subdirectory, e.g. 'new'
+ * @param count    Counter for the progress bar
+ * @param progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted
+ *
+ * The Maildir list is in inode order.
+ */
+static int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
+                             const char *subdir, int *count, struct Progress *progress)
+{
+  struct MdScan scan = { 0 };
+
+  int rc = maildir_scan_dir(m, subdir, &scan, count, progress);
+  if (rc == 0)
   {
-    SigInt = 0;
-    return -2; /* action aborted */
+    maildir_scan_sort(&scan);
+    maildir_scan_to_list(&scan, last);
   }
 
-cleanup:
-  mutt_buffer_pool_release(&buf);
-
+  maildir_scan_free(&scan);
   return rc;
 }
 
@@ -888,6 +1146,60 @@ static size_t maildir_hcache_keylen(const char *fn)
   const char *p = strrchr(fn, ':');
   return p ? (size_t)(p - fn) : mutt_str_strlen(fn);
 }
+
+/**
+ * mh_hcache_get - Get the Mailbox's header cache
+ * @param m Mailbox
+ * @retval ptr Header cache handle
+ *
+ * The header cache is opened on first use and kept open until the Mailbox is
+ * closed, so saving the MIME parts of many messages is cheap.
+ */
+static header_cache_t *mh_hcache_get(struct Mailbox *m)
+{
+  struct MaildirMboxData *mdata = maildir_mdata_get(m);
+  if (!mdata)
+    return NULL;
+
+  if (!mdata->hcache)
+    mdata->hcache = mutt_hcache_open(HeaderCache, m->path, NULL);
+  return mdata->hcache;
+}
+
+/**
+ * mh_hcache_release - Close the Mailbox's header cache
+ * @param m Mailbox
+ *
+ * This must be called before the header cache is opened elsewhere.
+ */
+static void mh_hcache_release(struct Mailbox *m)
+{
+  struct MaildirMboxData *mdata = maildir_mdata_get(m);
+  if (!mdata || !mdata->hcache)
+    return;
+
+  mutt_hcache_close(mdata->hcache);
+  mdata->hcache = NULL;
+}
+
+/**
+ * mh_hcache_key - Get the header cache key of an Email
+ * @param[in]  m      Mailbox
+ * @param[in]  e      Email
+ * @param[out] keylen Length of the key
+ * @retval ptr Key
+ */
+static const char *mh_hcache_key(struct Mailbox *m, struct Email *e, size_t *keylen)
+{
+  if (m->magic == MUTT_MH)
+  {
+    *keylen = strlen(e->path);
+    return e->path;
+  }
+
+  *keylen = maildir_hcache_keylen(e->path + 3);
+  return e->path + 3;
+}
 #endif
 
 /**
@@ -900,7 +1212,7 @@ static size_t maildir_hcache_keylen(const char *fn)
  */
 static int md_cmp_inode(struct Maildir *a, struct Maildir *b)
 {
-  return a->inode - b->inode;
+  return (a->inode > b->inode) - (a->inode < b->inode);
 }
 
 /**
@@ -1113,6 +1425,7 @@ static void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md,
 #endif
 
 #ifdef USE_HCACHE
+  mh_hcache_release(m);
   header_cache_t *hc = mutt_hcache_open(HeaderCache, m->path, NULL);
 #endif
 
@@ -1129,15 +1442,21 @@ static void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md,
 
     if (!sort)
     {
-      mutt_debug(4, "maildir: need to sort %s by inode\n", m->path);
-      p = maildir_sort(p, (size_t) -1, md_cmp_inode);
-      if (!last)
-        *md = p;
-      else
-        last->next = p;
       sort = true;
-      p = skip_duplicates(p, &last);
-      snprintf(fn, sizeof(fn), "%s/%s", m->path, p->email->path);
+      /* maildir_parse_dir() has usually sorted the list already */
+      struct Maildir *q = p;
+      while (q->next && (md_cmp_inode(q, q->next) <= 0))
+        q = q->next;
+      if (q->next)
+      {
+        mutt_debug(4, "maildir: need to sort %s by inode\n", m->path);
+        p = maildir_sort(p, (size_t) -1, md_cmp_inode);
+        if (!last)
+          *md = p;
+        else
+          last->next = p;
+        p = skip_duplicates(p, &last);
+      }
     }
 
     snprintf(fn, sizeof(fn), "%s/%s", m->path, p->email->path);
@@ -2093,6 +2412,7 @@ int mh_sync_mailbox_message(struct Context *ctx, int msgno)
           keylen = maildir_hcache_keylen(key);
         }
         mutt_hcache_delete(hc, key, keylen);
+        mutt_hcache_delete_parts(hc, key, keylen);
       }
 #endif
       unlink(path);
@@ -2398,6 +2718,144 @@ static int maildir_mbox_open_append(struct Context *ctx, int flags)
   return 0;
 }
 
+#ifdef USE_INOTIFY
+/**
+ * maildir_check_events - Apply the file events of the monitor to a Maildir
+ * @param ctx        Mailbox
+ * @param index_hint Current email in index
+ * @param events     Files that appeared or vanished, see mutt_monitor_context_events()
+ * @retval num Same as maildir_mbox_check()
+ *
+ * This is a cheaper version of the scan in maildir_mbox_check().  Only the
+ * files named by the events are considered, rather than every file in new/
+ * and cur/.  A flag change shows up as a file vanishing and one with the same
+ * canonical name appearing.
+ */
+static int maildir_check_events(struct Context *ctx, int *index_hint,
+                                struct MonitorEventList *events)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct Maildir *md = NULL; /* the final state of each file named */
+  struct Maildir **last = &md;
+  struct Maildir *p = NULL;
+  struct Hash *fnames = NULL;
+  struct Hash *existing = NULL;
+  bool occult = false;
+  bool flags_changed = false;
+  int count = 0;
+
+  struct MonitorEvent *me = NULL;
+  STAILQ_FOREACH(me, events, entries)
+  {
+    count++;
+  }
+  if (count == 0)
+    return 0;
+  mutt_debug(2, "%d file events for %s\n", count, m->path);
+
+  struct Buffer *buf = mutt_buffer_pool_get();
+  fnames = mutt_hash_create(count, 0);
+
+  /* collapse the events into the final state of each file */
+  STAILQ_FOREACH(me, events, entries)
+  {
+    maildir_canon_filename(buf, me->path);
+    p = mutt_hash_find(fnames, mutt_b2s(buf));
+    if (!p)
+    {
+      p = mutt_mem_calloc(1, sizeof(struct Maildir));
+      p->canon_fname = mutt_str_strdup(mutt_b2s(buf));
+      mutt_hash_insert(fnames, p->canon_fname, p);
+      *last = p;
+      last = &p->next;
+    }
+
+    if (me->added)
+    {
+      if (p->email)
+        mutt_email_free(&p->email);
+      p->email = mutt_email_new();
+      p->email->old = MarkOld ? (mutt_str_strncmp(me->path, "cur/", 4) == 0) : false;
+      maildir_parse_flags(p->email, me->path);
+      p->email->path = mutt_str_strdup(me->path);
+    }
+    else
+    {
+      if (p->email && (mutt_str_strcmp(p->email->path, me->path) == 0))
+        mutt_email_free(&p->email);
+    }
+  }
+
+  /* Every file named may already be one of ours: a removal, a rename, or an
+   * add that a fallback rescan has already picked up. */
+  existing = mutt_hash_create(m->msg_count, MUTT_HASH_STRDUP_KEYS);
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    maildir_canon_filename(buf, m->hdrs[i]->path);
+    mutt_hash_insert(existing, mutt_b2s(buf), m->hdrs[i]);
+  }
+
+  for (p = md; p; p = p->next)
+  {
+    struct Email *e = mutt_hash_find(existing, p->canon_fname);
+    if (!e)
+      continue;
+
+    if (!p->email)
+    {
+      /* this message vanished */
+      if (!occult)
+      {
+        for (int i = 0; i < m->msg_count; i++)
+          m->hdrs[i]->active = true;
+        occult = true;
+      }
+      e->active = false;
+      continue;
+    }
+
+    /* the message was renamed, merge its flags, as maildir_mbox_check() does */
+    if (mutt_str_strcmp(e->path, p->email->path) != 0)
+      mutt_str_replace(&e->path, p->email->path);
+
+    if (!e->changed)
+      if (maildir_update_flags(ctx, e, p->email))
+        flags_changed = true;
+
+    if (e->deleted == e->trash)
+    {
+      if (e->deleted != p->email->deleted)
+      {
+        e->deleted = p->email->deleted;
+        flags_changed = true;
+      }
+    }
+    e->trash = p->email->trash;
+
+    mutt_email_free(&p->email);
+  }
+
+  mutt_hash_destroy(&existing);
+  mutt_hash_destroy(&fnames);
+  mutt_buffer_pool_release(&buf);
+
+  if (occult)
+    maildir_update_tables(ctx, index_hint);
+
+  /* parse and add the new messages */
+  maildir_delayed_parsing(m, &md, NULL);
+  int have_new = maildir_move_to_context(ctx, &md);
+
+  if (occult)
+    return MUTT_REOPENED;
+  if (have_new)
+    return MUTT_NEW_MAIL;
+  if (flags_changed)
+    return MUTT_FLAGS;
+  return 0;
+}
+#endif
+
 /**
  * maildir_mbox_check - Implements MxOps::mbox_check()
  *
@@ -2418,7 +2876,8 @@ static int maildir_mbox_check(struct Context *ctx, int *index_hint)
   int have_new = 0;           /* messages were added to the mailbox */
   bool flags_changed = false; /* message flags were changed in the mailbox */
   struct Maildir *md = NULL;  /* list of messages in the mailbox */
-  struct Maildir **last = NULL, *p = NULL;
+  struct Maildir **last = &md;
+  struct MdScan scan = { 0 }; /* files in the subdirectories that changed */
   int count = 0;
   struct Hash *fnames = NULL; /* hash table for quickly looking up the base filename
                                  for a maildir message */
@@ -2443,6 +2902,22 @@ static int maildir_mbox_check(struct Context *ctx, int *index_hint)
     return -1;
   }
 
+#ifdef USE_INOTIFY
+  /* If the monitor has tracked every file change, there's no need to scan */
+  struct MonitorEventList events = STAILQ_HEAD_INITIALIZER(events);
+  if ((ctx == Context) && (mutt_monitor_context_events(&events) == 0))
+  {
+    mutt_buffer_pool_release(&buf);
+    MonitorContextChanged = 0;
+    mutt_get_stat_timespec(&mdata->mtime_cur, &st_cur, MUTT_STAT_MTIME);
+    mutt_get_stat_timespec(&ctx->mailbox->mtime, &st_new, MUTT_STAT_MTIME);
+
+    int rc = maildir_check_events(ctx, index_hint, &events);
+    mutt_monitor_events_free(&events);
+    return rc;
+  }
+#endif
+
   /* determine which subdirectories need to be scanned */
   if (mutt_stat_timespec_compare(&st_new, MUTT_STAT_MTIME, &ctx->mailbox->mtime) > 0)
     changed = 1;
@@ -2474,12 +2949,10 @@ static int maildir_mbox_check(struct Context *ctx, int *index_hint)
   /* do a fast scan of just the filenames in
    * the subdirectories that have changed.
    */
-  md = NULL;
-  last = &md;
   if (changed & 1)
-    maildir_parse_dir(ctx->mailbox, &last, "new", &count, NULL);
+    maildir_scan_dir(ctx->mailbox, "new", &scan, &count, NULL);
   if (changed & 2)
-    maildir_parse_dir(ctx->mailbox, &last, "cur", &count, NULL);
+    maildir_scan_dir(ctx->mailbox, "cur", &scan, &count, NULL);
 
   /* we create a hash table keyed off the canonical (sans flags) filename
    * of each message we scanned.  This is used in the loop over the
@@ -2487,49 +2960,48 @@ static int maildir_mbox_check(struct Context *ctx, int *index_hint)
    */
   fnames = mutt_hash_create(count, 0);
 
-  for (p = md; p; p = p->next)
-  {
-    maildir_canon_filename(buf, p->email->path);
-    p->canon_fname = mutt_str_strdup(mutt_b2s(buf));
-    mutt_hash_insert(fnames, p->canon_fname, p);
-  }
+  for (size_t j = 0; j < scan.num_files; j++)
+    mutt_hash_insert(fnames, scan.names + scan.files[j].canon, &scan.files[j]);
 
   /* check for modifications and adjust flags */
   for (int i = 0; i < ctx->mailbox->msg_count; i++)
   {
     ctx->mailbox->hdrs[i]->active = false;
     maildir_canon_filename(buf, ctx->mailbox->hdrs[i]->path);
-    p = mutt_hash_find(fnames, mutt_b2s(buf));
-    if (p && p->email)
+    struct MdFile *f = mutt_hash_find(fnames, mutt_b2s(buf));
+    if (f && !(f->flags & MD_SCAN_MATCHED))
     {
       /* message already exists, merge flags */
       ctx->mailbox->hdrs[i]->active = true;
+      f->flags |= MD_SCAN_MATCHED;
 
       /* check to see if the message has moved to a different
        * subdirectory.  If so, update the associated filename.
        */
-      if (mutt_str_strcmp(ctx->mailbox->hdrs[i]->path, p->email->path) != 0)
-        mutt_str_replace(&ctx->mailbox->hdrs[i]->path, p->email->path);
+      const char *path = scan.names + f->path;
+      if (mutt_str_strcmp(ctx->mailbox->hdrs[i]->path, path) != 0)
+        mutt_str_replace(&ctx->mailbox->hdrs[i]->path, path);
+
+      struct Email e = { 0 };
+      maildir_scan_email(&scan, f, &e);
 
       /* if the user hasn't modified the flags on this message, update
        * the flags we just detected.
        */
       if (!ctx->mailbox->hdrs[i]->changed)
-        if (maildir_update_flags(ctx, ctx->mailbox->hdrs[i], p->email))
+        if (maildir_update_flags(ctx, ctx->mailbox->hdrs[i], &e))
           flags_changed = true;
 
       if (ctx->mailbox->hdrs[i]->deleted == ctx->mailbox->hdrs[i]->trash)
       {
-        if (ctx->mailbox->hdrs[i]->deleted != p->email->deleted)
+        if (ctx->mailbox->hdrs[i]->deleted != e.deleted)
         {
-          ctx->mailbox->hdrs[i]->deleted = p->email->deleted;
+          ctx->mailbox->hdrs[i]->deleted = e.deleted;
           flags_changed = true;
         }
       }
-      ctx->mailbox->hdrs[i]->trash = p->email->trash;
-
-      /* this is a duplicate of an existing header, so remove it */
-      mutt_email_free(&p->email);
+      ctx->mailbox->hdrs[i]->trash = e.trash;
+      FREE(&e.maildir_flags);
     }
     /* This message was not in the list of messages we just scanned.
      * Check to see if we have enough information to know if the
@@ -2557,6 +3029,11 @@ static int maildir_mbox_check(struct Context *ctx, int *index_hint)
   /* destroy the file name hash */
   mutt_hash_destroy(&fnames);
 
+  /* only the files that didn't match an existing email are new */
+  maildir_scan_sort(&scan);
+  maildir_scan_to_list(&scan, &last);
+  maildir_scan_free(&scan);
+
   /* If we didn't just get new mail, update the tables. */
   if (occult)
     maildir_update_tables(ctx, index_hint);
@@ -2938,6 +3415,7 @@ static int mh_mbox_sync(struct Context *ctx, int *index_hint)
     return i;
 
 #ifdef USE_HCACHE
+  mh_hcache_release(ctx->mailbox);
   if (ctx->mailbox->magic == MUTT_MAILDIR || ctx->mailbox->magic == MUTT_MH)
     hc = mutt_hcache_open(HeaderCache, ctx->mailbox->path, NULL);
 #endif
@@ -3002,6 +3480,9 @@ err:
  */
 static int mh_mbox_close(struct Context *ctx)
 {
+#ifdef USE_HCACHE
+  mh_hcache_release(ctx->mailbox);
+#endif
   return 0;
 }
 
@@ -3041,6 +3522,58 @@ static int mh_msg_close(struct Context *ctx, struct Message *msg)
   return mutt_file_fclose(&msg->fp);
 }
 
+/**
+ * mh_msg_save_parts - Save a message's MIME parts to the header cache - Implements MxOps::msg_save_parts()
+ *
+ * This is used by both Maildir and MH.
+ */
+static int mh_msg_save_parts(struct Context *ctx, struct Email *e)
+{
+  int rc = 0;
+#ifdef USE_HCACHE
+  header_cache_t *hc = mh_hcache_get(ctx->mailbox);
+  if (!hc)
+    return -1;
+
+  size_t keylen;
+  const char *key = mh_hcache_key(ctx->mailbox, e, &keylen);
+  rc = mutt_hcache_store_parts(hc, key, keylen, e->content->parts, 0);
+#endif
+  return rc;
+}
+
+/**
+ * mh_msg_load_parts - Load a message's MIME parts from the header cache - Implements MxOps::msg_load_parts()
+ *
+ * This is used by both Maildir and MH.
+ */
+static int mh_msg_load_parts(struct Context *ctx, struct Email *e)
+{
+#ifdef USE_HCACHE
+  header_cache_t *hc = mh_hcache_get(ctx->mailbox);
+  if (!hc)
+    return -1;
+
+  size_t keylen;
+  const char *key = mh_hcache_key(ctx->mailbox, e, &keylen);
+  void *data = mutt_hcache_fetch_parts(hc, key, keylen);
+  if (!data)
+    return -1;
+
+  /* Like maildir_delayed_parsing(), ignore the entry if the file is newer */
+  struct stat st;
+  char fn[PATH_MAX];
+  snprintf(fn, sizeof(fn), "%s/%s", ctx->mailbox->path, e->path);
+  if (!MaildirHeaderCacheVerify ||
+      ((stat(fn, &st) == 0) && (st.st_mtime <= ((struct timeval *) data)->tv_sec)))
+  {
+    e->content->parts = mutt_hcache_restore_parts(data);
+  }
+  mutt_hcache_free(hc, &data);
+#endif
+  return e->content->parts ? 0 : -1;
+}
+
 /**
  * mh_path_probe - Is this an mh mailbox? - Implements MxOps::path_probe()
  */
@@ -3103,6 +3636,8 @@ struct MxOps mx_maildir_ops = {
   .msg_commit       = maildir_msg_commit,
   .msg_close        = mh_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = mh_msg_save_parts,
+  .msg_load_parts   = mh_msg_load_parts,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = maildir_path_probe,
@@ -3129,6 +3664,8 @@ struct MxOps mx_mh_ops = {
   .msg_commit       = mh_msg_commit,
   .msg_close        = mh_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = mh_msg_save_parts,
+  .msg_load_parts   = mh_msg_load_parts,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mh_path_probe,
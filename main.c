@@ -63,6 +63,7 @@
 #include "mutt_curses.h"
 #include "mutt_history.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_window.h"
 #include "muttlib.h"
 #include "mx.h"
@@ -786,6 +787,13 @@ int main(int argc, char *argv[], char *envp[])
     log_queue_set_max_size(100);
   }
 
+  /* Things to do while waiting for a key press */
+  mutt_poll_timer_add(mutt_mailbox_check_due, mutt_mailbox_check_timer,
+                      MUTT_POLL_TIMER_COMMAND);
+#ifdef USE_IMAP
+  mutt_poll_timer_add(imap_keepalive_due, imap_keepalive_timer, MUTT_POLL_TIMER_KEY);
+#endif
+
   /* Create the Folder directory if it doesn't exist. */
   if (!OptNoCurses && Folder)
   {
@@ -1129,7 +1137,7 @@ int main(int argc, char *argv[], char *envp[])
       bool passive = ImapPassive;
       ImapPassive = false;
 #endif
-      if (mutt_mailbox_check(0) == 0)
+      if (mutt_mailbox_check(MUTT_MAILBOX_CHECK_IMMEDIATE) == 0)
       {
         mutt_message(_("No mailbox with new mail"));
         goto main_curses; // TEST37: neomutt -Z (no new mail)
@@ -1240,11 +1248,15 @@ main_curses:
   if (repeat_error && ErrorBufMessage)
     puts(ErrorBuf);
 main_exit:
+  mutt_mailbox_check_cleanup();
   mutt_unlink_temp_attachments();
   mutt_list_free(&queries);
   crypto_module_free();
   mutt_window_free();
+  mutt_poll_free();
   mutt_buffer_pool_free();
+  mutt_ch_cache_cleanup();
+  mutt_addr_cache_cleanup();
   mutt_envlist_free();
   mutt_free_opts();
   mutt_free_keys();
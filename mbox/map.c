@@ -0,0 +1,501 @@
+/**
+ * @file
+ * Parse a memory-mapped mbox mailbox
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page mbox_map Parse a memory-mapped mbox mailbox
+ *
+ * Find the messages in a memory-mapped mbox mailbox and parse their headers.
+ * Large mailboxes are parsed by several threads.
+ *
+ * This code only needs the mapped file, so it can be tested on its own.  The
+ * caller collects the Emails and reports progress through callbacks.
+ */
+
+#include "config.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "map.h"
+
+/**
+ * mbox_count_lines - Count the lines in a block of text
+ * @param buf Text
+ * @param len Length of text
+ * @retval num Number of lines, including an unterminated last line
+ */
+static long mbox_count_lines(const char *buf, size_t len)
+{
+  long lines = 0;
+  const char *end = buf + len;
+
+  for (const char *p = buf; p < end; p++)
+  {
+    p = memchr(p, '\n', end - p);
+    if (!p)
+      return lines + 1;
+    lines++;
+  }
+
+  return lines;
+}
+
+/**
+ * mbox_map_is_from - Is there a message separator at this offset?
+ * @param[in]  map     Mapped mailbox
+ * @param[in]  pos     Offset of the start of a line
+ * @param[in]  size    Size of the mailbox
+ * @param[out] path    Return path from the separator
+ * @param[in]  pathlen Length of path
+ * @param[out] tp      Time from the separator
+ * @retval num Offset of the end of the separator line
+ * @retval 0   Not a message separator
+ */
+static LOFF_T mbox_map_is_from(const char *map, LOFF_T pos, LOFF_T size,
+                               char *path, size_t pathlen, time_t *tp)
+{
+  char buf[LONG_STRING];
+
+  if ((size - pos < 5) || (memcmp(map + pos, "From ", 5) != 0))
+    return 0;
+
+  const char *eol = memchr(map + pos, '\n', size - pos);
+  LOFF_T end = eol ? (eol - map + 1) : size;
+  size_t len = MIN(end - pos, sizeof(buf) - 1);
+  memcpy(buf, map + pos, len);
+  buf[len] = '\0';
+
+  if (!is_from(buf, path, pathlen, tp))
+    return 0;
+  return end;
+}
+
+/**
+ * mbox_map_next_from - Find the next message separator
+ * @param[in]  map     Mapped mailbox
+ * @param[in]  pos     Offset of the start of a line
+ * @param[in]  size    Size of the mailbox
+ * @param[out] path    Return path from the separator
+ * @param[in]  pathlen Length of path
+ * @param[out] tp      Time from the separator
+ * @retval num Offset of the separator, or size if there isn't one
+ *
+ * Only lines beginning with 'F' are examined.  memchr() is vectorised by the
+ * C library, so the bulk of the message bodies are skipped quickly.
+ */
+static LOFF_T mbox_map_next_from(const char *map, LOFF_T pos, LOFF_T size,
+                                 char *path, size_t pathlen, time_t *tp)
+{
+  if (mbox_map_is_from(map, pos, size, path, pathlen, tp) > 0)
+    return pos;
+
+  while (pos < size)
+  {
+    const char *f = memchr(map + pos + 1, 'F', size - pos - 1);
+    if (!f)
+      break;
+    pos = f - map;
+    if ((map[pos - 1] == '\n') && (mbox_map_is_from(map, pos, size, path, pathlen, tp) > 0))
+      return pos;
+  }
+
+  return size;
+}
+
+/**
+ * mbox_map_check_length - Does the Content-Length lead to a message separator?
+ * @param[in]  map     Mapped mailbox
+ * @param[in]  size    Size of the mailbox
+ * @param[in]  e       Email with parsed headers
+ * @param[out] path    Return path from the next separator
+ * @param[in]  pathlen Length of path
+ * @param[out] tp      Time from the next separator
+ * @retval num Offset of the next separator, or size if it's the last message
+ * @retval -1  The Content-Length is missing or wrong
+ *
+ * A wrong Content-Length is reset to -1.
+ */
+static LOFF_T mbox_map_check_length(const char *map, LOFF_T size, struct Email *e,
+                                    char *path, size_t pathlen, time_t *tp)
+{
+  if (e->content->length <= 0)
+    return -1;
+
+  /* The test below avoids a potential integer overflow if the
+   * content-length is huge (thus necessarily invalid). */
+  LOFF_T next = (e->content->length < size) ?
+                    (e->content->offset + e->content->length + 1) :
+                    -1;
+  if ((next == size) || ((next > 0) && (next < size) && (map[next - 1] == '\n') &&
+                         (mbox_map_is_from(map, next, size, path, pathlen, tp) > 0)))
+  {
+    return next;
+  }
+
+  mutt_debug(1, "bad content-length in message %d (cl=" OFF_T_FMT ")\n",
+             e->index, e->content->length);
+  e->content->length = -1;
+  return -1;
+}
+
+/**
+ * mbox_map_parse_serial - Read messages from a memory-mapped mailbox, one at a time
+ * @param[in]     mm  Mapped mailbox
+ * @param[in,out] pos Offset to start reading, then the offset reached
+ * @retval num Number of messages read
+ */
+static int mbox_map_parse_serial(struct MboxMap *mm, LOFF_T *pos)
+{
+  const char *map = mm->map;
+  LOFF_T size = mm->size;
+  char return_path[STRING];
+  time_t t;
+  int count = 0;
+
+  LOFF_T next = mbox_map_next_from(map, *pos, size, return_path, sizeof(return_path), &t);
+  while (next < size)
+  {
+    if (mm->progress && !mm->progress(count + 1, (int) (next / (size / 100 + 1)), mm->data))
+      break;
+    count++;
+
+    struct Email *e = mutt_email_new();
+    e->received = t - mutt_date_local_tz(t);
+    e->offset = next;
+    mm->add(e, mm->data);
+
+    LOFF_T hdr = mbox_map_is_from(map, next, size, return_path, sizeof(return_path), &t);
+    e->env = mutt_rfc822_parse_header(map + hdr, size - hdr, hdr, e, false, false);
+    LOFF_T body = MIN(e->content->offset, size);
+    if (body < 0)
+      body = size;
+
+    if (!e->env->return_path && return_path[0])
+      e->env->return_path = mutt_addr_parse_list(e->env->return_path, return_path);
+
+    if (!e->env->from)
+      e->env->from = mutt_addr_copy_list(e->env->return_path, false);
+
+    /* if the content-length is right, the next separator follows the body */
+    next = mbox_map_check_length(map, size, e, return_path, sizeof(return_path), &t);
+    if (next < 0)
+    {
+      next = mbox_map_next_from(map, body, size, return_path, sizeof(return_path), &t);
+      if (e->content->length < 0)
+        e->content->length = MAX(next - body - 1, 0);
+      if (!e->lines)
+      {
+        e->lines = mbox_count_lines(map + body, next - body);
+        if (e->lines > 0)
+          e->lines--;
+      }
+    }
+    else if (!e->lines)
+      e->lines = mbox_count_lines(map + body, e->content->length);
+  }
+
+  *pos = next;
+  return count;
+}
+
+#ifdef USE_PTHREADS
+#define MBOX_PARSE_THREADS 8          ///< Maximum number of threads parsing headers
+#define MBOX_PARSE_BATCH 256          ///< Number of messages a thread takes at once
+
+/**
+ * struct MboxSlot - A message separator found by mbox_parse_parallel()
+ */
+struct MboxSlot
+{
+  LOFF_T offset;       ///< Offset of the separator
+  struct Email *email; ///< Parsed headers, NULL until they've been parsed
+  int next;            ///< First separator after the headers
+  long lines;          ///< Lines between the headers and the next separator
+};
+
+/**
+ * struct MboxParse - Header parsing shared between threads
+ *
+ * The slots are handed out in batches, under the lock.  Each slot is only
+ * written by the thread that parses it.
+ */
+struct MboxParse
+{
+  const char *map;         ///< Mapped mailbox
+  LOFF_T size;             ///< Size of the mailbox
+  struct MboxSlot *slots;  ///< Separators, in file order
+  int num_slots;           ///< Number of separators
+  pthread_mutex_t lock;    ///< Protects next_slot, done and stop
+  int next_slot;           ///< First slot that hasn't been handed out
+  int done;                ///< Number of slots parsed
+  bool stop;               ///< The parse was interrupted
+};
+
+/**
+ * mbox_parse_slot - Parse the headers of one message
+ * @param mp Shared parsing state
+ * @param i  Index of the slot
+ *
+ * The message's length can't be known until its neighbours have been parsed,
+ * so the lines up to the next separator are counted in case it's needed.
+ */
+static void mbox_parse_slot(struct MboxParse *mp, int i)
+{
+  struct MboxSlot *slot = &mp->slots[i];
+  char return_path[STRING];
+  time_t t = 0;
+
+  LOFF_T hdr = mbox_map_is_from(mp->map, slot->offset, mp->size, return_path,
+                                sizeof(return_path), &t);
+
+  struct Email *e = mutt_email_new();
+  e->received = t - mutt_date_local_tz(t);
+  e->offset = slot->offset;
+
+  e->env = mutt_rfc822_parse_header(mp->map + hdr, mp->size - hdr, hdr, e, false, false);
+  LOFF_T body = MIN(e->content->offset, mp->size);
+  if (body < 0)
+    body = mp->size;
+
+  if (!e->env->return_path && return_path[0])
+    e->env->return_path = mutt_addr_parse_list(e->env->return_path, return_path);
+
+  if (!e->env->from)
+    e->env->from = mutt_addr_copy_list(e->env->return_path, false);
+
+  /* MH sometimes has the From_ line in the middle of the header */
+  int next = i + 1;
+  while ((next < mp->num_slots) && (mp->slots[next].offset < body))
+    next++;
+
+  if (!e->lines)
+  {
+    LOFF_T end = (next < mp->num_slots) ? mp->slots[next].offset : mp->size;
+    slot->lines = mbox_count_lines(mp->map + body, end - body);
+    if (slot->lines > 0)
+      slot->lines--;
+  }
+
+  slot->next = next;
+  slot->email = e;
+}
+
+/**
+ * mbox_parse_run - Parse batches of messages until there are none left
+ * @param mp Shared parsing state
+ * @param mm Mapped mailbox, to report progress to, or NULL
+ */
+static void mbox_parse_run(struct MboxParse *mp, struct MboxMap *mm)
+{
+  while (true)
+  {
+    pthread_mutex_lock(&mp->lock);
+    int first = mp->stop ? mp->num_slots : mp->next_slot;
+    mp->next_slot += MBOX_PARSE_BATCH;
+    pthread_mutex_unlock(&mp->lock);
+
+    if (first >= mp->num_slots)
+      break;
+
+    int last = MIN(first + MBOX_PARSE_BATCH, mp->num_slots);
+    for (int i = first; i < last; i++)
+      mbox_parse_slot(mp, i);
+
+    pthread_mutex_lock(&mp->lock);
+    mp->done += last - first;
+    int done = mp->done;
+    pthread_mutex_unlock(&mp->lock);
+
+    if (mm && mm->progress &&
+        !mm->progress(done, (int) (done * 100LL / mp->num_slots), mm->data))
+    {
+      pthread_mutex_lock(&mp->lock);
+      mp->stop = true;
+      pthread_mutex_unlock(&mp->lock);
+    }
+  }
+}
+
+/**
+ * mbox_parse_worker - Parse headers in a thread - Implements pthread start_routine
+ * @param arg Shared parsing state
+ * @retval NULL Always
+ */
+static void *mbox_parse_worker(void *arg)
+{
+  mbox_parse_run(arg, NULL);
+  return NULL;
+}
+
+/**
+ * mbox_map_parse_parallel - Read messages from a memory-mapped mailbox, using threads
+ * @param[in]     mm   Mapped mailbox
+ * @param[in,out] pos  Offset to start reading, then the offset reached
+ * @param[in]     want Number of threads to use, 0 for one per CPU
+ * @retval num Number of messages read
+ * @retval -1  Only one thread could be used, use mbox_map_parse_serial()
+ *
+ * First, every message separator is found.  Then the headers are parsed by
+ * several threads.  Finally, the messages are checked in file order against
+ * their Content-Length, like mbox_map_parse_serial() does.  Any separator that turns
+ * out to be inside a message is dropped.
+ */
+static int mbox_map_parse_parallel(struct MboxMap *mm, LOFF_T *pos, int want)
+{
+  const char *map = mm->map;
+  LOFF_T size = mm->size;
+  char return_path[STRING];
+  time_t t;
+
+  long cpus = (want > 0) ? want : sysconf(_SC_NPROCESSORS_ONLN);
+  int num_threads = MIN(cpus, MBOX_PARSE_THREADS);
+  if (num_threads < 2)
+    return -1;
+
+  struct MboxParse mp = { 0 };
+  mp.map = map;
+  mp.size = size;
+  pthread_mutex_init(&mp.lock, NULL);
+
+  int slots_len = 0;
+  for (LOFF_T off = mbox_map_next_from(map, *pos, size, return_path, sizeof(return_path), &t);
+       off < size;)
+  {
+    if (mp.num_slots == slots_len)
+    {
+      slots_len += 1024;
+      mutt_mem_realloc(&mp.slots, slots_len * sizeof(struct MboxSlot));
+    }
+    struct MboxSlot *slot = &mp.slots[mp.num_slots++];
+    memset(slot, 0, sizeof(*slot));
+    slot->offset = off;
+
+    LOFF_T eol = mbox_map_is_from(map, off, size, return_path, sizeof(return_path), &t);
+    off = mbox_map_next_from(map, eol, size, return_path, sizeof(return_path), &t);
+  }
+
+  /* The workers leave the signals to the UI thread */
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  pthread_t threads[MBOX_PARSE_THREADS];
+  int started = 0;
+  for (int i = 1; i < num_threads; i++)
+  {
+    if (pthread_create(&threads[started], NULL, mbox_parse_worker, &mp) == 0)
+      started++;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  mutt_debug(2, "parsing %d messages with %d threads\n", mp.num_slots, started + 1);
+
+  mbox_parse_run(&mp, mm);
+  for (int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  pthread_mutex_destroy(&mp.lock);
+
+  int count = 0;
+  int i = 0;
+  while ((i < mp.num_slots) && mp.slots[i].email)
+  {
+    struct Email *e = mp.slots[i].email;
+    mm->add(e, mm->data);
+
+    int next = mp.slots[i].next;
+    LOFF_T body = MIN(e->content->offset, size);
+    LOFF_T end = mbox_map_check_length(map, size, e, return_path, sizeof(return_path), &t);
+    if (end == size)
+      next = mp.num_slots;
+    else if (end > 0)
+    {
+      /* find the separator that the Content-Length leads to */
+      int lo = next, hi = mp.num_slots - 1;
+      while (lo < hi)
+      {
+        int mid = (lo + hi) / 2;
+        if (mp.slots[mid].offset < end)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      next = lo;
+    }
+
+    if (end < 0)
+    {
+      end = (next < mp.num_slots) ? mp.slots[next].offset : size;
+      if (e->content->length < 0)
+        e->content->length = MAX(end - body - 1, 0);
+      if (!e->lines)
+        e->lines = mp.slots[i].lines;
+    }
+    else if (!e->lines)
+      e->lines = mbox_count_lines(map + body, e->content->length);
+
+    /* drop any separators that were inside this message */
+    for (int j = i + 1; j < next; j++)
+      mutt_email_free(&mp.slots[j].email);
+
+    count++;
+    i = next;
+  }
+
+  /* after an interruption, forget anything that's been parsed since */
+  *pos = (i < mp.num_slots) ? mp.slots[i].offset : size;
+  for (; i < mp.num_slots; i++)
+    mutt_email_free(&mp.slots[i].email);
+
+  FREE(&mp.slots);
+  return count;
+}
+#endif
+
+/**
+ * mbox_map_parse - Read messages from a memory-mapped mailbox
+ * @param[in]     mm      Mapped mailbox
+ * @param[in,out] pos     Offset to start reading, then the offset reached
+ * @param[in]     threads Number of threads to use, 0 for one per CPU
+ * @retval num Number of messages read
+ *
+ * The result doesn't depend on how many threads were used.  Mailboxes smaller
+ * than #MBOX_PARSE_MIN_SIZE are always parsed by one thread.
+ */
+int mbox_map_parse(struct MboxMap *mm, LOFF_T *pos, int threads)
+{
+  int count = -1;
+#ifdef USE_PTHREADS
+  if ((threads != 1) && (mm->size - *pos >= MBOX_PARSE_MIN_SIZE))
+    count = mbox_map_parse_parallel(mm, pos, threads);
+#endif
+  if (count < 0)
+    count = mbox_map_parse_serial(mm, pos);
+
+  return count;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * Parse a memory-mapped mbox mailbox
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_MBOX_MAP_H
+#define MUTT_MBOX_MAP_H
+
+#include <stdbool.h>
+
+struct Email;
+
+#define MBOX_PARSE_MIN_SIZE (4 << 20) ///< Smaller mailboxes are parsed by one thread
+
+/**
+ * typedef mbox_add_t - Add a parsed Email to the Mailbox
+ * @param e    Email, in file order
+ * @param data Private data, see MboxMap
+ */
+typedef void (*mbox_add_t)(struct Email *e, void *data);
+
+/**
+ * typedef mbox_progress_t - Report the progress of a parse
+ * @param count   Number of messages parsed
+ * @param percent Percentage of the mailbox parsed
+ * @param data    Private data, see MboxMap
+ * @retval true  Carry on
+ * @retval false Stop, e.g. the user pressed Ctrl-C
+ */
+typedef bool (*mbox_progress_t)(int count, int percent, void *data);
+
+/**
+ * struct MboxMap - A memory-mapped mailbox to parse
+ */
+struct MboxMap
+{
+  const char *map;          ///< Mapped mailbox
+  LOFF_T size;              ///< Size of the mailbox
+  mbox_add_t add;           ///< Called for each message, in file order
+  mbox_progress_t progress; ///< Called as the parse progresses, may be NULL
+  void *data;               ///< Private data for the callbacks
+};
+
+int mbox_map_parse(struct MboxMap *mm, LOFF_T *pos, int threads);
+
+#endif /* MUTT_MBOX_MAP_H */
@@ -30,12 +30,14 @@
  */
 
 #include "config.h"
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -44,6 +46,7 @@
 #include "email/lib.h"
 #include "mutt.h"
 #include "mbox.h"
+#include "map.h"
 #include "account.h"
 #include "context.h"
 #include "copy.h"
@@ -172,6 +175,60 @@ static void mbox_unlock_mailbox(struct Mailbox *m)
   }
 }
 
+/**
+ * mbox_tail_save - Remember the bytes at the end of a mailbox
+ * @param m Mailbox
+ *
+ * The last few bytes before Mailbox::size are kept so that mbox_mbox_check()
+ * can prove that the mailbox has only been appended to.
+ */
+static void mbox_tail_save(struct Mailbox *m)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata)
+    return;
+
+  adata->tail_end = -1;
+  adata->tail_len = 0;
+  if (!adata->fp || (m->size < 0))
+    return;
+
+  LOFF_T start = MAX(m->size - MBOX_TAIL_LEN, 0);
+  size_t len = m->size - start;
+  if ((fseeko(adata->fp, start, SEEK_SET) != 0) ||
+      (fread(adata->tail, 1, len, adata->fp) != len))
+  {
+    mutt_debug(1, "couldn't read the end of %s\n", m->path);
+    return;
+  }
+
+  adata->tail_end = m->size;
+  adata->tail_len = len;
+}
+
+/**
+ * mbox_tail_check - Has the mailbox only been appended to?
+ * @param m Mailbox
+ * @retval true The bytes before the old end of the mailbox are unchanged
+ *
+ * The mailbox should be locked.
+ */
+static bool mbox_tail_check(struct Mailbox *m)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata || (adata->tail_end < 0) || (adata->tail_end != m->size))
+    return false;
+
+  char buf[MBOX_TAIL_LEN];
+  if ((fseeko(adata->fp, m->size - adata->tail_len, SEEK_SET) != 0) ||
+      (fread(buf, 1, adata->tail_len, adata->fp) != adata->tail_len))
+  {
+    return false;
+  }
+
+  return memcmp(buf, adata->tail, adata->tail_len) == 0;
+}
+
 /**
  * mmdf_parse_mailbox - Read a mailbox in MMDF format
  * @param ctx Mailbox
@@ -329,65 +386,112 @@ static int mmdf_parse_mailbox(struct Context *ctx)
     return -2; /* action aborted */
   }
 
+  mbox_tail_save(ctx->mailbox);
   return 0;
 }
 
 /**
- * mbox_parse_mailbox - Read a mailbox from disk
- * @param ctx Mailbox
- * @retval  0 Success
- * @retval -1 Error
- * @retval -2 Aborted
- *
- * Note that this function is also called when new mail is appended to the
- * currently open folder, and NOT just when the mailbox is initially read.
+ * struct MboxParseData - Private data for parsing a memory-mapped mailbox
+ */
+struct MboxParseData
+{
+  struct Mailbox *mailbox;   ///< Mailbox to fill
+  struct Progress *progress; ///< Progress bar, may be NULL
+};
+
+/**
+ * mbox_parse_add - Add a parsed Email to the Mailbox - Implements ::mbox_add_t
+ */
+static void mbox_parse_add(struct Email *e, void *data)
+{
+  struct Mailbox *m = ((struct MboxParseData *) data)->mailbox;
+
+  if (m->msg_count == m->hdrmax)
+    mx_alloc_memory(m);
+
+  e->index = m->msg_count;
+  m->hdrs[m->msg_count++] = e;
+}
+
+/**
+ * mbox_parse_progress - Report the progress of a parse - Implements ::mbox_progress_t
+ */
+static bool mbox_parse_progress(int count, int percent, void *data)
+{
+  struct MboxParseData *pd = data;
+
+  if (pd->progress)
+    mutt_progress_update(pd->progress, count, percent);
+
+  return SigInt != 1;
+}
+
+/**
+ * mbox_parse_mmap - Read messages from a memory-mapped mailbox
+ * @param ctx      Mailbox
+ * @param progress Progress bar, may be NULL
+ * @retval num Number of messages read
+ * @retval -1  The mailbox can't be mapped, use mbox_parse_stdio()
  *
- * NOTE: it is assumed that the mailbox being read has been locked before this
- * routine gets called.  Strange things could happen if it's not!
+ * The mailbox is read from the current position of its file.  Only the
+ * headers are parsed, the separators between the messages are found by
+ * searching the mapped file.
  */
-static int mbox_parse_mailbox(struct Context *ctx)
+static int mbox_parse_mmap(struct Context *ctx, struct Progress *progress)
 {
   struct MboxAccountData *adata = mbox_adata_get(ctx->mailbox);
-  if (!adata)
-    return -1;
-
   struct stat sb;
-  char buf[HUGE_STRING], return_path[STRING];
-  struct Email *curhdr = NULL;
-  time_t t;
-  int count = 0, lines = 0;
-  LOFF_T loc;
-  struct Progress progress;
 
-  /* Save information about the folder at the time we opened it. */
-  if (stat(ctx->mailbox->path, &sb) == -1)
+  LOFF_T pos = ftello(adata->fp);
+  LOFF_T size = ctx->mailbox->size;
+  int fd = fileno(adata->fp);
+  if ((pos < 0) || (pos >= size) || (fstat(fd, &sb) != 0) ||
+      !S_ISREG(sb.st_mode) || (sb.st_size < size))
   {
-    mutt_perror(ctx->mailbox->path);
     return -1;
   }
 
-  ctx->mailbox->size = sb.st_size;
-  mutt_get_stat_timespec(&ctx->mailbox->mtime, &sb, MUTT_STAT_MTIME);
-  mutt_get_stat_timespec(&adata->atime, &sb, MUTT_STAT_ATIME);
-
-  if (!ctx->mailbox->readonly)
-    ctx->mailbox->readonly = access(ctx->mailbox->path, W_OK) ? true : false;
-
-  if (!ctx->mailbox->quiet)
+  char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
   {
-    char msgbuf[STRING];
-    snprintf(msgbuf, sizeof(msgbuf), _("Reading %s..."), ctx->mailbox->path);
-    mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, ReadInc, 0);
+    mutt_debug(1, "mmap() failed, errno=%d %s\n", errno, strerror(errno));
+    return -1;
   }
 
-  if (!ctx->mailbox->hdrs)
-  {
-    /* Allocate some memory to get started */
-    ctx->mailbox->hdrmax = ctx->mailbox->msg_count;
-    ctx->mailbox->msg_count = 0;
-    ctx->mailbox->vcount = 0;
-    mx_alloc_memory(ctx->mailbox);
-  }
+  struct MboxParseData pd = { ctx->mailbox, progress };
+  struct MboxMap mm = {
+    .map = map,
+    .size = size,
+    .add = mbox_parse_add,
+    .progress = mbox_parse_progress,
+    .data = &pd,
+  };
+  int count = mbox_map_parse(&mm, &pos, 0);
+
+  munmap(map, size);
+
+  if (fseeko(adata->fp, pos, SEEK_SET) != 0)
+    mutt_debug(1, "#2 fseek() failed\n");
+
+  return count;
+}
+
+/**
+ * mbox_parse_stdio - Read messages from a mailbox, line by line
+ * @param ctx      Mailbox
+ * @param progress Progress bar, may be NULL
+ * @retval num Number of messages read
+ *
+ * The mailbox is read from the current position of its file.
+ */
+static int mbox_parse_stdio(struct Context *ctx, struct Progress *progress)
+{
+  struct MboxAccountData *adata = mbox_adata_get(ctx->mailbox);
+  char buf[HUGE_STRING], return_path[STRING];
+  struct Email *curhdr = NULL;
+  time_t t;
+  int count = 0, lines = 0;
+  LOFF_T loc;
 
   loc = ftello(adata->fp);
   while ((fgets(buf, sizeof(buf), adata->fp)) && (SigInt != 1))
@@ -410,9 +514,9 @@ static int mbox_parse_mailbox(struct Context *ctx)
 
       count++;
 
-      if (!ctx->mailbox->quiet)
+      if (progress)
       {
-        mutt_progress_update(&progress, count,
+        mutt_progress_update(progress, count,
                              (int) (ftello(adata->fp) / (ctx->mailbox->size / 100 + 1)));
       }
 
@@ -533,16 +637,76 @@ static int mbox_parse_mailbox(struct Context *ctx)
 
     if (!e->lines)
       e->lines = lines ? lines - 1 : 0;
+  }
 
-    mx_update_context(ctx, count);
+  return count;
+}
+
+/**
+ * mbox_parse_mailbox - Read a mailbox from disk
+ * @param ctx Mailbox
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted
+ *
+ * Note that this function is also called when new mail is appended to the
+ * currently open folder, and NOT just when the mailbox is initially read.
+ *
+ * NOTE: it is assumed that the mailbox being read has been locked before this
+ * routine gets called.  Strange things could happen if it's not!
+ */
+static int mbox_parse_mailbox(struct Context *ctx)
+{
+  struct MboxAccountData *adata = mbox_adata_get(ctx->mailbox);
+  if (!adata)
+    return -1;
+
+  struct stat sb;
+  struct Progress progress;
+
+  /* Save information about the folder at the time we opened it. */
+  if (stat(ctx->mailbox->path, &sb) == -1)
+  {
+    mutt_perror(ctx->mailbox->path);
+    return -1;
+  }
+
+  ctx->mailbox->size = sb.st_size;
+  mutt_get_stat_timespec(&ctx->mailbox->mtime, &sb, MUTT_STAT_MTIME);
+  mutt_get_stat_timespec(&adata->atime, &sb, MUTT_STAT_ATIME);
+
+  if (!ctx->mailbox->readonly)
+    ctx->mailbox->readonly = access(ctx->mailbox->path, W_OK) ? true : false;
+
+  if (!ctx->mailbox->quiet)
+  {
+    char msgbuf[STRING];
+    snprintf(msgbuf, sizeof(msgbuf), _("Reading %s..."), ctx->mailbox->path);
+    mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, ReadInc, 0);
   }
 
+  if (!ctx->mailbox->hdrs)
+  {
+    /* Allocate some memory to get started */
+    ctx->mailbox->hdrmax = ctx->mailbox->msg_count;
+    ctx->mailbox->msg_count = 0;
+    ctx->mailbox->vcount = 0;
+    mx_alloc_memory(ctx->mailbox);
+  }
+
+  int count = mbox_parse_mmap(ctx, ctx->mailbox->quiet ? NULL : &progress);
+  if (count < 0)
+    count = mbox_parse_stdio(ctx, ctx->mailbox->quiet ? NULL : &progress);
+  if (count > 0)
+    mx_update_context(ctx, count);
+
   if (SigInt == 1)
   {
     SigInt = 0;
     return -2; /* action aborted */
   }
 
+  mbox_tail_save(ctx->mailbox);
   return 0;
 }
 
@@ -1050,14 +1214,22 @@ static int mbox_mbox_check(struct Context *ctx, int *index_hint)
       }
 
       /* Check to make sure that the only change to the mailbox is that
-       * message(s) were appended to this file.  My heuristic is that we should
-       * see the message separator at *exactly* what used to be the end of the
-       * folder.
+       * message(s) were appended to this file.  The bytes before the old end
+       * of the folder must be unchanged and we should see the message
+       * separator at *exactly* what used to be the end of the folder.
        */
       char buffer[LONG_STRING];
-      if (fseeko(adata->fp, ctx->mailbox->size, SEEK_SET) != 0)
+      if (!mbox_tail_check(ctx->mailbox))
+      {
+        mutt_debug(1, "%s was modified, not just appended to\n", ctx->mailbox->path);
+        modified = true;
+      }
+      else if (fseeko(adata->fp, ctx->mailbox->size, SEEK_SET) != 0)
+      {
         mutt_debug(1, "#1 fseek() failed\n");
-      if (fgets(buffer, sizeof(buffer), adata->fp))
+        modified = true;
+      }
+      else if (fgets(buffer, sizeof(buffer), adata->fp))
       {
         if ((ctx->mailbox->magic == MUTT_MBOX && (mutt_str_strncmp("From ", buffer, 5) == 0)) ||
             (ctx->mailbox->magic == MUTT_MMDF && (mutt_str_strcmp(MMDF_SEP, buffer) == 0)))
@@ -1117,6 +1289,137 @@ static int mbox_mbox_check(struct Context *ctx, int *index_hint)
   return -1;
 }
 
+/**
+ * mbox_needs_rewrite - Does an email have to be rewritten to sync it?
+ * @param e Email
+ * @retval true The email must be rewritten
+ * @retval false Only the flags have changed, see mbox_update_status()
+ */
+static bool mbox_needs_rewrite(struct Email *e)
+{
+  return e->deleted || e->attach_del || e->xlabel_changed ||
+         (e->env && (e->env->refs_changed || e->env->irt_changed));
+}
+
+/**
+ * mbox_find_header - Find a header field in a block of headers
+ * @param[in]  hdr  Headers
+ * @param[in]  len  Length of the headers
+ * @param[in]  name Name of the field, including the colon, e.g. "Status:"
+ * @param[out] vlen Length of the field's value, up to the newline
+ * @retval >0 Offset of the field's value
+ * @retval  0 Field not found
+ * @retval -1 Field is repeated or folded, so it can't be updated in place
+ */
+static long mbox_find_header(const char *hdr, size_t len, const char *name, size_t *vlen)
+{
+  const size_t nlen = mutt_str_strlen(name);
+  const char *end = hdr + len;
+  long found = 0;
+
+  for (const char *line = hdr; line < end;)
+  {
+    const char *eol = memchr(line, '\n', end - line);
+    if (!eol)
+      eol = end;
+
+    if (((eol - line) >= nlen) && (mutt_str_strncasecmp(line, name, nlen) == 0))
+    {
+      if (found || ((eol + 1 < end) && ((eol[1] == ' ') || (eol[1] == '\t'))))
+        return -1;
+      found = (line - hdr) + nlen;
+      *vlen = (eol - line) - nlen;
+    }
+
+    line = eol + 1;
+  }
+
+  return found;
+}
+
+/**
+ * mbox_update_status - Update an email's flags without rewriting it
+ * @param fp File of the mailbox, opened for reading and writing
+ * @param e  Email
+ * @retval  0 Success, the Status: and X-Status: fields have been overwritten
+ * @retval -1 The fields are missing, or too short, the email must be rewritten
+ * @retval -2 Error
+ *
+ * The fields are overwritten with the same number of bytes, so the rest of
+ * the mailbox doesn't move.  NeoMutt pads the fields when it writes an email,
+ * see #CH_PAD_STATUS, so there's always room for the flags.
+ *
+ * No journal is needed: an interrupted write can only leave a mix of the old
+ * and new flags, in a field that's still valid.
+ */
+static int mbox_update_status(FILE *fp, struct Email *e)
+{
+  char status[3] = { 0 };
+  char xstatus[3] = { 0 };
+  size_t slen = 0;
+  size_t xlen = 0;
+  int rc = -1;
+
+  if (e->read)
+    mutt_str_strfcpy(status, "RO", sizeof(status));
+  else if (e->old)
+    mutt_str_strfcpy(status, "O", sizeof(status));
+
+  if (e->replied)
+    mutt_str_strcat(xstatus, sizeof(xstatus), "A");
+  if (e->flagged)
+    mutt_str_strcat(xstatus, sizeof(xstatus), "F");
+
+  const LOFF_T len = e->content->offset - e->offset;
+  if (len <= 0)
+    return -1;
+
+  char *hdr = mutt_mem_malloc(len);
+  if ((fseeko(fp, e->offset, SEEK_SET) != 0) || (fread(hdr, 1, len, fp) != (size_t) len))
+  {
+    rc = -2;
+    goto done;
+  }
+
+  long soff = mbox_find_header(hdr, len, "Status:", &slen);
+  long xoff = mbox_find_header(hdr, len, "X-Status:", &xlen);
+  if ((soff < 0) || (xoff < 0))
+    goto done;
+
+  /* The value is written with a leading space */
+  if (status[0] && (!soff || (slen <= strlen(status))))
+    goto done;
+  if (xstatus[0] && (!xoff || (xlen <= strlen(xstatus))))
+    goto done;
+
+  rc = -2;
+  if (soff)
+  {
+    memset(hdr + soff, ' ', slen);
+    memcpy(hdr + soff + 1, status, strlen(status));
+    if ((fseeko(fp, e->offset + soff, SEEK_SET) != 0) ||
+        (fwrite(hdr + soff, 1, slen, fp) != slen))
+    {
+      goto done;
+    }
+  }
+  if (xoff)
+  {
+    memset(hdr + xoff, ' ', xlen);
+    memcpy(hdr + xoff + 1, xstatus, strlen(xstatus));
+    if ((fseeko(fp, e->offset + xoff, SEEK_SET) != 0) ||
+        (fwrite(hdr + xoff, 1, xlen, fp) != xlen))
+    {
+      goto done;
+    }
+  }
+  rc = 0;
+
+done:
+  FREE(&hdr);
+  return rc;
+}
+
 /**
  * mbox_mbox_sync - Implements MxOps::mbox_sync()
  */
@@ -1185,28 +1488,73 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
     return -1;
   }
 
-  /* Create a temporary file to write the new version of the mailbox in. */
-  mutt_mktemp(tempfile, sizeof(tempfile));
-  i = open(tempfile, O_WRONLY | O_EXCL | O_CREAT, 0600);
-  if ((i == -1) || !(fp = fdopen(i, "w")))
+  /* Save the state of this folder. */
+  if (stat(ctx->mailbox->path, &statbuf) == -1)
   {
-    if (-1 != i)
+    mutt_perror(ctx->mailbox->path);
+    goto bail;
+  }
+
+  /* Emails whose flags are all that has changed are updated in place.  The
+   * mailbox only needs rewriting from the first email that needs more. */
+  int patched = 0;
+  for (i = 0; i < ctx->mailbox->msg_count; i++)
+  {
+    struct Email *e = ctx->mailbox->hdrs[i];
+    if (mbox_needs_rewrite(e))
+      break;
+    if (!e->changed)
+      continue;
+
+    int prc = mbox_update_status(adata->fp, e);
+    if (prc == -2)
     {
-      close(i);
-      unlink(tempfile);
+      mutt_perror(ctx->mailbox->path);
+      goto bail;
     }
-    mutt_error(_("Could not create temporary file"));
-    goto bail;
+    if (prc != 0)
+      break;
+    patched++;
   }
 
-  /* find the first deleted/changed message.  we save a lot of time by only
-   * rewriting the mailbox from the point where it has actually changed.
-   */
-  for (i = 0; (i < ctx->mailbox->msg_count) && !ctx->mailbox->hdrs[i]->deleted &&
-              !ctx->mailbox->hdrs[i]->changed && !ctx->mailbox->hdrs[i]->attach_del;
-       i++)
+  if ((i == ctx->mailbox->msg_count) && (patched > 0))
   {
+    mutt_debug(2, "updated %d emails in place\n", patched);
+    i = (fflush(adata->fp) == 0) ? 0 : -1;
+    mbox_unlock_mailbox(ctx->mailbox);
+    if ((mutt_file_fclose(&adata->fp) != 0) || (i == -1))
+    {
+      mutt_sig_unblock();
+      mx_fastclose_mailbox(ctx);
+      mutt_perror(ctx->mailbox->path);
+      return -1;
+    }
+
+    mbox_reset_atime(ctx->mailbox, &statbuf);
+
+    adata->fp = fopen(ctx->mailbox->path, "r");
+    mutt_sig_unblock();
+    if (!adata->fp)
+    {
+      mx_fastclose_mailbox(ctx);
+      mutt_error(_("Fatal error!  Could not reopen mailbox!"));
+      return -1;
+    }
+    mbox_tail_save(ctx->mailbox);
+
+    if (CheckMboxSize)
+    {
+      tmp = mutt_find_mailbox(ctx->mailbox->path);
+      if (tmp && !tmp->has_new)
+        mutt_update_mailbox(tmp);
+    }
+
+    return 0;
   }
+
+  /* i is the first email that has to be rewritten.  we save a lot of time by
+   * only rewriting the mailbox from the point where it has actually changed.
+   */
   if (i == ctx->mailbox->msg_count)
   {
     /* this means ctx->changed or ctx->deleted was set, but no
@@ -1216,7 +1564,6 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
     mutt_error(
         _("sync: mbox modified, but no modified messages (report this bug)"));
     mutt_debug(1, "no modified messages.\n");
-    unlink(tempfile);
     goto bail;
   }
 
@@ -1231,6 +1578,20 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
   if (ctx->mailbox->magic == MUTT_MMDF)
     offset -= (sizeof(MMDF_SEP) - 1);
 
+  /* Create a temporary file to write the new version of the mailbox in. */
+  mutt_mktemp(tempfile, sizeof(tempfile));
+  i = open(tempfile, O_WRONLY | O_EXCL | O_CREAT, 0600);
+  if ((i == -1) || !(fp = fdopen(i, "w")))
+  {
+    if (-1 != i)
+    {
+      close(i);
+      unlink(tempfile);
+    }
+    mutt_error(_("Could not create temporary file"));
+    goto bail;
+  }
+
   /* allocate space for the new offsets */
   new_offset = mutt_mem_calloc(ctx->mailbox->msg_count - first, sizeof(struct MUpdate));
   old_offset = mutt_mem_calloc(ctx->mailbox->msg_count - first, sizeof(struct MUpdate));
@@ -1278,7 +1639,7 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
       new_offset[i - first].hdr = ftello(fp) + offset;
 
       if (mutt_copy_message_ctx(fp, ctx, ctx->mailbox->hdrs[i], MUTT_CM_UPDATE,
-                                CH_FROM | CH_UPDATE | CH_UPDATE_LEN) != 0)
+                                CH_FROM | CH_UPDATE | CH_UPDATE_LEN | CH_PAD_STATUS) != 0)
       {
         mutt_perror(tempfile);
         unlink(tempfile);
@@ -1326,14 +1687,6 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
   }
   fp = NULL;
 
-  /* Save the state of this folder. */
-  if (stat(ctx->mailbox->path, &statbuf) == -1)
-  {
-    mutt_perror(ctx->mailbox->path);
-    unlink(tempfile);
-    goto bail;
-  }
-
   fp = fopen(tempfile, "r");
   if (!fp)
   {
@@ -1442,6 +1795,7 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
   FREE(&old_offset);
   unlink(tempfile); /* remove partial copy of the mailbox */
   mutt_sig_unblock();
+  mbox_tail_save(ctx->mailbox);
 
   if (CheckMboxSize)
   {
@@ -1769,6 +2123,8 @@ struct MxOps mx_mbox_ops = {
   .msg_commit       = mbox_msg_commit,
   .msg_close        = mbox_msg_close,
   .msg_padding_size = mbox_msg_padding_size,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mbox_path_probe,
@@ -1795,6 +2151,8 @@ struct MxOps mx_mmdf_ops = {
   .msg_commit       = mmdf_msg_commit,
   .msg_close        = mbox_msg_close,
   .msg_padding_size = mmdf_msg_padding_size,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mbox_path_probe,
@@ -28,6 +28,7 @@
  *
  * | File        | Description        |
  * | :---------- | :----------------- |
+ * | mbox/map.c  | @subpage mbox_map  |
  * | mbox/mbox.c | @subpage mbox_mbox |
  */
 
@@ -35,17 +36,25 @@
 #define MUTT_MBOX_MBOX_H
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
 
 struct Mailbox;
 struct stat;
 
+#define MBOX_TAIL_LEN 256 ///< Number of bytes before EOF that are remembered
+
 /**
  * struct MboxAccountData - Private Account data
  */
 struct MboxAccountData
 {
-  FILE *fp;              /**< Mailbox file */
-  struct timespec atime; /**< File's last-access time */
+  FILE *fp;                 /**< Mailbox file */
+  struct timespec atime;    /**< File's last-access time */
+  off_t tail_end;           /**< Mailbox size when the tail was saved */
+  size_t tail_len;          /**< Length of tail */
+  char tail[MBOX_TAIL_LEN]; /**< Last bytes of the mailbox, see mbox_tail_save() */
 
   bool locked : 1; /**< is the mailbox locked? */
   bool append : 1; /**< mailbox is opened in append mode */
@@ -21,9 +21,9 @@
  */
 
 #include "config.h"
+#include <dirent.h>
 #include <errno.h>
 #include <limits.h>
-#include <poll.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -34,10 +34,11 @@
 #include "mutt/mutt.h"
 #include "monitor.h"
 #include "context.h"
-#include "curs_lib.h"
 #include "globals.h"
 #include "mailbox.h"
 #include "mutt_curses.h"
+#include "muttlib.h"
+#include "mutt_poll.h"
 #include "mx.h"
 
 int MonitorFilesChanged = 0;
@@ -45,15 +46,22 @@ int MonitorContextChanged = 0;
 
 static int INotifyFd = -1;
 static struct Monitor *Monitor = NULL;
-static size_t PollFdsCount = 0;
-static size_t PollFdsLen = 0;
-static struct pollfd *PollFds = NULL;
 
 static int MonitorContextDescriptor = -1;
 
-#define INOTIFY_MASK_DIR (IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR)
+/* Maildir only: the cur/ watch and the file events of the current mailbox */
+static int MonitorContextCurDescriptor = -1;
+static struct MonitorEventList MonitorContextEvents =
+    STAILQ_HEAD_INITIALIZER(MonitorContextEvents);
+static size_t MonitorContextEventsCount = 0;
+static bool MonitorContextEventsLost = true;
+
+#define INOTIFY_MASK_DELTA (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#define INOTIFY_MASK_DIR (IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR | INOTIFY_MASK_DELTA)
 #define INOTIFY_MASK_FILE IN_CLOSE_WRITE
 
+#define MONITOR_EVENTS_MAX 10000 ///< Give up queueing events, rescan the mailbox instead
+
 #define EVENT_BUFLEN MAX(4096, sizeof(struct inotify_event) + NAME_MAX + 1)
 
 #define RESOLVERES_FAIL_NOMAILBOX -3
@@ -73,6 +81,19 @@ struct Monitor
   ino_t st_ino;
   enum MailboxType magic;
   int desc;
+
+  /* Maildir only: counters kept up to date from the events */
+  char *maildir_path;   ///< Path of the Maildir
+  int cur_desc;         ///< Watch descriptor of cur/
+  bool counted;         ///< The counters are valid
+  int msg_count;        ///< Number of messages
+  int msg_unread;       ///< Number of unread messages
+  int msg_flagged;      ///< Number of flagged messages
+  int new_unread;       ///< Number of unread messages in new/
+  int cur_unread;       ///< Number of unread messages in cur/
+  struct Hash *recent;  ///< Unread files, e.g. "new/123.host", with their arrival time
+  uint32_t moved_cookie; ///< inotify cookie of the last file moved away
+  time_t moved_arrival;  ///< Arrival time of the last file moved away, 0 if not recent
 };
 
 /**
@@ -89,73 +110,6 @@ struct MonitorInfo
   char path_buf[PATH_MAX]; /* access via path only (maybe not initialized) */
 };
 
-/**
- * mutt_poll_fd_add - Add a file to the watch list
- * @param fd     File to watch
- * @param events Events to listen for, e.g. POLLIN
- */
-static void mutt_poll_fd_add(int fd, short events)
-{
-  int i = 0;
-  for (; (i < PollFdsCount) && (PollFds[i].fd != fd); ++i)
-    ;
-
-  if (i == PollFdsCount)
-  {
-    if (PollFdsCount == PollFdsLen)
-    {
-      PollFdsLen += 2;
-      mutt_mem_realloc(&PollFds, PollFdsLen * sizeof(struct pollfd));
-    }
-    PollFdsCount++;
-    PollFds[i].fd = fd;
-    PollFds[i].events = events;
-  }
-  else
-    PollFds[i].events |= events;
-}
-
-/**
- * mutt_poll_fd_remove - Remove a file from the watch list
- * @param fd File to remove
- * @retval  0 Success
- * @retval -1 Error
- */
-static int mutt_poll_fd_remove(int fd)
-{
-  int i = 0;
-  for (; (i < PollFdsCount) && (PollFds[i].fd != fd); ++i)
-    ;
-  if (i == PollFdsCount)
-    return -1;
-  int d = PollFdsCount - i - 1;
-  if (d != 0)
-    memmove(&PollFds[i], &PollFds[i + 1], d * sizeof(struct pollfd));
-  PollFdsCount--;
-  return 0;
-}
-
-/**
- * monitor_init - Set up file monitoring
- * @retval  0 Success
- * @retval -1 Error
- */
-static int monitor_init(void)
-{
-  if (INotifyFd == -1)
-  {
-    INotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
-    if (INotifyFd == -1)
-    {
-      mutt_debug(2, "inotify_init1 failed, errno=%d %s\n", errno, strerror(errno));
-      return -1;
-    }
-    mutt_poll_fd_add(0, POLLIN);
-    mutt_poll_fd_add(INotifyFd, POLLIN);
-  }
-  return 0;
-}
-
 /**
  * monitor_check_free - Close down file monitoring
  */
@@ -163,7 +117,7 @@ static void monitor_check_free(void)
 {
   if (!Monitor && (INotifyFd != -1))
   {
-    mutt_poll_fd_remove(INotifyFd);
+    mutt_poll_remove(INotifyFd);
     close(INotifyFd);
     INotifyFd = -1;
     MonitorFilesChanged = 0;
@@ -183,9 +137,26 @@ static struct Monitor *monitor_create(struct MonitorInfo *info, int descriptor)
   monitor->st_dev = info->st_dev;
   monitor->st_ino = info->st_ino;
   monitor->desc = descriptor;
+  monitor->cur_desc = -1;
   monitor->next = Monitor;
   if (info->magic == MUTT_MH)
     monitor->mh_backup_path = mutt_str_strdup(info->path);
+  if (info->magic == MUTT_MAILDIR)
+  {
+    /* info->path is ".../new", so watch ".../cur" too */
+    char path[PATH_MAX];
+    monitor->maildir_path =
+        mutt_str_substr_dup(info->path, info->path + mutt_str_strlen(info->path) - 4);
+    snprintf(path, sizeof(path), "%s/cur", monitor->maildir_path);
+    monitor->cur_desc = inotify_add_watch(INotifyFd, path, INOTIFY_MASK_DIR);
+    if (monitor->cur_desc == -1)
+    {
+      mutt_debug(2, "inotify_add_watch failed for '%s', errno=%d %s\n", path,
+                 errno, strerror(errno));
+    }
+    else
+      mutt_debug(3, "inotify_add_watch descriptor=%d for '%s'\n", monitor->cur_desc, path);
+  }
 
   Monitor = monitor;
 
@@ -212,7 +183,14 @@ static void monitor_delete(struct Monitor *monitor)
     ptr = &(*ptr)->next;
   }
 
+  if (monitor->cur_desc != -1)
+  {
+    inotify_rm_watch(INotifyFd, monitor->cur_desc);
+    mutt_debug(3, "inotify_rm_watch descriptor=%d\n", monitor->cur_desc);
+  }
+  mutt_hash_destroy(&monitor->recent);
   FREE(&monitor->mh_backup_path);
+  FREE(&monitor->maildir_path);
   monitor = monitor->next;
   FREE(ptr);
   *ptr = monitor;
@@ -338,89 +316,260 @@ static int monitor_resolve(struct MonitorInfo *info, struct Mailbox *m)
 }
 
 /**
- * mutt_monitor_poll - Check for filesystem changes
- * @retval -3 unknown/unexpected events: poll timeout / fds not handled by us
- * @retval -2 monitor detected changes, no STDIN input
- * @retval -1 error (see errno)
- * @retval  0 (1) input ready from STDIN, or (2) monitoring inactive -> no poll()
+ * monitor_context_lost - Forget the queued events of the current mailbox
  *
- * Wait for I/O ready file descriptors or signals.
- *
- * MonitorFilesChanged also reflects changes to monitored files.
- *
- * Only STDIN and INotify file handles currently expected/supported.
- * More would ask for common infrastructure (sockets?).
+ * Called when events may have been missed, e.g. the inotify queue overflowed.
+ * The next mutt_monitor_context_events() will ask for a full rescan.
  */
-int mutt_monitor_poll(void)
+static void monitor_context_lost(void)
 {
-  int rc = 0;
-  char buf[EVENT_BUFLEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+  mutt_monitor_events_free(&MonitorContextEvents);
+  MonitorContextEventsCount = 0;
+  MonitorContextEventsLost = true;
+}
+
+/**
+ * monitor_context_queue - Queue a file event of the current mailbox
+ * @param event inotify event
+ */
+static void monitor_context_queue(const struct inotify_event *event)
+{
+  if ((MonitorContextCurDescriptor == -1) || MonitorContextEventsLost)
+    return;
+  if ((event->len == 0) || (event->mask & IN_ISDIR) || !(event->mask & INOTIFY_MASK_DELTA))
+    return;
+  if (event->name[0] == '.')
+    return;
+
+  if (MonitorContextEventsCount >= MONITOR_EVENTS_MAX)
+  {
+    monitor_context_lost();
+    return;
+  }
 
-  MonitorFilesChanged = 0;
+  const char *subdir = (event->wd == MonitorContextCurDescriptor) ? "cur" : "new";
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s", subdir, event->name);
 
-  if (INotifyFd != -1)
+  struct MonitorEvent *me = mutt_mem_calloc(1, sizeof(struct MonitorEvent));
+  me->path = mutt_str_strdup(path);
+  me->added = (event->mask & (IN_CREATE | IN_MOVED_TO));
+  STAILQ_INSERT_TAIL(&MonitorContextEvents, me, entries);
+  MonitorContextEventsCount++;
+  mutt_debug(5, "queued %s %s\n", me->added ? "add" : "remove", me->path);
+}
+
+/**
+ * monitor_context_track - Watch the current Maildir for individual file changes
+ * @param monitor Monitor of the mailbox
+ */
+static void monitor_context_track(struct Monitor *monitor)
+{
+  monitor_context_lost();
+
+  if (!monitor || (monitor->magic != MUTT_MAILDIR))
+    return;
+
+  /* Anything that happened before now, will be found by a full scan */
+  MonitorContextCurDescriptor = monitor->cur_desc;
+}
+
+/**
+ * monitor_context_untrack - Stop watching the current Maildir for file changes
+ */
+static void monitor_context_untrack(void)
+{
+  MonitorContextCurDescriptor = -1;
+  monitor_context_lost();
+}
+
+/**
+ * monitor_find - Find the Monitor of a watch descriptor
+ * @param desc Watch descriptor, of new/ or cur/ for a Maildir
+ * @retval ptr Monitor
+ * @retval NULL Not found
+ */
+static struct Monitor *monitor_find(int desc)
+{
+  struct Monitor *iter = Monitor;
+  while (iter && (iter->desc != desc) && (iter->cur_desc != desc))
+    iter = iter->next;
+  return iter;
+}
+
+/**
+ * monitor_maildir_count_file - Count, or uncount, a file in a Maildir
+ * @param monitor Monitor of the Maildir
+ * @param path    Path relative to the Maildir, e.g. "new/123.host:2,S"
+ * @param arrival Time the file arrived, 0 if it isn't recent
+ * @param add     true to count the file, false if it has gone
+ */
+static void monitor_maildir_count_file(struct Monitor *monitor, const char *path,
+                                       time_t arrival, bool add)
+{
+  const char *name = strchr(path, '/') + 1;
+  if (*name == '.')
+    return;
+
+  const char *p = strstr(name, ":2,");
+  if (p && strchr(p + 3, 'T'))
+    return;
+
+  const int inc = add ? 1 : -1;
+  monitor->msg_count += inc;
+  if (p && strchr(p + 3, 'F'))
+    monitor->msg_flagged += inc;
+  if (p && strchr(p + 3, 'S'))
+    return;
+
+  monitor->msg_unread += inc;
+  if (path[0] == 'n')
+    monitor->new_unread += inc;
+  else
+    monitor->cur_unread += inc;
+
+  if (add)
   {
-    int fds = poll(PollFds, PollFdsLen, MuttGetchTimeout);
+    if (!MailCheckRecent || (arrival == 0))
+      return;
+    if (!monitor->recent)
+      monitor->recent = mutt_hash_create(64, MUTT_HASH_STRDUP_KEYS);
+    mutt_hash_insert(monitor->recent, path, (void *) (intptr_t) arrival);
+  }
+  else if (monitor->recent)
+    mutt_hash_delete(monitor->recent, path, NULL);
+}
+
+/**
+ * monitor_maildir_event - Update a Maildir's counters from an event
+ * @param monitor Monitor of the Maildir
+ * @param event   inotify event
+ */
+static void monitor_maildir_event(struct Monitor *monitor, const struct inotify_event *event)
+{
+  if (!monitor->counted || (event->len == 0) || (event->mask & IN_ISDIR))
+    return;
+
+  bool add = (event->mask & (IN_CREATE | IN_MOVED_TO));
+  if (!add && !(event->mask & (IN_DELETE | IN_MOVED_FROM)))
+    return;
+
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s",
+           (event->wd == monitor->cur_desc) ? "cur" : "new", event->name);
+
+  /* A rename, e.g. from new/ to cur/, arrives as a pair of events.  The file
+   * keeps the arrival time it had. */
+  time_t arrival = time(NULL);
+  if (event->mask & IN_MOVED_FROM)
+  {
+    monitor->moved_cookie = event->cookie;
+    monitor->moved_arrival =
+        monitor->recent ? (time_t)(intptr_t) mutt_hash_find(monitor->recent, path) : 0;
+  }
+  else if ((event->mask & IN_MOVED_TO) && (event->cookie != 0) &&
+           (event->cookie == monitor->moved_cookie))
+  {
+    arrival = monitor->moved_arrival;
+  }
 
-    if (fds == -1)
+  monitor_maildir_count_file(monitor, path, arrival, add);
+}
+
+/**
+ * monitor_read_events - Read and handle all the pending inotify events
+ */
+static void monitor_read_events(void)
+{
+  char buf[EVENT_BUFLEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+  const struct inotify_event *event = NULL;
+
+  while (true)
+  {
+    int len = read(INotifyFd, buf, sizeof(buf));
+    if (len == -1)
     {
-      rc = -1;
-      if (errno != EINTR)
-      {
-        mutt_debug(2, "poll() failed, errno=%d %s\n", errno, strerror(errno));
-      }
+      if (errno != EAGAIN)
+        mutt_debug(2, "read inotify events failed, errno=%d %s\n", errno, strerror(errno));
+      break;
     }
-    else
+
+    for (char *ptr = buf; ptr < (buf + len);
+         ptr += sizeof(struct inotify_event) + event->len)
     {
-      bool inputReady = false;
-      for (int i = 0; fds && (i < PollFdsCount); ++i)
+      event = (const struct inotify_event *) ptr;
+      mutt_debug(5, "+ detail: descriptor=%d mask=0x%x\n", event->wd, event->mask);
+      if (event->mask & IN_Q_OVERFLOW)
       {
-        if (PollFds[i].revents)
+        /* events were dropped, so the queue and counters can't be trusted */
+        monitor_context_lost();
+        MonitorContextChanged = 1;
+        for (struct Monitor *iter = Monitor; iter; iter = iter->next)
+          iter->counted = false;
+      }
+      else if (event->mask & IN_IGNORED)
+      {
+        if ((event->wd == MonitorContextDescriptor) || (event->wd == MonitorContextCurDescriptor))
+          monitor_context_lost();
+        if (event->wd == MonitorContextCurDescriptor)
+          MonitorContextCurDescriptor = -1;
+
+        struct Monitor *monitor = monitor_find(event->wd);
+        if (monitor && (monitor->cur_desc == event->wd))
         {
-          fds--;
-          if (PollFds[i].fd == 0)
-          {
-            inputReady = true;
-          }
-          else if (PollFds[i].fd == INotifyFd)
-          {
-            MonitorFilesChanged = 1;
-            mutt_debug(3, "file change(s) detected\n");
-            char *ptr = buf;
-            const struct inotify_event *event;
-
-            while (true)
-            {
-              int len = read(INotifyFd, buf, sizeof(buf));
-              if (len == -1)
-              {
-                if (errno != EAGAIN)
-                  mutt_debug(2, "read inotify events failed, errno=%d %s\n",
-                             errno, strerror(errno));
-                break;
-              }
-
-              while (ptr < (buf + len))
-              {
-                event = (const struct inotify_event *) ptr;
-                mutt_debug(5, "+ detail: descriptor=%d mask=0x%x\n", event->wd,
-                           event->mask);
-                if (event->mask & IN_IGNORED)
-                  monitor_handle_ignore(event->wd);
-                else if (event->wd == MonitorContextDescriptor)
-                  MonitorContextChanged = 1;
-                ptr += sizeof(struct inotify_event) + event->len;
-              }
-            }
-          }
+          /* cur/ has gone, the counters can't be trusted */
+          monitor->cur_desc = -1;
+          monitor->counted = false;
+        }
+        else
+          monitor_handle_ignore(event->wd);
+      }
+      else
+      {
+        struct Monitor *monitor = monitor_find(event->wd);
+        if (monitor && (monitor->magic == MUTT_MAILDIR))
+          monitor_maildir_event(monitor, event);
+
+        if ((event->wd == MonitorContextDescriptor) ||
+            (event->wd == MonitorContextCurDescriptor))
+        {
+          MonitorContextChanged = 1;
+          monitor_context_queue(event);
         }
       }
-      if (!inputReady)
-        rc = MonitorFilesChanged ? -2 : -3;
     }
   }
+}
 
-  return rc;
+/**
+ * monitor_poll_event - Handle activity on the inotify file descriptor - Implements ::poll_fd_t
+ */
+static int monitor_poll_event(int fd, void *data)
+{
+  MonitorFilesChanged = 1;
+  mutt_debug(3, "file change(s) detected\n");
+  monitor_read_events();
+  return 1;
+}
+
+/**
+ * monitor_init - Set up file monitoring
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int monitor_init(void)
+{
+  if (INotifyFd == -1)
+  {
+    INotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (INotifyFd == -1)
+    {
+      mutt_debug(2, "inotify_init1 failed, errno=%d %s\n", errno, strerror(errno));
+      return -1;
+    }
+    mutt_poll_add(INotifyFd, monitor_poll_event, NULL);
+  }
+  return 0;
 }
 
 /**
@@ -439,7 +588,10 @@ int mutt_monitor_add(struct Mailbox *m)
   if (desc != RESOLVERES_OK_NOTEXISTING)
   {
     if (!m && (desc == RESOLVERES_OK_EXISTING))
+    {
       MonitorContextDescriptor = info.monitor->desc;
+      monitor_context_track(info.monitor);
+    }
     return (desc == RESOLVERES_OK_EXISTING) ? 0 : -1;
   }
 
@@ -453,13 +605,219 @@ int mutt_monitor_add(struct Mailbox *m)
   }
 
   mutt_debug(3, "inotify_add_watch descriptor=%d for '%s'\n", desc, info.path);
+  struct Monitor *monitor = monitor_create(&info, desc);
+
   if (!m)
+  {
     MonitorContextDescriptor = desc;
+    monitor_context_track(monitor);
+  }
+
+  return 0;
+}
+
+/**
+ * mutt_monitor_context_events - Get the file changes in the current mailbox
+ * @param[out] events List to append the events to
+ * @retval  0 Success, the list holds every change since the last call
+ * @retval -1 Changes may have been missed, the mailbox must be rescanned
+ *
+ * Only Maildir mailboxes are tracked file by file.  Any pending inotify events
+ * are read first, so that the list is up to date.
+ *
+ * The caller should free the events with mutt_monitor_events_free().
+ */
+int mutt_monitor_context_events(struct MonitorEventList *events)
+{
+  if (MonitorContextCurDescriptor == -1)
+    return -1;
+
+  monitor_read_events();
+
+  if (MonitorContextEventsLost)
+  {
+    /* The caller's rescan brings the mailbox up to date again */
+    MonitorContextEventsLost = (MonitorContextCurDescriptor == -1);
+    return -1;
+  }
 
-  monitor_create(&info, desc);
+  STAILQ_CONCAT(events, &MonitorContextEvents);
+  MonitorContextEventsCount = 0;
   return 0;
 }
 
+/**
+ * monitor_maildir_count - Count the messages in a Maildir
+ * @param monitor Monitor of the Maildir
+ * @param m       Mailbox
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * This is only needed when the Maildir is first checked, or when events have
+ * been lost.  After that, the events keep the counters up to date.
+ */
+static int monitor_maildir_count(struct Monitor *monitor, struct Mailbox *m)
+{
+  static const char *const subdirs[] = { "new", "cur" };
+  int rc = 0;
+
+  /* Flush the queued events; they're already reflected by the directories */
+  monitor->counted = false;
+  monitor_read_events();
+
+  monitor->msg_count = 0;
+  monitor->msg_unread = 0;
+  monitor->msg_flagged = 0;
+  monitor->new_unread = 0;
+  monitor->cur_unread = 0;
+  mutt_hash_destroy(&monitor->recent);
+
+  struct Buffer *path = mutt_buffer_pool_get();
+  struct Buffer *msgpath = mutt_buffer_pool_get();
+
+  for (size_t i = 0; i < mutt_array_size(subdirs); i++)
+  {
+    mutt_buffer_printf(path, "%s/%s", m->path, subdirs[i]);
+    DIR *dirp = opendir(mutt_b2s(path));
+    if (!dirp)
+    {
+      rc = -1;
+      break;
+    }
+
+    struct dirent *de = NULL;
+    while ((de = readdir(dirp)))
+    {
+      if (*de->d_name == '.')
+        continue;
+
+      time_t arrival = 0;
+      const char *p = strstr(de->d_name, ":2,");
+      if (MailCheckRecent && !(p && strchr(p + 3, 'S')))
+      {
+        /* only messages received since the last visit are interesting */
+        struct stat sb;
+        mutt_buffer_printf(msgpath, "%s/%s", mutt_b2s(path), de->d_name);
+        if ((stat(mutt_b2s(msgpath), &sb) == 0) &&
+            (mutt_stat_timespec_compare(&sb, MUTT_STAT_CTIME, &m->last_visited) > 0))
+        {
+          arrival = sb.st_ctime;
+        }
+      }
+
+      mutt_buffer_printf(msgpath, "%s/%s", subdirs[i], de->d_name);
+      monitor_maildir_count_file(monitor, mutt_b2s(msgpath), arrival, true);
+    }
+    closedir(dirp);
+  }
+
+  mutt_buffer_pool_release(&path);
+  mutt_buffer_pool_release(&msgpath);
+
+  monitor->counted = (rc == 0) && (monitor->cur_desc != -1);
+  mutt_debug(3, "counted %s: %d messages, %d unread, %d flagged\n", m->path,
+             monitor->msg_count, monitor->msg_unread, monitor->msg_flagged);
+  return rc;
+}
+
+/**
+ * mutt_monitor_maildir_watched - Is the monitor keeping count of a Maildir?
+ * @param m Mailbox
+ * @retval true The Maildir's counts are kept up to date by inotify events
+ *
+ * Unlike mutt_monitor_maildir_check(), this doesn't touch the filesystem.
+ */
+bool mutt_monitor_maildir_watched(struct Mailbox *m)
+{
+  if (!m || (m->magic != MUTT_MAILDIR) || (INotifyFd == -1))
+    return false;
+
+  for (struct Monitor *iter = Monitor; iter; iter = iter->next)
+  {
+    if ((iter->cur_desc != -1) && (mutt_str_strcmp(iter->maildir_path, m->realpath) == 0))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * mutt_monitor_maildir_check - Check a Maildir for new mail, using the monitor
+ * @param m           Mailbox to check
+ * @param check_stats If true, also count the total, unread and flagged messages
+ * @retval  1 The mailbox has new mail
+ * @retval  0 No new mail
+ * @retval -1 The mailbox isn't monitored, it must be checked some other way
+ *
+ * The counters of a monitored Maildir are kept up to date by its inotify
+ * events, so only the first check (or one after events were lost) needs to
+ * read the directories.
+ */
+int mutt_monitor_maildir_check(struct Mailbox *m, bool check_stats)
+{
+  struct MonitorInfo info;
+
+  if (!m || (m->magic != MUTT_MAILDIR) || (INotifyFd == -1))
+    return -1;
+  if (monitor_resolve(&info, m) != RESOLVERES_OK_EXISTING)
+    return -1;
+
+  struct Monitor *monitor = info.monitor;
+  if (monitor->cur_desc == -1)
+    return -1;
+
+  /* bring the counters up to date */
+  monitor_read_events();
+  if (!monitor->counted && (monitor_maildir_count(monitor, m) != 0))
+    return -1;
+
+  bool has_new = false;
+  if (MailCheckRecent)
+  {
+    struct HashWalkState state = { 0 };
+    struct HashElem *he = NULL;
+    while (!has_new && monitor->recent && (he = mutt_hash_walk(monitor->recent, &state)))
+    {
+      if (((time_t)(intptr_t) he->data >= m->last_visited.tv_sec) &&
+          (MaildirCheckCur || (mutt_str_strncmp(he->key.strkey, "new/", 4) == 0)))
+      {
+        has_new = true;
+      }
+    }
+  }
+  else
+    has_new = (monitor->new_unread > 0) || (MaildirCheckCur && (monitor->cur_unread > 0));
+
+  if (has_new)
+    m->has_new = true;
+
+  if (check_stats)
+  {
+    m->msg_count = MAX(monitor->msg_count, 0);
+    m->msg_unread = MAX(monitor->msg_unread, 0);
+    m->msg_flagged = MAX(monitor->msg_flagged, 0);
+  }
+
+  return has_new ? 1 : 0;
+}
+
+/**
+ * mutt_monitor_events_free - Free a list of file events
+ * @param events List to free
+ */
+void mutt_monitor_events_free(struct MonitorEventList *events)
+{
+  struct MonitorEvent *me = STAILQ_FIRST(events);
+  while (me)
+  {
+    struct MonitorEvent *next = STAILQ_NEXT(me, entries);
+    FREE(&me->path);
+    FREE(&me);
+    me = next;
+  }
+  STAILQ_INIT(events);
+}
+
 /**
  * mutt_monitor_remove - Remove a watch for a mailbox
  * @param m Mailbox
@@ -475,6 +833,7 @@ int mutt_monitor_remove(struct Mailbox *m)
 
   if (!m)
   {
+    monitor_context_untrack();
     MonitorContextDescriptor = -1;
     MonitorContextChanged = 0;
   }
@@ -499,7 +858,7 @@ int mutt_monitor_remove(struct Mailbox *m)
     }
   }
 
-  inotify_rm_watch(info.monitor->desc, INotifyFd);
+  inotify_rm_watch(INotifyFd, info.monitor->desc);
   mutt_debug(3, "inotify_rm_watch for '%s' descriptor=%d\n", info.path,
              info.monitor->desc);
 
@@ -23,13 +23,30 @@
 #ifndef MUTT_MONITOR_H
 #define MUTT_MONITOR_H
 
+#include <stdbool.h>
+#include "mutt/queue.h"
+
 extern int MonitorFilesChanged;
 extern int MonitorContextChanged;
 
 struct Mailbox;
 
-int mutt_monitor_add(struct Mailbox *m);
-int mutt_monitor_remove(struct Mailbox *m);
-int mutt_monitor_poll(void);
+/**
+ * struct MonitorEvent - A file that appeared in, or vanished from, the current mailbox
+ */
+struct MonitorEvent
+{
+  char *path;  ///< Path relative to the mailbox, e.g. "new/1234.host"
+  bool added;  ///< true if the file appeared, false if it vanished
+  STAILQ_ENTRY(MonitorEvent) entries;
+};
+STAILQ_HEAD(MonitorEventList, MonitorEvent);
+
+int  mutt_monitor_add(struct Mailbox *m);
+int  mutt_monitor_context_events(struct MonitorEventList *events);
+int  mutt_monitor_maildir_check(struct Mailbox *m, bool check_stats);
+bool mutt_monitor_maildir_watched(struct Mailbox *m);
+void mutt_monitor_events_free(struct MonitorEventList *events);
+int  mutt_monitor_remove(struct Mailbox *m);
 
 #endif /* MUTT_MONITOR_H */
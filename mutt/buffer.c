@@ -25,6 +25,10 @@
  * @page buffer General purpose object for storing and parsing strings
  *
  * The Buffer object make parsing and manipulating strings easier.
+ *
+ * Short-lived Buffers can be borrowed from a pool, see mutt_buffer_pool_get().
+ * The pool may be used by several threads.  Each thread keeps a few Buffers of
+ * its own, so it only needs to lock the shared pool when it runs out.
  */
 
 #include "config.h"
@@ -32,6 +36,9 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "buffer.h"
 #include "logging.h"
 #include "memory.h"
@@ -41,6 +48,28 @@ static size_t BufferPoolCount = 0;
 static size_t BufferPoolLen = 0;
 static struct Buffer **BufferPool = NULL;
 
+#ifdef USE_PTHREADS
+#define BUFFER_CACHE_SIZE 8 ///< Number of Buffers each thread keeps
+
+/**
+ * struct BufferCache - A thread's private supply of Buffers
+ */
+struct BufferCache
+{
+  size_t count;                             ///< Number of Buffers in the cache
+  struct Buffer *bufs[BUFFER_CACHE_SIZE];   ///< Buffers ready for use
+};
+
+static pthread_mutex_t BufferPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t BufferCacheKey;
+static pthread_once_t BufferCacheOnce = PTHREAD_ONCE_INIT;
+#define pool_lock() pthread_mutex_lock(&BufferPoolLock)
+#define pool_unlock() pthread_mutex_unlock(&BufferPoolLock)
+#else
+#define pool_lock()
+#define pool_unlock()
+#endif
+
 /**
  * mutt_buffer_new - Create and initialise a Buffer
  * @retval ptr New Buffer
@@ -320,6 +349,8 @@ void mutt_buffer_increase_size(struct Buffer *buf, size_t new_size)
 
 /**
  * increase_buffer_pool - Increase the size of the Buffer pool
+ *
+ * @note The caller must hold the pool lock
  */
 static void increase_buffer_pool(void)
 {
@@ -334,19 +365,96 @@ static void increase_buffer_pool(void)
   }
 }
 
+/**
+ * pool_put - Return a Buffer to the shared pool
+ * @param buf Buffer
+ *
+ * @note The caller must hold the pool lock
+ */
+static void pool_put(struct Buffer *buf)
+{
+  if (BufferPoolCount >= BufferPoolLen)
+  {
+    mutt_debug(1, "Internal buffer pool error\n");
+    mutt_buffer_free(&buf);
+    return;
+  }
+
+  BufferPool[BufferPoolCount++] = buf;
+}
+
+#ifdef USE_PTHREADS
+/**
+ * cache_free - Return a thread's Buffers to the shared pool
+ * @param data BufferCache to free
+ *
+ * This is called when a thread exits, or the pool is freed.
+ */
+static void cache_free(void *data)
+{
+  struct BufferCache *bc = data;
+  if (!bc)
+    return;
+
+  pool_lock();
+  while (bc->count)
+    pool_put(bc->bufs[--bc->count]);
+  pool_unlock();
+
+  FREE(&bc);
+}
+
+/**
+ * cache_key_create - Create the key for the threads' Buffer caches
+ */
+static void cache_key_create(void)
+{
+  pthread_key_create(&BufferCacheKey, cache_free);
+}
+
+/**
+ * get_cache - Get the current thread's Buffer cache
+ * @retval ptr BufferCache
+ */
+static struct BufferCache *get_cache(void)
+{
+  pthread_once(&BufferCacheOnce, cache_key_create);
+
+  struct BufferCache *bc = pthread_getspecific(BufferCacheKey);
+  if (!bc)
+  {
+    bc = mutt_mem_calloc(1, sizeof(*bc));
+    pthread_setspecific(BufferCacheKey, bc);
+  }
+
+  return bc;
+}
+#endif
+
 /**
  * mutt_buffer_pool_init - Initialise the Buffer pool
  */
 void mutt_buffer_pool_init(void)
 {
+  pool_lock();
   increase_buffer_pool();
+  pool_unlock();
 }
 
 /**
  * mutt_buffer_pool_free - Release the Buffer pool
+ *
+ * @note Any other threads using the pool must have finished
  */
 void mutt_buffer_pool_free(void)
 {
+#ifdef USE_PTHREADS
+  pthread_once(&BufferCacheOnce, cache_key_create);
+  cache_free(pthread_getspecific(BufferCacheKey));
+  pthread_setspecific(BufferCacheKey, NULL);
+#endif
+
+  pool_lock();
   if (BufferPoolCount != BufferPoolLen)
   {
     mutt_debug(1, "Buffer pool leak: %zu/%zu\n", BufferPoolCount, BufferPoolLen);
@@ -355,43 +463,63 @@ void mutt_buffer_pool_free(void)
     mutt_buffer_free(&BufferPool[--BufferPoolCount]);
   FREE(&BufferPool);
   BufferPoolLen = 0;
+  pool_unlock();
 }
 
 /**
  * mutt_buffer_pool_get - Get a Buffer from the pool
  * @retval ptr Buffer
+ *
+ * This is safe to call from any thread.
  */
 struct Buffer *mutt_buffer_pool_get(void)
 {
+#ifdef USE_PTHREADS
+  struct BufferCache *bc = get_cache();
+  if (bc->count > 0)
+    return bc->bufs[--bc->count];
+#endif
+
+  pool_lock();
   if (BufferPoolCount == 0)
     increase_buffer_pool();
-  return BufferPool[--BufferPoolCount];
+  struct Buffer *buf = BufferPool[--BufferPoolCount];
+  pool_unlock();
+
+  return buf;
 }
 
 /**
  * mutt_buffer_pool_release - Free a Buffer from the pool
  * @param pbuf Buffer to free
+ *
+ * The Buffer may be released by a different thread from the one that got it.
  */
 void mutt_buffer_pool_release(struct Buffer **pbuf)
 {
   if (!pbuf || !*pbuf)
     return;
 
-  if (BufferPoolCount >= BufferPoolLen)
-  {
-    mutt_debug(1, "Internal buffer pool error\n");
-    mutt_buffer_free(pbuf);
-    return;
-  }
-
   struct Buffer *buf = *pbuf;
+  *pbuf = NULL;
+
   if (buf->dsize > (LONG_STRING * 2))
   {
     buf->dsize = LONG_STRING;
     mutt_mem_realloc(&buf->data, buf->dsize);
   }
   mutt_buffer_reset(buf);
-  BufferPool[BufferPoolCount++] = buf;
 
-  *pbuf = NULL;
+#ifdef USE_PTHREADS
+  struct BufferCache *bc = get_cache();
+  if (bc->count < BUFFER_CACHE_SIZE)
+  {
+    bc->bufs[bc->count++] = buf;
+    return;
+  }
+#endif
+
+  pool_lock();
+  pool_put(buf);
+  pool_unlock();
 }
@@ -37,6 +37,9 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "charset.h"
 #include "buffer.h"
 #include "memory.h"
@@ -75,6 +78,38 @@ struct Lookup
 };
 static TAILQ_HEAD(, Lookup) Lookups = TAILQ_HEAD_INITIALIZER(Lookups);
 
+#define ICONV_CACHE_SIZE 16 ///< Number of iconv descriptors to keep open
+
+/**
+ * struct IconvCacheEntry - A cached iconv conversion descriptor
+ *
+ * Opening an iconv descriptor is slow, so mutt_ch_iconv_get() keeps a few of
+ * them open, keyed by the arguments of mutt_ch_iconv_open().
+ */
+struct IconvCacheEntry
+{
+  char *tocode;       ///< Destination character set, as requested
+  char *fromcode;     ///< Source character set, as requested
+  int flags;          ///< Flags, e.g. #MUTT_ICONV_HOOK_FROM
+  iconv_t cd;         ///< iconv conversion descriptor
+  bool in_use;        ///< The descriptor has been lent out
+  bool stale;         ///< The hooks changed while it was lent out
+  unsigned long used; ///< When the descriptor was last lent out
+};
+
+static struct IconvCacheEntry IconvCache[ICONV_CACHE_SIZE];
+static unsigned long IconvCacheClock = 0;
+
+#ifdef USE_PTHREADS
+/* Worker threads, e.g. parsing a mailbox, decode headers too */
+static pthread_mutex_t IconvCacheLock = PTHREAD_MUTEX_INITIALIZER;
+#define cache_lock() pthread_mutex_lock(&IconvCacheLock)
+#define cache_unlock() pthread_mutex_unlock(&IconvCacheLock)
+#else
+#define cache_lock()
+#define cache_unlock()
+#endif
+
 // clang-format off
 /**
  * PreferredMimeNames - Lookup table of preferred charsets
@@ -295,7 +330,8 @@ int mutt_ch_convert_nonmime_string(char **ps)
       return 0;
     }
   }
-  mutt_ch_convert_string(ps, (const char *) mutt_ch_get_default_charset(),
+  char fcharset[SHORT_STRING];
+  mutt_ch_convert_string(ps, mutt_ch_get_default_charset(fcharset, sizeof(fcharset)),
                          Charset, MUTT_ICONV_HOOK_FROM);
   return -1;
 }
@@ -391,23 +427,23 @@ bool mutt_ch_chscmp(const char *cs1, const char *cs2)
 
 /**
  * mutt_ch_get_default_charset - Get the default character set
- * @retval ptr Name of the default character set
- *
- * @warning This returns a pointer to a static buffer.  Do not free it.
+ * @param buf    Buffer for the result
+ * @param buflen Length of the buffer
+ * @retval ptr Name of the default character set, i.e. buf
  */
-char *mutt_ch_get_default_charset(void)
+char *mutt_ch_get_default_charset(char *buf, size_t buflen)
 {
-  static char fcharset[SHORT_STRING];
   const char *c = AssumedCharset;
   const char *c1 = NULL;
 
   if (c && *c)
   {
     c1 = strchr(c, ':');
-    mutt_str_strfcpy(fcharset, c, c1 ? (c1 - c + 1) : sizeof(fcharset));
-    return fcharset;
+    mutt_str_strfcpy(buf, c, c1 ? MIN(c1 - c + 1, buflen) : buflen);
+    return buf;
   }
-  return strcpy(fcharset, "us-ascii");
+  mutt_str_strfcpy(buf, "us-ascii", buflen);
+  return buf;
 }
 
 /**
@@ -429,6 +465,41 @@ char *mutt_ch_get_langinfo_charset(void)
   return mutt_str_strdup("iso-8859-1");
 }
 
+/**
+ * cache_entry_free - Close a cached iconv descriptor
+ * @param ice Cache entry
+ *
+ * @note The caller must hold the cache lock
+ */
+static void cache_entry_free(struct IconvCacheEntry *ice)
+{
+  if (ice->tocode)
+    iconv_close(ice->cd);
+  FREE(&ice->tocode);
+  FREE(&ice->fromcode);
+  memset(ice, 0, sizeof(*ice));
+}
+
+/**
+ * iconv_cache_flush - Close the cached iconv descriptors
+ *
+ * The hooks affect which conversion a descriptor does, so the cache must be
+ * flushed whenever they change.  Descriptors that are in use will be closed
+ * when they're released.
+ */
+static void iconv_cache_flush(void)
+{
+  cache_lock();
+  for (size_t i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    if (IconvCache[i].in_use)
+      IconvCache[i].stale = true;
+    else
+      cache_entry_free(&IconvCache[i]);
+  }
+  cache_unlock();
+}
+
 /**
  * mutt_ch_lookup_add - Add a new character set lookup
  * @param type    Type of character set, e.g. MUTT_LOOKUP_CHARSET
@@ -463,6 +534,7 @@ bool mutt_ch_lookup_add(enum LookupType type, const char *pat,
   l->regex.not = false;
 
   TAILQ_INSERT_TAIL(&Lookups, l, entries);
+  iconv_cache_flush();
 
   return true;
 }
@@ -487,6 +559,8 @@ void mutt_ch_lookup_remove(void)
     FREE(&l->regex);
     FREE(&l);
   }
+
+  iconv_cache_flush();
 }
 
 /**
@@ -562,6 +636,117 @@ iconv_t mutt_ch_iconv_open(const char *tocode, const char *fromcode, int flags)
   return (iconv_t) -1;
 }
 
+/**
+ * mutt_ch_iconv_get - Get a cached iconv descriptor
+ * @param tocode   Current character set
+ * @param fromcode Target character set
+ * @param flags    Flags, e.g. #MUTT_ICONV_HOOK_FROM
+ * @retval ptr iconv handle for the conversion
+ *
+ * This is like mutt_ch_iconv_open(), but the descriptor is taken from a cache,
+ * if possible.  It must be given back with mutt_ch_iconv_release(), not closed.
+ * The descriptor is in its initial state.
+ */
+iconv_t mutt_ch_iconv_get(const char *tocode, const char *fromcode, int flags)
+{
+  if (!tocode || !fromcode)
+    return (iconv_t) -1;
+
+  cache_lock();
+  for (size_t i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    struct IconvCacheEntry *ice = &IconvCache[i];
+    if (!ice->tocode || ice->in_use || (ice->flags != flags) ||
+        (mutt_str_strcasecmp(ice->tocode, tocode) != 0) ||
+        (mutt_str_strcasecmp(ice->fromcode, fromcode) != 0))
+    {
+      continue;
+    }
+
+    ice->in_use = true;
+    ice->used = ++IconvCacheClock;
+    cache_unlock();
+    return ice->cd;
+  }
+  cache_unlock();
+
+  iconv_t cd = mutt_ch_iconv_open(tocode, fromcode, flags);
+  if (cd == (iconv_t) -1)
+    return cd;
+
+  /* Use an empty slot, or replace the least recently used descriptor */
+  cache_lock();
+  struct IconvCacheEntry *victim = NULL;
+  for (size_t i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    struct IconvCacheEntry *ice = &IconvCache[i];
+    if (ice->in_use)
+      continue;
+    if (!ice->tocode)
+    {
+      victim = ice;
+      break;
+    }
+    if (!victim || (ice->used < victim->used))
+      victim = ice;
+  }
+
+  /* If they're all in use, the descriptor will be closed on release */
+  if (victim)
+  {
+    cache_entry_free(victim);
+    victim->tocode = mutt_str_strdup(tocode);
+    victim->fromcode = mutt_str_strdup(fromcode);
+    victim->flags = flags;
+    victim->cd = cd;
+    victim->in_use = true;
+    victim->used = ++IconvCacheClock;
+  }
+  cache_unlock();
+
+  return cd;
+}
+
+/**
+ * mutt_ch_iconv_release - Give back a cached iconv descriptor
+ * @param cd iconv handle from mutt_ch_iconv_get()
+ *
+ * The descriptor is reset, ready for its next user.
+ */
+void mutt_ch_iconv_release(iconv_t cd)
+{
+  if (cd == (iconv_t) -1)
+    return;
+
+  iconv(cd, NULL, NULL, NULL, NULL);
+
+  cache_lock();
+  for (size_t i = 0; i < ICONV_CACHE_SIZE; i++)
+  {
+    struct IconvCacheEntry *ice = &IconvCache[i];
+    if (!ice->in_use || (ice->cd != cd))
+      continue;
+
+    if (ice->stale)
+      cache_entry_free(ice);
+    else
+      ice->in_use = false;
+    cache_unlock();
+    return;
+  }
+  cache_unlock();
+
+  iconv_close(cd);
+}
+
+/**
+ * mutt_ch_cache_cleanup - Close the cached iconv descriptors
+ */
+void mutt_ch_cache_cleanup(void)
+{
+  iconv_cache_flush();
+}
+
 /**
  * mutt_ch_iconv - Change the encoding of a string
  * @param[in]     cd           Iconv conversion descriptor
@@ -680,7 +865,7 @@ const char *mutt_ch_iconv_lookup(const char *chs)
 int mutt_ch_check(const char *s, size_t slen, const char *from, const char *to)
 {
   int rc = 0;
-  iconv_t cd = mutt_ch_iconv_open(to, from, 0);
+  iconv_t cd = mutt_ch_iconv_get(to, from, 0);
   if (cd == (iconv_t) -1)
     return -1;
 
@@ -694,7 +879,7 @@ int mutt_ch_check(const char *s, size_t slen, const char *from, const char *to)
     rc = errno;
 
   FREE(&saved_out);
-  iconv_close(cd);
+  mutt_ch_iconv_release(cd);
   return rc;
 }
 
@@ -724,7 +909,7 @@ int mutt_ch_convert_string(char **ps, const char *from, const char *to, int flag
   if (!to || !from)
     return -1;
 
-  cd = mutt_ch_iconv_open(to, from, flags);
+  cd = mutt_ch_iconv_get(to, from, flags);
   if (cd == (iconv_t) -1)
     return -1;
 
@@ -750,7 +935,7 @@ int mutt_ch_convert_string(char **ps, const char *from, const char *to, int flag
   ob = buf;
 
   mutt_ch_iconv(cd, &ib, &ibl, &ob, &obl, inrepls, outrepl, &rc);
-  iconv_close(cd);
+  mutt_ch_iconv_release(cd);
 
   *ob = '\0';
 
@@ -817,7 +1002,7 @@ struct FgetConv *mutt_ch_fgetconv_open(FILE *file, const char *from, const char
   iconv_t cd = (iconv_t) -1;
 
   if (from && to)
-    cd = mutt_ch_iconv_open(to, from, flags);
+    cd = mutt_ch_iconv_get(to, from, flags);
 
   if (cd != (iconv_t) -1)
   {
@@ -843,8 +1028,7 @@ struct FgetConv *mutt_ch_fgetconv_open(FILE *file, const char *from, const char
  */
 void mutt_ch_fgetconv_close(struct FgetConv **fc)
 {
-  if ((*fc)->cd != (iconv_t) -1)
-    iconv_close((*fc)->cd);
+  mutt_ch_iconv_release((*fc)->cd);
   FREE(fc);
 }
 
@@ -130,7 +130,8 @@ static const struct Tz TimeZones[] = {
  */
 static time_t compute_tz(time_t g, struct tm *utc)
 {
-  struct tm *lt = localtime(&g);
+  struct tm tm;
+  struct tm *lt = localtime_r(&g, &tm);
   time_t t;
   int yday;
 
@@ -213,15 +214,11 @@ time_t mutt_date_local_tz(time_t t)
   if ((t == TIME_T_MAX) || (t == TIME_T_MIN))
     return 0;
 
-  struct tm *ptm = NULL;
   struct tm utc;
 
   if (!t)
     t = time(NULL);
-  ptm = gmtime(&t);
-  /* need to make a copy because gmtime/localtime return a pointer to
-     static memory (grr!) */
-  memcpy(&utc, ptm, sizeof(utc));
+  gmtime_r(&t, &utc);
   return compute_tz(t, &utc);
 }
 
@@ -470,7 +467,8 @@ time_t mutt_date_parse_date(const char *s, struct Tz *tz_out)
 
   memset(&tm, 0, sizeof(tm));
 
-  while ((t = strtok(t, " \t")))
+  char *save = NULL;
+  while ((t = strtok_r(t, " \t", &save)))
   {
     switch (count)
     {
@@ -552,7 +550,7 @@ time_t mutt_date_parse_date(const char *s, struct Tz *tz_out)
           /* ad hoc support for the European MET (now officially CET) TZ */
           if (mutt_str_strcasecmp(t, "MET") == 0)
           {
-            t = strtok(NULL, " \t");
+            t = strtok_r(NULL, " \t", &save);
             if (t)
             {
               if (mutt_str_strcasecmp(t, "DST") == 0)
@@ -611,6 +609,24 @@ int mutt_date_make_imap(char *buf, size_t buflen, time_t timestamp)
                   tm->tm_sec, (int) tz / 60, (int) abs((int) tz) % 60);
 }
 
+/**
+ * mutt_date_make_imap_search - Format date in IMAP SEARCH style
+ * @param buf       Buffer to store the results
+ * @param buflen    Length of buffer
+ * @param timestamp Time to format
+ * @retval num Characters written to buf
+ *
+ * e.g., 17-Mar-2016. The date is always in UTC.
+ *
+ * Caller should provide a buffer of at least 12 bytes.
+ */
+int mutt_date_make_imap_search(char *buf, size_t buflen, time_t timestamp)
+{
+  struct tm *tm = gmtime(&timestamp);
+  return snprintf(buf, buflen, "%d-%s-%d", tm->tm_mday, Months[tm->tm_mon],
+                  tm->tm_year + 1900);
+}
+
 /**
  * mutt_date_make_tls - Format date in TLS certificate verification style
  * @param buf       Buffer to store the results
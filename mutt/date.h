@@ -43,6 +43,7 @@ bool   mutt_date_is_day_name(const char *s);
 time_t mutt_date_local_tz(time_t t);
 char * mutt_date_make_date(char *buf, size_t buflen);
 int    mutt_date_make_imap(char *buf, size_t buflen, time_t timestamp);
+int    mutt_date_make_imap_search(char *buf, size_t buflen, time_t timestamp);
 time_t mutt_date_make_time(struct tm *t, int local);
 int    mutt_date_make_tls(char *buf, size_t buflen, time_t timestamp);
 void   mutt_date_normalize_time(struct tm *tm);
@@ -25,34 +25,100 @@
  * @page hash Hash table data structure
  *
  * Hash table data structure.
+ *
+ * The table uses open addressing with linear probing.  Each slot stores the
+ * full hash of its key, so most mismatches can be rejected without comparing
+ * the keys.  Elements with the same key share a slot, chained together.
+ *
+ * When the table is 3/4 full, it's doubled in size.  The stored hashes mean
+ * that the keys don't have to be hashed again.
+ *
+ * Deleting a key moves any following entries back, so the table never
+ * contains tombstones.
  */
 
 #include "config.h"
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "hash.h"
 #include "memory.h"
 #include "string2.h"
 
-#define SOMEPRIME 149711
+#define HASH_MIN_SLOTS  8    ///< Smallest table that will be created
+#define HASH_BLOCK_MIN  8    ///< Number of HashElems in the first block
+#define HASH_BLOCK_MAX  1024 ///< Maximum number of HashElems in a block
+
+/* Constants from wyhash (public domain) */
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+#define HASH_P3 0x589965cc75374cc3ULL
+
+/**
+ * struct HashBlock - A block of HashElems
+ *
+ * The HashElems follow the header in memory.
+ */
+struct HashBlock
+{
+  struct HashBlock *next; ///< Next (older) block
+  size_t len;             ///< Number of HashElems in the block
+};
+
+/**
+ * hash_mum - Multiply two numbers and fold the 128-bit result
+ * @param a First number
+ * @param b Second number
+ * @retval num Low 64 bits of the product XOR'd with the high 64 bits
+ */
+static uint64_t hash_mum(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t) a * b;
+  return (uint64_t) r ^ (uint64_t)(r >> 64);
+#else
+  uint64_t ha = a >> 32, hb = b >> 32;
+  uint64_t la = (uint32_t) a, lb = (uint32_t) b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = (t < rl);
+  uint64_t lo = t + (rm1 << 32);
+  c += (lo < t);
+  uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  return lo ^ hi;
+#endif
+}
 
 /**
  * gen_string_hash - Generate a hash from a string
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the string
+ *
+ * The string is hashed eight bytes at a time.
  */
-static size_t gen_string_hash(union HashKey key, size_t n)
+static size_t gen_string_hash(union HashKey key)
 {
-  size_t h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  const unsigned char *s = (const unsigned char *) key.strkey;
+  size_t len = strlen(key.strkey);
+  uint64_t h = HASH_P0 ^ len;
+  uint64_t w;
 
-  while (*s)
-    h += ((h << 7) + *s++);
-  h = (h * SOMEPRIME) % n;
+  for (; len >= 8; s += 8, len -= 8)
+  {
+    memcpy(&w, s, 8);
+    h = hash_mum(w ^ HASH_P1, h ^ HASH_P2);
+  }
+  if (len > 0)
+  {
+    w = 0;
+    memcpy(&w, s, len);
+    h = hash_mum(w ^ HASH_P1, h ^ HASH_P2);
+  }
 
-  return h;
+  return hash_mum(h, HASH_P3);
 }
 
 /**
@@ -71,19 +137,30 @@ static int cmp_string_key(union HashKey a, union HashKey b)
 /**
  * gen_case_string_hash - Generate a hash from a string (ignore the case)
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the string
  */
-static size_t gen_case_string_hash(union HashKey key, size_t n)
+static size_t gen_case_string_hash(union HashKey key)
 {
-  size_t h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  const unsigned char *s = (const unsigned char *) key.strkey;
+  uint64_t h = HASH_P0;
+  uint64_t w = 0;
+  int shift = 0;
 
-  while (*s)
-    h += ((h << 7) + tolower(*s++));
-  h = (h * SOMEPRIME) % n;
+  for (; *s; s++)
+  {
+    w |= (uint64_t) tolower(*s) << shift;
+    shift += 8;
+    if (shift == 64)
+    {
+      h = hash_mum(w ^ HASH_P1, h ^ HASH_P2);
+      w = 0;
+      shift = 0;
+    }
+  }
+  if (shift > 0)
+    h = hash_mum(w ^ HASH_P1, h ^ HASH_P2);
 
-  return h;
+  return hash_mum(h, HASH_P3);
 }
 
 /**
@@ -102,12 +179,11 @@ static int cmp_case_string_key(union HashKey a, union HashKey b)
 /**
  * gen_int_hash - Generate a hash from an integer
  * @param key Integer key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the integer
+ * @retval num Hash of the integer
  */
-static size_t gen_int_hash(union HashKey key, size_t n)
+static size_t gen_int_hash(union HashKey key)
 {
-  return key.intkey % n;
+  return hash_mum(key.intkey ^ HASH_P0, HASH_P1);
 }
 
 /**
@@ -132,62 +208,178 @@ static int cmp_int_key(union HashKey a, union HashKey b)
  * @param nelem Number of elements it should contain
  * @retval ptr New Hash table
  *
- * The Hash table can contain more elements than nelem, but they will be
- * chained together.
+ * The Hash table will grow if more than nelem elements are added.
  */
 static struct Hash *new_hash(size_t nelem)
 {
   struct Hash *table = mutt_mem_calloc(1, sizeof(struct Hash));
-  if (nelem == 0)
-    nelem = 2;
-  table->nelem = nelem;
-  table->table = mutt_mem_calloc(nelem, sizeof(struct HashElem *));
+  table->num_slots = HASH_MIN_SLOTS;
+  while ((table->num_slots / 4 * 3) < nelem)
+    table->num_slots *= 2;
+  table->slots = mutt_mem_calloc(table->num_slots, sizeof(struct HashSlot));
   return table;
 }
 
+/**
+ * hash_find_slot - Find the slot for a key
+ * @param table Hash table to search
+ * @param key   Key (either string or integer)
+ * @param hash  Hash of the key
+ * @retval ptr Slot containing the key, or the empty slot where it belongs
+ */
+static struct HashSlot *hash_find_slot(const struct Hash *table, union HashKey key, size_t hash)
+{
+  const size_t mask = table->num_slots - 1;
+
+  for (size_t i = hash & mask;; i = (i + 1) & mask)
+  {
+    struct HashSlot *slot = &table->slots[i];
+    if (!slot->elem)
+      return slot;
+    if ((slot->hash == hash) && (table->cmp_key(slot->elem->key, key) == 0))
+      return slot;
+  }
+}
+
+/**
+ * hash_grow - Double the size of a Hash table
+ * @param table Hash table to resize
+ */
+static void hash_grow(struct Hash *table)
+{
+  struct HashSlot *old = table->slots;
+  size_t old_num = table->num_slots;
+
+  table->num_slots *= 2;
+  table->slots = mutt_mem_calloc(table->num_slots, sizeof(struct HashSlot));
+
+  const size_t mask = table->num_slots - 1;
+  for (size_t i = 0; i < old_num; i++)
+  {
+    if (!old[i].elem)
+      continue;
+
+    size_t j = old[i].hash & mask;
+    while (table->slots[j].elem)
+      j = (j + 1) & mask;
+    table->slots[j] = old[i];
+  }
+
+  FREE(&old);
+}
+
+/**
+ * hash_remove_slot - Empty a slot in a Hash table
+ * @param table Hash table
+ * @param slot  Slot to empty
+ *
+ * Any entries that were displaced past the slot are moved back, so that
+ * every entry can still be reached from its home slot.
+ */
+static void hash_remove_slot(struct Hash *table, struct HashSlot *slot)
+{
+  const size_t mask = table->num_slots - 1;
+  size_t hole = slot - table->slots;
+
+  for (size_t i = (hole + 1) & mask; table->slots[i].elem; i = (i + 1) & mask)
+  {
+    size_t home = table->slots[i].hash & mask;
+    /* Leave the entry alone if its home lies in (hole, i] */
+    bool stay = (hole < i) ? ((home > hole) && (home <= i)) : ((home > hole) || (home <= i));
+    if (stay)
+      continue;
+
+    table->slots[hole] = table->slots[i];
+    hole = i;
+  }
+
+  table->slots[hole].elem = NULL;
+  table->slots[hole].hash = 0;
+  table->num_keys--;
+}
+
+/**
+ * hash_elem_new - Get an unused HashElem
+ * @param table Hash table
+ * @retval ptr HashElem
+ *
+ * HashElems are allocated in blocks, each twice the size of the last.
+ */
+static struct HashElem *hash_elem_new(struct Hash *table)
+{
+  if (!table->free)
+  {
+    size_t len = HASH_BLOCK_MIN;
+    if (table->blocks)
+      len = MIN(table->blocks->len * 2, HASH_BLOCK_MAX);
+
+    struct HashBlock *block =
+        mutt_mem_malloc(sizeof(struct HashBlock) + len * sizeof(struct HashElem));
+    block->len = len;
+    block->next = table->blocks;
+    table->blocks = block;
+
+    struct HashElem *elems = (struct HashElem *) (block + 1);
+    for (size_t i = 0; i < len; i++)
+    {
+      elems[i].next = table->free;
+      table->free = &elems[i];
+    }
+  }
+
+  struct HashElem *he = table->free;
+  table->free = he->next;
+  return he;
+}
+
+/**
+ * hash_elem_free - Free a HashElem's resources and return it to the table
+ * @param table Hash table
+ * @param he    HashElem to release
+ */
+static void hash_elem_free(struct Hash *table, struct HashElem *he)
+{
+  if (table->destroy)
+    table->destroy(he->type, he->data, table->dest_data);
+  if (table->strdup_keys)
+    FREE(&he->key.strkey);
+
+  he->next = table->free;
+  table->free = he;
+}
+
 /**
  * union_hash_insert - Insert into a hash table using a union as a key
  * @param table Hash table to update
  * @param key   Key to hash on
  * @param type  Data type
  * @param data  Data to associate with key
- * @retval ptr Newly inserted HashElem
+ * @retval ptr  Newly inserted HashElem
+ * @retval NULL The key already exists (and duplicates aren't allowed)
  */
 static struct HashElem *union_hash_insert(struct Hash *table, union HashKey key,
                                           int type, void *data)
 {
-  struct HashElem *ptr = mutt_mem_malloc(sizeof(struct HashElem));
-  unsigned int h = table->gen_hash(key, table->nelem);
+  if ((table->num_keys + 1) > (table->num_slots / 4 * 3))
+    hash_grow(table);
+
+  size_t hash = table->gen_hash(key);
+  struct HashSlot *slot = hash_find_slot(table, key, hash);
+  if (slot->elem && !table->allow_dups)
+    return NULL;
+
+  struct HashElem *ptr = hash_elem_new(table);
   ptr->key = key;
   ptr->data = data;
   ptr->type = type;
+  ptr->next = slot->elem;
 
-  if (table->allow_dups)
+  if (!slot->elem)
   {
-    ptr->next = table->table[h];
-    table->table[h] = ptr;
-  }
-  else
-  {
-    struct HashElem *tmp = NULL, *last = NULL;
-
-    for (tmp = table->table[h], last = NULL; tmp; last = tmp, tmp = tmp->next)
-    {
-      const int r = table->cmp_key(tmp->key, key);
-      if (r == 0)
-      {
-        FREE(&ptr);
-        return NULL;
-      }
-      if (r > 0)
-        break;
-    }
-    if (last)
-      last->next = ptr;
-    else
-      table->table[h] = ptr;
-    ptr->next = tmp;
+    slot->hash = hash;
+    table->num_keys++;
   }
+  slot->elem = ptr;
   return ptr;
 }
 
@@ -196,23 +388,15 @@ static struct HashElem *union_hash_insert(struct Hash *table, union HashKey key,
  * @param table Hash table to search
  * @param key   Key (either string or integer)
  * @retval ptr HashElem matching the key
+ *
+ * If there are duplicate keys, the most recently inserted one is returned.
  */
 static struct HashElem *union_hash_find_elem(const struct Hash *table, union HashKey key)
 {
-  int hash;
-  struct HashElem *ptr = NULL;
-
   if (!table)
     return NULL;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
-  for (; ptr; ptr = ptr->next)
-  {
-    if (table->cmp_key(key, ptr->key) == 0)
-      return ptr;
-  }
-  return NULL;
+  return hash_find_slot(table, key, table->gen_hash(key))->elem;
 }
 
 /**
@@ -238,27 +422,22 @@ static void *union_hash_find(const struct Hash *table, union HashKey key)
  */
 static void union_hash_delete(struct Hash *table, union HashKey key, const void *data)
 {
-  int hash;
-  struct HashElem *ptr, **last;
-
   if (!table)
     return;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
-  last = &table->table[hash];
+  struct HashSlot *slot = hash_find_slot(table, key, table->gen_hash(key));
+  if (!slot->elem)
+    return;
+
+  struct HashElem **last = &slot->elem;
+  struct HashElem *ptr = *last;
 
   while (ptr)
   {
-    if ((data == ptr->data || !data) && table->cmp_key(ptr->key, key) == 0)
+    if (data == ptr->data || !data)
     {
       *last = ptr->next;
-      if (table->destroy)
-        table->destroy(ptr->type, ptr->data, table->dest_data);
-      if (table->strdup_keys)
-        FREE(&ptr->key.strkey);
-      FREE(&ptr);
-
+      hash_elem_free(table, ptr);
       ptr = *last;
     }
     else
@@ -267,6 +446,9 @@ static void union_hash_delete(struct Hash *table, union HashKey key, const void
       ptr = ptr->next;
     }
   }
+
+  if (!slot->elem)
+    hash_remove_slot(table, slot);
 }
 
 /**
@@ -336,7 +518,10 @@ struct HashElem *mutt_hash_typed_insert(struct Hash *table, const char *strkey,
 {
   union HashKey key;
   key.strkey = table->strdup_keys ? mutt_str_strdup(strkey) : strkey;
-  return union_hash_insert(table, key, type, data);
+  struct HashElem *he = union_hash_insert(table, key, type, data);
+  if (!he && table->strdup_keys)
+    FREE(&key.strkey);
+  return he;
 }
 
 /**
@@ -410,19 +595,14 @@ void *mutt_hash_int_find(const struct Hash *table, unsigned int intkey)
  * @param strkey String key to search for
  * @retval ptr HashElem matching the key
  *
- * Unlike mutt_hash_find_elem(), this will return the first matching entry.
+ * Unlike mutt_hash_find_elem(), the caller may follow the HashElem's 'next'
+ * pointer to see all the entries that have the same key.
  */
 struct HashElem *mutt_hash_find_bucket(const struct Hash *table, const char *strkey)
 {
   union HashKey key;
-  int hash;
-
-  if (!table)
-    return NULL;
-
   key.strkey = strkey;
-  hash = table->gen_hash(key, table->nelem);
-  return table->table[hash];
+  return union_hash_find_elem(table, key);
 }
 
 /**
@@ -464,20 +644,23 @@ void mutt_hash_destroy(struct Hash **ptr)
     return;
 
   pptr = *ptr;
-  for (size_t i = 0; i < pptr->nelem; i++)
+  for (size_t i = 0; i < pptr->num_slots; i++)
   {
-    for (elem = pptr->table[i]; elem;)
+    for (elem = pptr->slots[i].elem; elem;)
     {
       tmp = elem;
       elem = elem->next;
-      if (pptr->destroy)
-        pptr->destroy(tmp->type, tmp->data, pptr->dest_data);
-      if (pptr->strdup_keys)
-        FREE(&tmp->key.strkey);
-      FREE(&tmp);
+      hash_elem_free(pptr, tmp);
     }
   }
-  FREE(&pptr->table);
+
+  while (pptr->blocks)
+  {
+    struct HashBlock *block = pptr->blocks;
+    pptr->blocks = block->next;
+    FREE(&block);
+  }
+  FREE(&pptr->slots);
   FREE(ptr);
 }
 
@@ -499,11 +682,11 @@ struct HashElem *mutt_hash_walk(const struct Hash *table, struct HashWalkState *
   if (state->last)
     state->index++;
 
-  while (state->index < table->nelem)
+  while (state->index < table->num_slots)
   {
-    if (table->table[state->index])
+    if (table->slots[state->index].elem)
     {
-      state->last = table->table[state->index];
+      state->last = table->slots[state->index].elem;
       return state->last;
     }
     state->index++;
@@ -38,6 +38,9 @@ union HashKey {
 
 /**
  * struct HashElem - The item stored in a Hash Table
+ *
+ * Elements with the same key (see #MUTT_HASH_ALLOW_DUPS) are chained together
+ * using @a next, newest first.
  */
 struct HashElem
 {
@@ -55,16 +58,35 @@ struct HashElem
  */
 typedef void (*hash_destructor_t)(int type, void *obj, intptr_t data);
 
+/**
+ * struct HashSlot - A slot in a Hash Table
+ */
+struct HashSlot
+{
+  size_t hash;           /**< Full hash of the key, to save comparing keys */
+  struct HashElem *elem; /**< Element(s) with this key, NULL if the slot is empty */
+};
+
+struct HashBlock;
+
 /**
  * struct Hash - A Hash Table
+ *
+ * The table uses open addressing with linear probing.  It doubles in size
+ * whenever it becomes 3/4 full, so @a nelem passed to mutt_hash_create() is
+ * only a hint.  The HashElems are allocated in blocks and never move, so
+ * pointers to them stay valid until they're deleted.
  */
 struct Hash
 {
-  size_t nelem;
-  bool strdup_keys : 1; /**< if set, the key->strkey is strdup'ed */
-  bool allow_dups  : 1; /**< if set, duplicate keys are allowed */
-  struct HashElem **table;
-  size_t (*gen_hash)(union HashKey, size_t);
+  size_t num_slots;         /**< Size of the slots array, a power of two */
+  size_t num_keys;          /**< Number of slots in use */
+  bool strdup_keys : 1;     /**< if set, the key->strkey is strdup'ed */
+  bool allow_dups  : 1;     /**< if set, duplicate keys are allowed */
+  struct HashSlot *slots;   /**< Array of slots */
+  struct HashBlock *blocks; /**< Blocks of allocated HashElems */
+  struct HashElem *free;    /**< Unused HashElems, chained by 'next' */
+  size_t (*gen_hash)(union HashKey);
   int (*cmp_key)(union HashKey, union HashKey);
   hash_destructor_t destroy;
   intptr_t dest_data;
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * Share the storage of repeated strings
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page intern Share the storage of repeated strings
+ *
+ * A large mailbox repeats the same few strings many thousands of times, e.g.
+ * the names and addresses of the people on a mailing list.  Interning a string
+ * swaps it for a reference-counted copy in a shared pool, so each distinct
+ * string is only stored once.
+ *
+ * An interned string must be treated as read-only.  It must be released with
+ * mutt_str_intern_free(), or turned back into a private copy with
+ * mutt_str_intern_unshare() before it's changed.
+ *
+ * @note The pool isn't locked.  Strings may only be interned, or released, by
+ *       the main thread.
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+#include "intern.h"
+#include "hash.h"
+#include "memory.h"
+#include "string2.h"
+
+/**
+ * struct InternString - A shared string
+ */
+struct InternString
+{
+  size_t refs; ///< Number of users of the string
+  char str[];  ///< The string itself
+};
+
+static struct Hash *InternPool = NULL;
+
+/**
+ * intern_string - Find the shared block that holds an interned string
+ * @param str Interned string
+ * @retval ptr Shared block
+ */
+static struct InternString *intern_string(char *str)
+{
+  return (struct InternString *) (str - offsetof(struct InternString, str));
+}
+
+/**
+ * mutt_str_intern - Swap a string for a shared copy
+ * @param ptr String to intern, will be freed
+ *
+ * The original string must have been allocated with malloc().  It's freed and
+ * replaced by a pointer into the pool.
+ */
+void mutt_str_intern(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  if (!InternPool)
+    InternPool = mutt_hash_create(1024, 0);
+
+  struct InternString *is = mutt_hash_find(InternPool, *ptr);
+  if (!is)
+  {
+    size_t len = strlen(*ptr);
+    is = mutt_mem_malloc(sizeof(struct InternString) + len + 1);
+    is->refs = 0;
+    memcpy(is->str, *ptr, len + 1);
+    mutt_hash_insert(InternPool, is->str, is);
+  }
+
+  is->refs++;
+  FREE(ptr);
+  *ptr = is->str;
+}
+
+/**
+ * mutt_str_intern_free - Release an interned string
+ * @param ptr Interned string, will be set to NULL
+ *
+ * The shared copy is freed when its last user releases it.
+ */
+void mutt_str_intern_free(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct InternString *is = intern_string(*ptr);
+  *ptr = NULL;
+  if (--is->refs > 0)
+    return;
+
+  mutt_hash_delete(InternPool, is->str, is);
+  FREE(&is);
+}
+
+/**
+ * mutt_str_intern_unshare - Swap an interned string for a private copy
+ * @param ptr Interned string
+ *
+ * Afterwards, the string may be changed, or freed with FREE().
+ */
+void mutt_str_intern_unshare(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  char *copy = mutt_str_strdup(*ptr);
+  mutt_str_intern_free(ptr);
+  *ptr = copy;
+}
+
+/**
+ * mutt_str_intern_count - How many distinct strings are in the pool?
+ * @retval num Number of strings
+ */
+size_t mutt_str_intern_count(void)
+{
+  return InternPool ? InternPool->num_keys : 0;
+}
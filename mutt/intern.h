@@ -0,0 +1,33 @@
+/**
+ * @file
+ * Share the storage of repeated strings
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_LIB_INTERN_H
+#define MUTT_LIB_INTERN_H
+
+#include <stddef.h>
+
+void   mutt_str_intern(char **ptr);
+size_t mutt_str_intern_count(void);
+void   mutt_str_intern_free(char **ptr);
+void   mutt_str_intern_unshare(char **ptr);
+
+#endif /* MUTT_LIB_INTERN_H */
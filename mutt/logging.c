@@ -24,10 +24,15 @@
  * @page logging Logging Dispatcher
  *
  * Logging Dispatcher
+ *
+ * Log lines may be queued by any thread.  log_queue_add() pushes them onto a
+ * lock-free list of pending lines, which is moved to the queue by whichever
+ * thread finds the queue free.  Nobody waits to add a line.
  */
 
 #include "config.h"
 #include <errno.h>
+#include <sched.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -63,6 +68,16 @@ static struct LogList LogQueue = STAILQ_HEAD_INITIALIZER(LogQueue);
 int LogQueueCount = 0; /**< Number of entries currently in the log queue */
 int LogQueueMax = 0;   /**< Maximum number of entries in the log queue */
 
+/**
+ * LogPending - Log lines waiting to be added to the queue, newest first
+ */
+static struct LogLine *LogPending = NULL;
+
+/**
+ * LogQueueBusy - Is a thread using the queue?
+ */
+static bool LogQueueBusy = false;
+
 /**
  * timestamp - Create a YYYY-MM-DD HH:MM:SS timestamp
  * @param stamp Unix time
@@ -281,26 +296,114 @@ int log_disp_file(time_t stamp, const char *file, int line,
   return ret;
 }
 
+/**
+ * queue_trylock - Try to get exclusive use of the queue
+ * @retval true The queue is ours, call queue_unlock() when done
+ */
+static bool queue_trylock(void)
+{
+  return !__atomic_test_and_set(&LogQueueBusy, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * queue_lock - Wait for exclusive use of the queue
+ */
+static void queue_lock(void)
+{
+  while (!queue_trylock())
+    sched_yield();
+}
+
+/**
+ * queue_unlock - Let other threads use the queue
+ */
+static void queue_unlock(void)
+{
+  __atomic_clear(&LogQueueBusy, __ATOMIC_RELEASE);
+}
+
+/**
+ * queue_collect - Move the pending log lines to the queue
+ *
+ * If #LogQueueMax is non-zero, the oldest lines are dropped to fit.
+ *
+ * @note The caller must have exclusive use of the queue
+ */
+static void queue_collect(void)
+{
+  struct LogLine *ll = __atomic_exchange_n(&LogPending, NULL, __ATOMIC_ACQUIRE);
+  int count = LogQueueCount;
+
+  /* The pending lines are newest first, so reverse them */
+  struct LogList pending = STAILQ_HEAD_INITIALIZER(pending);
+  while (ll)
+  {
+    struct LogLine *next = STAILQ_NEXT(ll, entries);
+    STAILQ_INSERT_HEAD(&pending, ll, entries);
+    count++;
+    ll = next;
+  }
+  STAILQ_CONCAT(&LogQueue, &pending);
+
+  while ((LogQueueMax > 0) && (count > LogQueueMax))
+  {
+    ll = STAILQ_FIRST(&LogQueue);
+    STAILQ_REMOVE_HEAD(&LogQueue, entries);
+    FREE(&ll->message);
+    FREE(&ll);
+    count--;
+  }
+
+  /* Other threads may read the count without using the queue */
+  __atomic_store_n(&LogQueueCount, count, __ATOMIC_RELAXED);
+}
+
+/**
+ * queue_empty - Free the contents of the queue
+ *
+ * @note The caller must have exclusive use of the queue
+ */
+static void queue_empty(void)
+{
+  struct LogLine *ll = NULL;
+  struct LogLine *tmp = NULL;
+
+  STAILQ_FOREACH_SAFE(ll, &LogQueue, entries, tmp)
+  {
+    FREE(&ll->message);
+    FREE(&ll);
+  }
+  STAILQ_INIT(&LogQueue);
+
+  __atomic_store_n(&LogQueueCount, 0, __ATOMIC_RELAXED);
+}
+
 /**
  * log_queue_add - Add a LogLine to the queue
  * @param ll LogLine to add
  * @retval num Entries in the queue
  *
  * If #LogQueueMax is non-zero, the queue will be limited to this many items.
+ *
+ * This is safe to call from any thread.  If another thread is using the
+ * queue, the line is left for it to collect, so the count may be out of date.
  */
 int log_queue_add(struct LogLine *ll)
 {
-  STAILQ_INSERT_TAIL(&LogQueue, ll, entries);
-
-  if ((LogQueueMax > 0) && (LogQueueCount >= LogQueueMax))
+  struct LogLine *head = __atomic_load_n(&LogPending, __ATOMIC_RELAXED);
+  do
   {
-    STAILQ_REMOVE_HEAD(&LogQueue, entries);
-  }
-  else
+    STAILQ_NEXT(ll, entries) = head;
+  } while (!__atomic_compare_exchange_n(&LogPending, &head, ll, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+  if (queue_trylock())
   {
-    LogQueueCount++;
+    queue_collect();
+    queue_unlock();
   }
-  return LogQueueCount;
+
+  return __atomic_load_n(&LogQueueCount, __ATOMIC_RELAXED);
 }
 
 /**
@@ -323,17 +426,10 @@ void log_queue_set_max_size(int size)
  */
 void log_queue_empty(void)
 {
-  struct LogLine *ll = NULL;
-  struct LogLine *tmp = NULL;
-
-  STAILQ_FOREACH_SAFE(ll, &LogQueue, entries, tmp)
-  {
-    STAILQ_REMOVE(&LogQueue, ll, LogLine, entries);
-    FREE(&ll->message);
-    FREE(&ll);
-  }
-
-  LogQueueCount = 0;
+  queue_lock();
+  queue_collect();
+  queue_empty();
+  queue_unlock();
 }
 
 /**
@@ -345,13 +441,23 @@ void log_queue_empty(void)
  */
 void log_queue_flush(log_dispatcher_t disp)
 {
+  queue_lock();
+  queue_collect();
+
+  /* Take the lines, in case the dispatcher logs something to the queue */
+  struct LogList lines = STAILQ_HEAD_INITIALIZER(lines);
+  STAILQ_CONCAT(&lines, &LogQueue);
+  __atomic_store_n(&LogQueueCount, 0, __ATOMIC_RELAXED);
+  queue_unlock();
+
   struct LogLine *ll = NULL;
-  STAILQ_FOREACH(ll, &LogQueue, entries)
+  struct LogLine *tmp = NULL;
+  STAILQ_FOREACH_SAFE(ll, &lines, entries, tmp)
   {
     disp(ll->time, ll->file, ll->line, ll->function, ll->level, "%s", ll->message);
+    FREE(&ll->message);
+    FREE(&ll);
   }
-
-  log_queue_empty();
 }
 
 /**
@@ -372,6 +478,9 @@ int log_queue_save(FILE *fp)
   char buf[32];
   int count = 0;
   struct LogLine *ll = NULL;
+
+  queue_lock();
+  queue_collect();
   STAILQ_FOREACH(ll, &LogQueue, entries)
   {
     strftime(buf, sizeof(buf), "%H:%M:%S", localtime(&ll->time));
@@ -380,6 +489,7 @@ int log_queue_save(FILE *fp)
       fputs("\n", fp);
     count++;
   }
+  queue_unlock();
 
   return count;
 }
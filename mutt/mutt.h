@@ -36,6 +36,7 @@
  * | mutt/file.c      | @subpage file      |
  * | mutt/hash.c      | @subpage hash      |
  * | mutt/history.c   | @subpage history   |
+ * | mutt/intern.c    | @subpage intern    |
  * | mutt/list.c      | @subpage list      |
  * | mutt/logging.c   | @subpage logging   |
  * | mutt/mapping.c   | @subpage mapping   |
@@ -64,6 +65,7 @@
 #include "file.h"
 #include "hash.h"
 #include "history.h"
+#include "intern.h"
 #include "list.h"
 #include "logging.h"
 #include "mapping.h"
@@ -29,6 +29,9 @@
 #include "config.h"
 #include <errno.h>
 #include <limits.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -50,6 +53,16 @@ char *DebugFile = NULL;   ///< Config: File to save debug logs
 char *CurrentFile = NULL; /**< The previous log file name */
 const int NumOfLogs = 5;  /**< How many log files to rotate */
 
+#ifdef USE_PTHREADS
+/* Worker threads, e.g. parsing a mailbox, may log at the same time as the UI */
+static pthread_mutex_t LogLock = PTHREAD_MUTEX_INITIALIZER;
+#define log_lock() pthread_mutex_lock(&LogLock)
+#define log_unlock() pthread_mutex_unlock(&LogLock)
+#else
+#define log_lock()
+#define log_unlock()
+#endif
+
 #define S_TO_NS 1000000000UL
 #define S_TO_US 1000000UL
 #define US_TO_NS 1000UL
@@ -177,6 +190,7 @@ int log_disp_curses(time_t stamp, const char *file, int line,
     ret += snprintf(buf2, len, ": %s (errno = %d)", p, errno);
   }
 
+  log_lock();
   const bool dupe = (strcmp(buf, ErrorBuf) == 0);
   if (!dupe)
   {
@@ -185,6 +199,7 @@ int log_disp_curses(time_t stamp, const char *file, int line,
     if (stamp == 0)
       log_disp_queue(stamp, file, line, function, level, "%s", buf);
   }
+  log_unlock();
 
   /* Don't display debugging message on screen */
   if (level > LL_MESSAGE)
@@ -194,8 +209,10 @@ int log_disp_curses(time_t stamp, const char *file, int line,
   if ((level > LL_ERROR) && OptMsgErr && !dupe)
     error_pause();
 
+  log_lock();
   mutt_simple_format(ErrorBuf, sizeof(ErrorBuf), 0, MuttMessageWindow->cols,
                      FMT_LEFT, 0, buf, sizeof(buf), 0);
+  log_unlock();
   ErrorBufMessage = true;
 
   if (!OptKeepQuiet)
@@ -40,6 +40,9 @@ struct Context;
  * mutt_parse_mime_message - Parse a MIME email
  * @param ctx Mailbox
  * @param cur Email
+ *
+ * The MIME parts are read from the header cache, if possible.  Otherwise, the
+ * message is parsed and its parts are saved in the header cache.
  */
 void mutt_parse_mime_message(struct Context *ctx, struct Email *cur)
 {
@@ -53,6 +56,9 @@ void mutt_parse_mime_message(struct Context *ctx, struct Email *cur)
     if (cur->content->parts)
       break; /* The message was parsed earlier. */
 
+    if (mx_msg_load_parts(ctx, cur) == 0)
+      break; /* The parts were in the header cache */
+
     msg = mx_msg_open(ctx, cur->msgno);
     if (msg)
     {
@@ -62,6 +68,11 @@ void mutt_parse_mime_message(struct Context *ctx, struct Email *cur)
         cur->security = crypt_query(cur->content);
 
       mx_msg_close(ctx, &msg);
+
+      /* Keep the MIME parts in the header cache, so the next time the mailbox
+       * is opened, the message file won't need to be read again */
+      if (cur->content->parts)
+        mx_msg_save_parts(ctx, cur);
     }
   } while (0);
 
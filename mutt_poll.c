@@ -0,0 +1,359 @@
+/**
+ * @file
+ * Wait for the keyboard, files, sockets and timers
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page mutt_poll Wait for the keyboard, files, sockets and timers
+ *
+ * NeoMutt spends most of its time waiting for a key press.  While it waits,
+ * mutt_poll_wait() watches STDIN, plus any file descriptors that other modules
+ * have registered, e.g. the inotify monitor or an IDLE-ing IMAP connection.
+ * Their handlers are run as soon as there's something to read.
+ *
+ * Timers are registered as a pair of functions: one says when the timer is
+ * next due (if at all), the other does the work.  Timers are only fired while
+ * waiting for a key press.  Some, e.g. the keepalive, may fire in any menu;
+ * others, e.g. the mail check, only while the index or pager waits for a
+ * command, see mutt_poll_timers().
+ *
+ * If nothing happens and no timers are due, NeoMutt doesn't wake up.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "mutt/mutt.h"
+#include "mutt_poll.h"
+
+/**
+ * struct PollSource - A file descriptor to watch
+ */
+struct PollSource
+{
+  int fd;            ///< File descriptor
+  poll_fd_t handler; ///< Function to call when it's readable
+  void *data;        ///< Private data for the handler
+};
+
+/**
+ * struct PollTimer - A timer
+ */
+struct PollTimer
+{
+  poll_due_t due;   ///< When is the timer due?
+  poll_fire_t fire; ///< Fire the timer
+  time_t fired;     ///< When the timer last fired
+  int flags;        ///< When may it fire? e.g. #MUTT_POLL_TIMER_KEY
+};
+
+static struct PollSource *PollSources = NULL;
+static size_t PollSourcesCount = 0;
+static size_t PollSourcesLen = 0;
+
+static struct PollTimer *PollTimers = NULL;
+static size_t PollTimersCount = 0;
+
+static int PollTimersEnabled = 0; ///< Timers allowed to fire, e.g. #MUTT_POLL_TIMER_KEY
+static bool PollWoken = false; ///< The last wait was ended by a handler or timer
+
+/**
+ * poll_now_ms - Get the current time in milliseconds
+ * @retval num Milliseconds since the Unix epoch
+ */
+static long long poll_now_ms(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return ((long long) tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+}
+
+/**
+ * poll_find - Find a registered file descriptor
+ * @param fd File descriptor
+ * @retval ptr  Matching PollSource
+ * @retval NULL Not registered
+ */
+static struct PollSource *poll_find(int fd)
+{
+  for (size_t i = 0; i < PollSourcesCount; i++)
+    if (PollSources[i].fd == fd)
+      return &PollSources[i];
+
+  return NULL;
+}
+
+/**
+ * poll_timers_run - Fire any timers that are due
+ * @param[in]  now  Current time
+ * @param[out] wait Milliseconds until the next timer is due, -1 if none
+ * @retval true A timer wants the UI to wake up
+ */
+static bool poll_timers_run(time_t now, int *wait)
+{
+  bool wake = false;
+
+  *wait = -1;
+  if (!PollTimersEnabled)
+    return false;
+
+  for (size_t i = 0; i < PollTimersCount; i++)
+  {
+    struct PollTimer *t = &PollTimers[i];
+    if (!(t->flags & PollTimersEnabled))
+      continue;
+
+    time_t due = t->due();
+    if (due == 0)
+      continue;
+
+    if ((due <= now) && (t->fired < now))
+    {
+      t->fired = now;
+      if (t->fire() > 0)
+        wake = true;
+
+      /* firing the timer will usually have moved it on */
+      due = t->due();
+      if (due == 0)
+        continue;
+    }
+
+    /* don't let a timer that can't make progress spin */
+    if (due <= t->fired)
+      due = t->fired + 1;
+
+    int ms = (int) MIN((due - now) * 1000, INT_MAX);
+    if ((*wait < 0) || (ms < *wait))
+      *wait = ms;
+  }
+
+  return wake;
+}
+
+/**
+ * mutt_poll_add - Watch a file descriptor
+ * @param fd      File descriptor
+ * @param handler Function to call when the file descriptor is readable
+ * @param data    Private data for the handler
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * If the file descriptor is already registered, its handler is replaced.
+ */
+int mutt_poll_add(int fd, poll_fd_t handler, void *data)
+{
+  if ((fd < 0) || !handler)
+    return -1;
+
+  struct PollSource *ps = poll_find(fd);
+  if (!ps)
+  {
+    if (PollSourcesCount == PollSourcesLen)
+    {
+      PollSourcesLen += 4;
+      mutt_mem_realloc(&PollSources, PollSourcesLen * sizeof(struct PollSource));
+    }
+    ps = &PollSources[PollSourcesCount++];
+    ps->fd = fd;
+  }
+
+  ps->handler = handler;
+  ps->data = data;
+  mutt_debug(3, "watching fd %d\n", fd);
+  return 0;
+}
+
+/**
+ * mutt_poll_remove - Stop watching a file descriptor
+ * @param fd File descriptor
+ *
+ * It's safe to call this for a file descriptor that isn't being watched.
+ */
+void mutt_poll_remove(int fd)
+{
+  struct PollSource *ps = poll_find(fd);
+  if (!ps)
+    return;
+
+  size_t i = ps - PollSources;
+  memmove(&PollSources[i], &PollSources[i + 1],
+          (PollSourcesCount - i - 1) * sizeof(struct PollSource));
+  PollSourcesCount--;
+  mutt_debug(3, "stopped watching fd %d\n", fd);
+}
+
+/**
+ * mutt_poll_timer_add - Add a timer
+ * @param due  Function to say when the timer is due
+ * @param fire  Function to fire the timer
+ * @param flags When may it fire? e.g. #MUTT_POLL_TIMER_KEY
+ */
+void mutt_poll_timer_add(poll_due_t due, poll_fire_t fire, int flags)
+{
+  if (!due || !fire)
+    return;
+
+  mutt_mem_realloc(&PollTimers, (PollTimersCount + 1) * sizeof(struct PollTimer));
+  PollTimers[PollTimersCount].due = due;
+  PollTimers[PollTimersCount].fire = fire;
+  PollTimers[PollTimersCount].fired = 0;
+  PollTimers[PollTimersCount].flags = flags;
+  PollTimersCount++;
+}
+
+/**
+ * mutt_poll_timers - Allow some timers to fire
+ * @param flags  Timers to change, e.g. #MUTT_POLL_TIMER_COMMAND
+ * @param enable If true, mutt_poll_wait() will fire them
+ *
+ * km_dokey() enables the #MUTT_POLL_TIMER_KEY timers while it waits for a key.
+ * The #MUTT_POLL_TIMER_COMMAND timers may change the open mailbox, so they're
+ * only enabled while the index or pager waits for a command, not in the
+ * middle of one, e.g. at a prompt.
+ */
+void mutt_poll_timers(int flags, bool enable)
+{
+  if (enable)
+    PollTimersEnabled |= flags;
+  else
+    PollTimersEnabled &= ~flags;
+}
+
+/**
+ * mutt_poll_wait - Wait for input, running handlers and timers meanwhile
+ * @param timeout Milliseconds to wait for, -1 to wait forever
+ * @retval  0 Input is ready on STDIN
+ * @retval -1 Error, e.g. interrupted by a signal (see errno)
+ * @retval -2 A handler or timer woke the UI
+ * @retval -3 Timeout
+ */
+int mutt_poll_wait(int timeout)
+{
+  struct pollfd *fds = NULL;
+  size_t fds_len = 0;
+  long long deadline = (timeout >= 0) ? poll_now_ms() + timeout : -1;
+  int rc = -3;
+
+  while (true)
+  {
+    int wait = -1;
+    if (poll_timers_run(time(NULL), &wait))
+    {
+      rc = -2;
+      break;
+    }
+
+    if (deadline >= 0)
+    {
+      long long left = MAX(deadline - poll_now_ms(), 0);
+      if ((wait < 0) || (left < wait))
+        wait = (int) left;
+    }
+
+    /* the handlers may add or remove sources, so take a copy */
+    size_t nfds = PollSourcesCount + 1;
+    if (nfds > fds_len)
+    {
+      fds_len = nfds;
+      mutt_mem_realloc(&fds, fds_len * sizeof(struct pollfd));
+    }
+    fds[0].fd = 0;
+    fds[0].events = POLLIN;
+    for (size_t i = 1; i < nfds; i++)
+    {
+      fds[i].fd = PollSources[i - 1].fd;
+      fds[i].events = POLLIN;
+    }
+
+    int ready = poll(fds, nfds, wait);
+    if (ready < 0)
+    {
+      if (errno != EINTR)
+        mutt_debug(1, "poll() failed, errno=%d %s\n", errno, strerror(errno));
+      rc = -1;
+      break;
+    }
+
+    bool wake = false;
+    for (size_t i = 1; ready && (i < nfds); i++)
+    {
+      if (!fds[i].revents)
+        continue;
+      ready--;
+
+      struct PollSource *ps = poll_find(fds[i].fd);
+      if (!ps)
+        continue;
+
+      int hrc = ps->handler(fds[i].fd, ps->data);
+      if (hrc < 0)
+        mutt_poll_remove(fds[i].fd);
+      if (hrc != 0)
+        wake = true;
+    }
+
+    if (fds[0].revents)
+    {
+      rc = 0;
+      break;
+    }
+    if (wake)
+    {
+      rc = -2;
+      break;
+    }
+    if ((deadline >= 0) && (poll_now_ms() >= deadline))
+      break;
+  }
+
+  FREE(&fds);
+  PollWoken = (rc == -2);
+  return rc;
+}
+
+/**
+ * mutt_poll_woken - Was the last wait ended by an event?
+ * @retval true A handler or timer woke the UI, rather than a timeout or a key
+ *
+ * The caller of mutt_getch() sees both as a timeout.  This lets it tell them
+ * apart, e.g. so that the timeout-hook only runs after a real timeout.
+ */
+bool mutt_poll_woken(void)
+{
+  return PollWoken;
+}
+
+/**
+ * mutt_poll_free - Free the event loop's resources
+ */
+void mutt_poll_free(void)
+{
+  FREE(&PollSources);
+  PollSourcesCount = 0;
+  PollSourcesLen = 0;
+  FREE(&PollTimers);
+  PollTimersCount = 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * Wait for the keyboard, files, sockets and timers
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_MUTT_POLL_H
+#define MUTT_MUTT_POLL_H
+
+#include <stdbool.h>
+#include <time.h>
+
+/**
+ * typedef poll_fd_t - Handle activity on a file descriptor
+ * @param fd   File descriptor that's ready to read
+ * @param data Private data passed to mutt_poll_add()
+ * @retval  1 The UI should wake up, e.g. new mail has arrived
+ * @retval  0 Nothing for the UI to do
+ * @retval -1 Error, stop watching the file descriptor
+ */
+typedef int (*poll_fd_t)(int fd, void *data);
+
+/**
+ * typedef poll_due_t - When should a timer fire?
+ * @retval num Time the timer should fire
+ * @retval 0   The timer isn't needed
+ */
+typedef time_t (*poll_due_t)(void);
+
+/**
+ * typedef poll_fire_t - Fire a timer
+ * @retval 1 The UI should wake up
+ * @retval 0 Nothing for the UI to do
+ */
+typedef int (*poll_fire_t)(void);
+
+/* Flags for mutt_poll_timer_add() and mutt_poll_timers() */
+#define MUTT_POLL_TIMER_KEY     (1 << 0) ///< Fire while waiting for a key, in any menu
+#define MUTT_POLL_TIMER_COMMAND (1 << 1) ///< Fire only while the index or pager waits for a command
+
+int  mutt_poll_add(int fd, poll_fd_t handler, void *data);
+void mutt_poll_free(void);
+void mutt_poll_remove(int fd);
+void mutt_poll_timer_add(poll_due_t due, poll_fire_t fire, int flags);
+void mutt_poll_timers(int flags, bool enable);
+int  mutt_poll_wait(int timeout);
+bool mutt_poll_woken(void);
+
+#endif /* MUTT_MUTT_POLL_H */
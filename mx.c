@@ -1222,6 +1222,9 @@ void mx_update_context(struct Context *ctx, int new_messages)
   {
     e = ctx->mailbox->hdrs[msgno];
 
+    /* the same people appear on many emails, so share their addresses */
+    mutt_env_intern(e->env);
+
     if (WithCrypto)
     {
       /* NOTE: this _must_ be done before the check for mailcap! */
@@ -1587,6 +1590,39 @@ int mx_msg_padding_size(struct Context *ctx)
   return ctx->mailbox->mx_ops->msg_padding_size(ctx);
 }
 
+/**
+ * mx_msg_save_parts - Save a message's MIME parts to the header cache - Wrapper for MxOps::msg_save_parts
+ * @param ctx Mailbox
+ * @param e   Email
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The parts are stored apart from the Email's header, so storing the header
+ * again, e.g. after a flag change, doesn't lose them.
+ */
+int mx_msg_save_parts(struct Context *ctx, struct Email *e)
+{
+  if (!ctx || !ctx->mailbox->mx_ops || !ctx->mailbox->mx_ops->msg_save_parts)
+    return 0;
+
+  return ctx->mailbox->mx_ops->msg_save_parts(ctx, e);
+}
+
+/**
+ * mx_msg_load_parts - Load a message's MIME parts from the header cache - Wrapper for MxOps::msg_load_parts
+ * @param ctx Mailbox
+ * @param e   Email
+ * @retval  0 Success, e->content->parts is set
+ * @retval -1 The parts aren't cached
+ */
+int mx_msg_load_parts(struct Context *ctx, struct Email *e)
+{
+  if (!ctx || !ctx->mailbox->mx_ops || !ctx->mailbox->mx_ops->msg_load_parts)
+    return -1;
+
+  return ctx->mailbox->mx_ops->msg_load_parts(ctx, e);
+}
+
 /**
  * mx_ac_find - XXX
  */
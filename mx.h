@@ -196,6 +196,22 @@ struct MxOps
    * @retval num Bytes of padding
    */
   int (*msg_padding_size)(struct Context *ctx);
+  /**
+   * msg_save_parts - Save a message's MIME parts to the header cache
+   * @param ctx Mailbox
+   * @param e   Email
+   * @retval  0 Success
+   * @retval -1 Failure
+   */
+  int (*msg_save_parts)  (struct Context *ctx, struct Email *e);
+  /**
+   * msg_load_parts - Load a message's MIME parts from the header cache
+   * @param ctx Mailbox
+   * @param e   Email
+   * @retval  0 Success, e->content->parts is set
+   * @retval -1 The parts aren't cached
+   */
+  int (*msg_load_parts)  (struct Context *ctx, struct Email *e);
   /**
    * tags_edit - Prompt and validate new messages tags
    * @param ctx    Mailbox
@@ -261,6 +277,8 @@ int             mx_msg_commit      (struct Context *ctx, struct Message *msg);
 struct Message *mx_msg_open_new    (struct Context *ctx, struct Email *e, int flags);
 struct Message *mx_msg_open        (struct Context *ctx, int msgno);
 int             mx_msg_padding_size(struct Context *ctx);
+int             mx_msg_save_parts  (struct Context *ctx, struct Email *e);
+int             mx_msg_load_parts  (struct Context *ctx, struct Email *e);
 int             mx_path_canon      (char *buf, size_t buflen, const char *folder, int *magic);
 int             mx_path_canon2     (struct Mailbox *m, const char *folder);
 int             mx_path_parent     (char *buf, size_t buflen);
@@ -431,6 +431,8 @@ void pgp_class_invoke_getkeys(struct Address *addr)
   if (!PgpGetkeysCommand)
     return;
 
+  /* the address may belong to an email in the mailbox */
+  mutt_addr_unshare(addr);
   personal = addr->personal;
   addr->personal = NULL;
 
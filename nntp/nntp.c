@@ -97,6 +97,7 @@ struct FetchCtx
   anum_t last;
   int restore;
   unsigned char *messages;
+  char **xref;
   struct Progress progress;
 #ifdef USE_HCACHE
   header_cache_t *hc;
@@ -241,6 +242,7 @@ static int nntp_capabilities(struct NntpAccountData *adata)
   adata->hasLISTGROUP = false;
   adata->hasLISTGROUPrange = false;
   adata->hasOVER = false;
+  adata->hasHDR = false;
   FREE(&adata->authenticators);
 
   if (mutt_socket_send(conn, "CAPABILITIES\r\n") < 0 ||
@@ -285,6 +287,8 @@ static int nntp_capabilities(struct NntpAccountData *adata)
 #endif
     else if (mutt_str_strcmp("OVER", buf) == 0)
       adata->hasOVER = true;
+    else if (mutt_str_strcmp("HDR", buf) == 0)
+      adata->hasHDR = true;
     else if (mutt_str_strncmp("LIST ", buf, 5) == 0)
     {
       char *p = strstr(buf, " NEWSGROUPS");
@@ -822,6 +826,75 @@ static int nntp_query(struct NntpMboxData *mdata, char *line, size_t linelen)
   return 0;
 }
 
+/**
+ * nntp_read_lines - Read the lines of a multi-line response
+ * @param mdata NNTP Mailbox data
+ * @param msg   Progess message (OPTIONAL)
+ * @param func  Callback function
+ * @param data  Data for callback function
+ * @retval  0 Success
+ * @retval -1 Connection lost
+ * @retval -2 Error in func(*line, *data)
+ *
+ * The status line must already have been read.  This function calls
+ * func(*line, *data) for each line, up to the terminating ".".
+ */
+static int nntp_read_lines(struct NntpMboxData *mdata, const char *msg,
+                           int (*func)(char *, void *), void *data)
+{
+  char buf[LONG_STRING];
+  unsigned int lines = 0;
+  size_t off = 0;
+  struct Progress progress;
+  int rc = 0;
+
+  if (msg)
+    mutt_progress_init(&progress, msg, MUTT_PROGRESS_MSG, ReadInc, 0);
+
+  char *line = mutt_mem_malloc(sizeof(buf));
+
+  while (true)
+  {
+    char *p = NULL;
+    int chunk = mutt_socket_readln_d(buf, sizeof(buf), mdata->adata->conn, MUTT_SOCK_LOG_HDR);
+    if (chunk < 0)
+    {
+      mdata->adata->status = NNTP_NONE;
+      rc = -1;
+      break;
+    }
+
+    p = buf;
+    if (!off && buf[0] == '.')
+    {
+      if (buf[1] == '\0')
+        break;
+      if (buf[1] == '.')
+        p++;
+    }
+
+    mutt_str_strfcpy(line + off, p, sizeof(buf));
+
+    if (chunk >= sizeof(buf))
+    {
+      /* the line continues, make room for the next chunk */
+      off += strlen(p);
+      mutt_mem_realloc(&line, off + sizeof(buf));
+    }
+    else
+    {
+      if (msg)
+        mutt_progress_update(&progress, ++lines, -1);
+
+      if (rc == 0 && func(line, data) < 0)
+        rc = -2;
+      off = 0;
+    }
+  }
+  FREE(&line);
+  return rc;
+}
+
 /**
  * nntp_fetch_lines - Read lines, calling a callback function for each
  * @param mdata NNTP Mailbox data
@@ -841,19 +914,11 @@ static int nntp_query(struct NntpMboxData *mdata, char *line, size_t linelen)
 static int nntp_fetch_lines(struct NntpMboxData *mdata, char *query, size_t qlen,
                             const char *msg, int (*func)(char *, void *), void *data)
 {
-  int done = false;
   int rc;
 
-  while (!done)
+  do
   {
     char buf[LONG_STRING];
-    char *line = NULL;
-    unsigned int lines = 0;
-    size_t off = 0;
-    struct Progress progress;
-
-    if (msg)
-      mutt_progress_init(&progress, msg, MUTT_PROGRESS_MSG, ReadInc, 0);
 
     mutt_str_strfcpy(buf, query, sizeof(buf));
     if (nntp_query(mdata, buf, sizeof(buf)) < 0)
@@ -864,50 +929,11 @@ static int nntp_fetch_lines(struct NntpMboxData *mdata, char *query, size_t qlen
       return 1;
     }
 
-    line = mutt_mem_malloc(sizeof(buf));
-    rc = 0;
-
-    while (true)
-    {
-      char *p = NULL;
-      int chunk = mutt_socket_readln_d(buf, sizeof(buf), mdata->adata->conn, MUTT_SOCK_LOG_HDR);
-      if (chunk < 0)
-      {
-        mdata->adata->status = NNTP_NONE;
-        break;
-      }
-
-      p = buf;
-      if (!off && buf[0] == '.')
-      {
-        if (buf[1] == '\0')
-        {
-          done = true;
-          break;
-        }
-        if (buf[1] == '.')
-          p++;
-      }
-
-      mutt_str_strfcpy(line + off, p, sizeof(buf));
-
-      if (chunk >= sizeof(buf))
-        off += strlen(p);
-      else
-      {
-        if (msg)
-          mutt_progress_update(&progress, ++lines, -1);
-
-        if (rc == 0 && func(line, data) < 0)
-          rc = -2;
-        off = 0;
-      }
-
-      mutt_mem_realloc(&line, off + sizeof(buf));
-    }
-    FREE(&line);
+    /* if the connection is lost, nntp_query() reconnects and we start again */
+    rc = nntp_read_lines(mdata, msg, func, data);
     func(NULL, data);
-  }
+  } while (rc == -1);
+
   return rc;
 }
 
@@ -1059,12 +1085,90 @@ static int fetch_numbers(char *line, void *data)
   return 0;
 }
 
+/**
+ * overview_has_field - Does the overview format contain a header field?
+ * @param fmt  Overview format, e.g. "Subject:\0From:\0...\0"
+ * @param name Name of the header field, e.g. "Xref"
+ * @retval true The overview lists the field
+ */
+static bool overview_has_field(const char *fmt, const char *name)
+{
+  const size_t len = mutt_str_strlen(name);
+
+  for (; fmt && *fmt; fmt = strchr(fmt, '\0') + 1)
+  {
+    if ((mutt_str_strncasecmp(fmt, name, len) == 0) && (fmt[len] == ':'))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * fetch_xref - Parse the Xref header of an article from a HDR response
+ * @param line String to parse
+ * @param data FetchCtx
+ * @retval 0 Always
+ */
+static int fetch_xref(char *line, void *data)
+{
+  struct FetchCtx *fc = data;
+  anum_t anum;
+
+  if (!line)
+    return 0;
+
+  char *value = strchr(line, ' ');
+  if (!value || (sscanf(line, ANUM, &anum) != 1))
+    return 0;
+  if (anum < fc->first || anum > fc->last)
+    return 0;
+
+  value = mutt_str_skip_email_wsp(value);
+  if (*value)
+    mutt_str_replace(&fc->xref[anum - fc->first], value);
+  return 0;
+}
+
+/**
+ * fetch_add_email - Add a newly fetched Email to the Mailbox
+ * @param fc   Fetch context
+ * @param e    Email
+ * @param anum Article number
+ *
+ * The Email must already have been stored at the end of the Mailbox's list.
+ */
+static void fetch_add_email(struct FetchCtx *fc, struct Email *e, anum_t anum)
+{
+  struct Mailbox *m = fc->ctx->mailbox;
+  struct NntpMboxData *mdata = m->mdata;
+
+  e->index = m->msg_count++;
+  e->read = false;
+  e->old = false;
+  e->deleted = false;
+  e->edata = nntp_edata_new();
+  e->free_edata = nntp_edata_free;
+  nntp_edata_get(e)->article_num = anum;
+  if (fc->restore)
+    e->changed = true;
+  else
+  {
+    nntp_article_status(m, e, NULL, anum);
+    if (!e->read)
+      nntp_parse_xref(m, e);
+  }
+  if (anum > mdata->last_loaded)
+    mdata->last_loaded = anum;
+}
+
 /**
  * parse_overview_line - Parse overview line
  * @param line String to parse
  * @param data FetchCtx
  * @retval  0 Success
  * @retval -1 Failure
+ *
+ * The Email is built straight from the fields of the overview line.
  */
 static int parse_overview_line(char *line, void *data)
 {
@@ -1100,61 +1204,21 @@ static int parse_overview_line(char *line, void *data)
     return 0;
   }
 
-  /* convert overview line to header */
-  FILE *fp = mutt_file_mkstemp();
-  if (!fp)
-    return -1;
-
-  header = mdata->adata->overview_fmt;
-  while (field)
-  {
-    char *b = field;
-
-    if (*header)
-    {
-      if (!strstr(header, ":full") && (fputs(header, fp) == EOF))
-      {
-        mutt_file_fclose(&fp);
-        return -1;
-      }
-      header = strchr(header, '\0') + 1;
-    }
-
-    field = strchr(field, '\t');
-    if (field)
-      *field++ = '\0';
-    if (fputs(b, fp) == EOF || fputc('\n', fp) == EOF)
-    {
-      mutt_file_fclose(&fp);
-      return -1;
-    }
-  }
-  rewind(fp);
-
   /* allocate memory for headers */
   if (ctx->mailbox->msg_count >= ctx->mailbox->hdrmax)
     mx_alloc_memory(ctx->mailbox);
 
-  /* parse header */
-  ctx->mailbox->hdrs[ctx->mailbox->msg_count] = mutt_email_new();
-  e = ctx->mailbox->hdrs[ctx->mailbox->msg_count];
-  e->env = mutt_rfc822_read_header(fp, e, false, false);
-  e->env->newsgroups = mutt_str_strdup(mdata->group);
-  e->received = e->date_sent;
-  mutt_file_fclose(&fp);
-
 #ifdef USE_HCACHE
   if (fc->hc)
   {
     char buf[16];
 
-    /* try to replace with header from cache */
+    /* try to use the header from cache, before parsing the overview */
     snprintf(buf, sizeof(buf), "%u", anum);
     void *hdata = mutt_hcache_fetch(fc->hc, buf, strlen(buf));
     if (hdata)
     {
       mutt_debug(2, "mutt_hcache_fetch %s\n", buf);
-      mutt_email_free(&e);
       e = mutt_hcache_restore(hdata);
       ctx->mailbox->hdrs[ctx->mailbox->msg_count] = e;
       mutt_hcache_free(fc->hc, &hdata);
@@ -1173,36 +1237,76 @@ static int parse_overview_line(char *line, void *data)
         save = false;
       }
     }
+  }
+#endif
+
+  if (!e)
+  {
+    /* parse the overview fields, as named by the overview format */
+    e = mutt_email_new();
+    ctx->mailbox->hdrs[ctx->mailbox->msg_count] = e;
+    e->env = mutt_env_new();
+    mutt_rfc822_init_content(e);
+
+    header = mdata->adata->overview_fmt;
+    while (field)
+    {
+      char name[STRING];
+      char *value = field;
+
+      field = strchr(field, '\t');
+      if (field)
+        *field++ = '\0';
+
+      /* ignore any fields beyond the overview format */
+      if (!*header)
+        continue;
+
+      char *colon = strchr(header, ':');
+      if (!colon)
+        colon = strchr(header, '\0');
+      if (strstr(header, ":full"))
+      {
+        /* the field carries its own name, e.g. "Xref: host group:1" */
+        colon = strchr(value, ':');
+        if (!colon)
+          colon = value;
+        mutt_str_strfcpy(name, value, MIN(sizeof(name), colon - value + 1));
+        value = (*colon == ':') ? colon + 1 : colon;
+      }
+      else
+        mutt_str_strfcpy(name, header, MIN(sizeof(name), colon - header + 1));
+      header = strchr(header, '\0') + 1;
+
+      value = mutt_str_skip_email_wsp(value);
+      if (*name && *value)
+        mutt_rfc822_parse_line(e->env, e, name, value, false, false, true);
+    }
+
+    if (fc->xref && fc->xref[anum - fc->first] && !e->env->xref)
+    {
+      e->env->xref = fc->xref[anum - fc->first];
+      fc->xref[anum - fc->first] = NULL;
+    }
 
+    mutt_rfc822_finish_header(e->env, e);
+    e->env->newsgroups = mutt_str_strdup(mdata->group);
+    e->received = e->date_sent;
+
+#ifdef USE_HCACHE
     /* not cached yet, store header */
-    else
+    if (fc->hc)
     {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u", anum);
       mutt_debug(2, "mutt_hcache_store %s\n", buf);
       mutt_hcache_store(fc->hc, buf, strlen(buf), e, 0);
     }
-  }
 #endif
+  }
 
   if (save)
-  {
-    e->index = ctx->mailbox->msg_count++;
-    e->read = false;
-    e->old = false;
-    e->deleted = false;
-    e->edata = nntp_edata_new();
-    e->free_edata = nntp_edata_free;
-    nntp_edata_get(e)->article_num = anum;
-    if (fc->restore)
-      e->changed = true;
-    else
-    {
-      nntp_article_status(ctx->mailbox, e, NULL, anum);
-      if (!e->read)
-        nntp_parse_xref(ctx->mailbox, e);
-    }
-    if (anum > mdata->last_loaded)
-      mdata->last_loaded = anum;
-  }
+    fetch_add_email(fc, e, anum);
   else
     mutt_email_free(&e);
 
@@ -1212,6 +1316,129 @@ static int parse_overview_line(char *line, void *data)
   return 0;
 }
 
+/**
+ * nntp_fetch_heads - Fetch the headers of articles, using pipelined HEADs
+ * @param fc    Fetch context
+ * @param anums Article numbers to fetch
+ * @param num   Number of articles
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Without OVER, each header needs its own HEAD command.  Rather than waiting
+ * for each reply, up to #NNTP_PIPELINE_DEPTH commands are kept in flight.
+ */
+static int nntp_fetch_heads(struct FetchCtx *fc, anum_t *anums, unsigned int num)
+{
+  struct Context *ctx = fc->ctx;
+  struct NntpMboxData *mdata = ctx->mailbox->mdata;
+  struct NntpAccountData *adata = mdata->adata;
+  char buf[HUGE_STRING];
+  unsigned int sent = 0;
+  unsigned int i;
+  int rc = 0;
+
+  FILE *fp = mutt_file_mkstemp();
+  if (!fp)
+  {
+    mutt_perror(_("Can't create temporary file"));
+    return -1;
+  }
+
+  /* make sure we're connected, and the group is selected */
+  if (adata->status != NNTP_OK)
+  {
+    buf[0] = '\0';
+    if (nntp_query(mdata, buf, sizeof(buf)) < 0)
+    {
+      mutt_file_fclose(&fp);
+      return -1;
+    }
+  }
+
+  for (i = 0; (i < num) && (rc == 0); i++)
+  {
+    /* keep the pipeline full */
+    for (; (sent < num) && (sent < i + NNTP_PIPELINE_DEPTH); sent++)
+    {
+      snprintf(buf, sizeof(buf), "HEAD %u\r\n", anums[sent]);
+      if (mutt_socket_send(adata->conn, buf) < 0)
+      {
+        adata->status = NNTP_NONE;
+        rc = -1;
+        break;
+      }
+    }
+    if (rc < 0)
+      break;
+
+    if (!ctx->mailbox->quiet)
+      mutt_progress_update(&fc->progress, anums[i] - fc->first + 1, -1);
+
+    if (mutt_socket_readln(buf, sizeof(buf), adata->conn) < 0)
+    {
+      adata->status = NNTP_NONE;
+      rc = -1;
+      break;
+    }
+
+    if (buf[0] != '2')
+    {
+      /* invalid response */
+      if (mutt_str_strncmp("423", buf, 3) != 0)
+      {
+        mutt_error("HEAD: %s", buf);
+        rc = -1;
+        break;
+      }
+
+      /* no such article */
+      if (mdata->bcache)
+      {
+        snprintf(buf, sizeof(buf), "%u", anums[i]);
+        mutt_debug(2, "#3 mutt_bcache_del %s\n", buf);
+        mutt_bcache_del(mdata->bcache, buf);
+      }
+      continue;
+    }
+
+    rewind(fp);
+    if (ftruncate(fileno(fp), 0) != 0)
+    {
+      mutt_perror(_("Can't create temporary file"));
+      rc = -1;
+      break;
+    }
+    rc = nntp_read_lines(mdata, NULL, fetch_tempfile, fp);
+    if (rc != 0)
+    {
+      rc = -1;
+      break;
+    }
+    rewind(fp);
+
+    /* allocate memory for headers */
+    if (ctx->mailbox->msg_count >= ctx->mailbox->hdrmax)
+      mx_alloc_memory(ctx->mailbox);
+
+    /* parse header */
+    struct Email *e = mutt_email_new();
+    ctx->mailbox->hdrs[ctx->mailbox->msg_count] = e;
+    e->env = mutt_rfc822_read_header(fp, e, false, false);
+    e->received = e->date_sent;
+    fetch_add_email(fc, e, anums[i]);
+  }
+  mutt_file_fclose(&fp);
+
+  /* replies may still be in flight, so the connection is out of step */
+  if ((rc != 0) && (sent > i + 1) && (adata->status == NNTP_OK))
+  {
+    mutt_socket_close(adata->conn);
+    adata->status = NNTP_NONE;
+  }
+
+  return rc;
+}
+
 /**
  * nntp_fetch_headers - Fetch headers
  * @param ctx     Mailbox
@@ -1233,6 +1460,8 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
   int oldmsgcount = ctx->mailbox->msg_count;
   anum_t current;
   anum_t first_over = first;
+  anum_t *heads = NULL;
+  unsigned int num_heads = 0;
 #ifdef USE_HCACHE
   void *hdata = NULL;
 #endif
@@ -1249,6 +1478,7 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
   fc.messages = mutt_mem_calloc(last - first + 1, sizeof(unsigned char));
   if (!fc.messages)
     return -1;
+  fc.xref = NULL;
 #ifdef USE_HCACHE
   fc.hc = hc;
 #endif
@@ -1372,90 +1602,67 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
         continue;
     }
 
-    /* fetch header from server */
+    /* fetch header from server, see nntp_fetch_heads() */
     else
     {
-      FILE *fp = mutt_file_mkstemp();
-      if (!fp)
-      {
-        mutt_perror(_("Can't create temporary file"));
-        rc = -1;
-        break;
-      }
-
-      snprintf(buf, sizeof(buf), "HEAD %u\r\n", current);
-      rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, fetch_tempfile, fp);
-      if (rc)
-      {
-        mutt_file_fclose(&fp);
-        if (rc < 0)
-          break;
-
-        /* invalid response */
-        if (mutt_str_strncmp("423", buf, 3) != 0)
-        {
-          mutt_error("HEAD: %s", buf);
-          break;
-        }
-
-        /* no such article */
-        if (mdata->bcache)
-        {
-          snprintf(buf, sizeof(buf), "%u", current);
-          mutt_debug(2, "#3 mutt_bcache_del %s\n", buf);
-          mutt_bcache_del(mdata->bcache, buf);
-        }
-        rc = 0;
-        continue;
-      }
-
-      /* parse header */
-      ctx->mailbox->hdrs[ctx->mailbox->msg_count] = mutt_email_new();
-      e = ctx->mailbox->hdrs[ctx->mailbox->msg_count];
-      e->env = mutt_rfc822_read_header(fp, e, false, false);
-      e->received = e->date_sent;
-      mutt_file_fclose(&fp);
+      if (!heads)
+        heads = mutt_mem_calloc(last - first + 1, sizeof(anum_t));
+      heads[num_heads++] = current;
+      continue;
     }
 
     /* save header in context */
-    e->index = ctx->mailbox->msg_count++;
-    e->read = false;
-    e->old = false;
-    e->deleted = false;
-    e->edata = nntp_edata_new();
-    e->free_edata = nntp_edata_free;
-    nntp_edata_get(e)->article_num = current;
-    if (restore)
-      e->changed = true;
-    else
-    {
-      nntp_article_status(ctx->mailbox, e, NULL, nntp_edata_get(e)->article_num);
-      if (!e->read)
-        nntp_parse_xref(ctx->mailbox, e);
-    }
-    if (current > mdata->last_loaded)
-      mdata->last_loaded = current;
+    fetch_add_email(&fc, e, current);
     first_over = current + 1;
   }
 
+  /* fetch the headers that weren't cached */
+  if (num_heads && (rc == 0))
+    rc = nntp_fetch_heads(&fc, heads, num_heads);
+  FREE(&heads);
+
   if (!NntpListgroup || !mdata->adata->hasLISTGROUP)
     current = first_over;
 
   /* fetch overview information */
-  if (current <= last && rc == 0 && !mdata->deleted)
+  if (current <= last && rc == 0 && !mdata->deleted &&
+      (mdata->adata->hasOVER || mdata->adata->hasXOVER))
   {
     char *cmd = mdata->adata->hasOVER ? "OVER" : "XOVER";
-    snprintf(buf, sizeof(buf), "%s %u-%u\r\n", cmd, current, last);
-    rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, parse_overview_line, &fc);
-    if (rc > 0)
+
+    /* the overview lacks Xref, which is needed to mark cross-posts as read */
+    if (mdata->adata->hasHDR && !overview_has_field(mdata->adata->overview_fmt, "Xref"))
     {
-      mutt_error("%s: %s", cmd, buf);
+      fc.xref = mutt_mem_calloc(last - first + 1, sizeof(char *));
+      snprintf(buf, sizeof(buf), "HDR Xref %u-%u\r\n", current, last);
+      rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, fetch_xref, &fc);
+      if (rc > 0)
+      {
+        mutt_debug(1, "HDR: %s\n", buf);
+        rc = 0;
+      }
+    }
+
+    if (rc == 0)
+    {
+      snprintf(buf, sizeof(buf), "%s %u-%u\r\n", cmd, current, last);
+      rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, parse_overview_line, &fc);
+      if (rc > 0)
+      {
+        mutt_error("%s: %s", cmd, buf);
+      }
     }
   }
 
   if (ctx->mailbox->msg_count > oldmsgcount)
     mx_update_context(ctx, ctx->mailbox->msg_count - oldmsgcount);
 
+  if (fc.xref)
+  {
+    for (current = first; current <= last; current++)
+      FREE(&fc.xref[current - first]);
+    FREE(&fc.xref);
+  }
   FREE(&fc.messages);
   if (rc != 0)
     return -1;
@@ -2893,6 +3100,8 @@ struct MxOps mx_nntp_ops = {
   .msg_commit       = NULL,
   .msg_close        = nntp_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = nntp_path_probe,
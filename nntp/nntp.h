@@ -78,6 +78,7 @@ struct NntpAccountData
   bool hasLISTGROUPrange  : 1;
   bool hasOVER            : 1;
   bool hasXOVER           : 1;
+  bool hasHDR             : 1;
   unsigned int use_tls    : 3;
   unsigned int status     : 3;
   bool cacheable          : 1;
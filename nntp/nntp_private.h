@@ -37,6 +37,8 @@ struct NntpMboxData;
 #define NNTP_PORT 119
 #define NNTP_SSL_PORT 563
 
+#define NNTP_PIPELINE_DEPTH 32 ///< Maximum number of HEAD commands in flight
+
 /**
  * enum NntpStatus - NNTP server return values
  */
@@ -2613,6 +2613,8 @@ struct MxOps mx_notmuch_ops = {
   .msg_commit       = nm_msg_commit,
   .msg_close        = nm_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = nm_tags_edit,
   .tags_commit      = nm_tags_commit,
   .path_probe       = nm_path_probe,
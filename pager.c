@@ -53,6 +53,7 @@
 #include "mutt_curses.h"
 #include "mutt_header.h"
 #include "mutt_logging.h"
+#include "mutt_poll.h"
 #include "mutt_window.h"
 #include "muttlib.h"
 #include "mx.h"
@@ -2324,7 +2325,11 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
     else
       OldHdr = NULL;
 
+    /* the timers may change the mailbox, see the check below */
+    const bool timers = Context && Context->mailbox && !OptAttachMsg;
+    mutt_poll_timers(MUTT_POLL_TIMER_COMMAND, timers);
     ch = km_dokey(MENU_PAGER);
+    mutt_poll_timers(MUTT_POLL_TIMER_COMMAND, false);
     if (ch >= 0)
     {
       mutt_clear_error();
@@ -2451,7 +2456,8 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
     if (ch < 0)
     {
       ch = 0;
-      mutt_timeout_hook();
+      if (!mutt_poll_woken())
+        mutt_timeout_hook();
       continue;
     }
 
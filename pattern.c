@@ -2242,8 +2242,14 @@ int mutt_pattern_func(int op, char *prompt)
   }
 
 #ifdef USE_IMAP
-  if (Context->mailbox->magic == MUTT_IMAP && imap_search(Context->mailbox, pat) < 0)
-    goto bail;
+  if (Context->mailbox->magic == MUTT_IMAP)
+  {
+    /* imap_search() overwrites the match and prefilter bits of the last
+     * search, so the next search-next must start again */
+    OptSearchInvalid = true;
+    if (imap_search(Context->mailbox, pat) < 0)
+      goto bail;
+  }
 #endif
 
   mutt_progress_init(&progress, _("Executing command on matching messages..."),
@@ -2266,7 +2272,8 @@ int mutt_pattern_func(int op, char *prompt)
       Context->mailbox->hdrs[i]->limited = false;
       Context->mailbox->hdrs[i]->collapsed = false;
       Context->mailbox->hdrs[i]->num_hidden = 0;
-      if (mutt_pattern_exec(pat, MUTT_MATCH_FULL_ADDRESS, Context,
+      if (!Context->mailbox->hdrs[i]->excluded &&
+          mutt_pattern_exec(pat, MUTT_MATCH_FULL_ADDRESS, Context,
                             Context->mailbox->hdrs[i], NULL))
       {
         Context->mailbox->hdrs[i]->virtual = Context->mailbox->vcount;
@@ -2283,8 +2290,8 @@ int mutt_pattern_func(int op, char *prompt)
     for (int i = 0; i < Context->mailbox->vcount; i++)
     {
       mutt_progress_update(&progress, i, -1);
-      if (mutt_pattern_exec(pat, MUTT_MATCH_FULL_ADDRESS, Context,
-                            Context->mailbox->hdrs[Context->mailbox->v2r[i]], NULL))
+      struct Email *e = Context->mailbox->hdrs[Context->mailbox->v2r[i]];
+      if (!e->excluded && mutt_pattern_exec(pat, MUTT_MATCH_FULL_ADDRESS, Context, e, NULL))
       {
         switch (op)
         {
@@ -2460,8 +2467,8 @@ int mutt_search_command(int cur, int op)
     {
       /* remember that we've already searched this message */
       e->searched = true;
-      e->matched =
-          mutt_pattern_exec(SearchPattern, MUTT_MATCH_FULL_ADDRESS, Context, e, NULL);
+      e->matched = !e->excluded &&
+                   mutt_pattern_exec(SearchPattern, MUTT_MATCH_FULL_ADDRESS, Context, e, NULL);
       if (e->matched > 0)
       {
         mutt_clear_error();
@@ -169,21 +169,50 @@ static int fetch_message(char *line, void *file)
   return 0;
 }
 
+/**
+ * pop_request_header - Ask the server for a message's size and header
+ * @param adata POP Account data
+ * @param e     Email header
+ * @retval  0 Success
+ * @retval -1 Connection lost
+ *
+ * The answers are read by pop_read_header().  This is only used if the server
+ * supports pipelining.
+ */
+static int pop_request_header(struct PopAccountData *adata, struct Email *e)
+{
+  char buf[SHORT_STRING];
+
+  snprintf(buf, sizeof(buf), "LIST %d\r\n", e->refno);
+  if (pop_query_send(adata, buf) < 0)
+    return -1;
+
+  snprintf(buf, sizeof(buf), "TOP %d 0\r\n", e->refno);
+  return pop_query_send(adata, buf);
+}
+
 /**
  * pop_read_header - Read header
  * @param adata POP Account data
  * @param e     Email header
+ * @param sent  If true, the commands were already sent by pop_request_header()
  * @retval  0 Success
  * @retval -1 Connection lost
  * @retval -2 Invalid command or execution error
  * @retval -3 Error writing to tempfile
+ *
+ * If the commands were sent, their answers are always read, unless the
+ * connection is lost.
  */
-static int pop_read_header(struct PopAccountData *adata, struct Email *e)
+static int pop_read_header(struct PopAccountData *adata, struct Email *e, bool sent)
 {
   FILE *f = mutt_file_mkstemp();
   if (!f)
   {
     mutt_perror(_("Can't create temporary file"));
+    /* the answers are on their way, and must be read anyway */
+    if (sent && (pop_skip_recv(adata, "LIST", false) == 0))
+      pop_skip_recv(adata, "TOP", true);
     return -3;
   }
 
@@ -192,24 +221,31 @@ static int pop_read_header(struct PopAccountData *adata, struct Email *e)
   char buf[LONG_STRING];
 
   snprintf(buf, sizeof(buf), "LIST %d\r\n", e->refno);
-  int rc = pop_query(adata, buf, sizeof(buf));
+  int rc = sent ? pop_query_recv(adata, buf, buf, sizeof(buf)) :
+                  pop_query(adata, buf, sizeof(buf));
   if (rc == 0)
-  {
     sscanf(buf, "+OK %d %zu", &index, &length);
 
+  /* a pipelined TOP must be read, even if LIST failed */
+  if ((rc == 0) || (sent && (rc == -2)))
+  {
+    char err_msg[POP_CMD_RESPONSE];
+    mutt_str_strfcpy(err_msg, adata->err_msg, sizeof(err_msg));
+
     snprintf(buf, sizeof(buf), "TOP %d 0\r\n", e->refno);
-    rc = pop_fetch_data(adata, buf, NULL, fetch_message, f);
+    int rc_top = sent ? pop_fetch_recv(adata, buf, NULL, fetch_message, f) :
+                        pop_fetch_data(adata, buf, NULL, fetch_message, f);
 
     if (adata->cmd_top == 2)
     {
-      if (rc == 0)
+      if (rc_top == 0)
       {
         adata->cmd_top = 1;
 
         mutt_debug(1, "set TOP capability\n");
       }
 
-      if (rc == -2)
+      if (rc_top == -2)
       {
         adata->cmd_top = 0;
 
@@ -218,6 +254,11 @@ static int pop_read_header(struct PopAccountData *adata, struct Email *e)
                  _("Command TOP is not supported by server"));
       }
     }
+
+    if ((rc == 0) || (rc_top == -1))
+      rc = rc_top;
+    else
+      mutt_str_strfcpy(adata->err_msg, err_msg, sizeof(adata->err_msg));
   }
 
   switch (rc)
@@ -451,52 +492,75 @@ static int pop_fetch_headers(struct Context *ctx)
           deleted);
     }
 
-    bool hcached = false;
+    /* Restore what we can from the header cache first, so the rest can be
+     * requested from the server in batches */
+    bool *hcached = mutt_mem_calloc(new_count - old_count + 1, sizeof(bool));
+#ifdef USE_HCACHE
     for (i = old_count; i < new_count; i++)
     {
-      if (!ctx->mailbox->quiet)
-        mutt_progress_update(&progress, i + 1 - old_count, -1);
       struct PopEmailData *edata = ctx->mailbox->hdrs[i]->edata;
-#ifdef USE_HCACHE
       void *data = mutt_hcache_fetch(hc, edata->uid, strlen(edata->uid));
-      if (data)
-      {
-        /* Detach the private data */
-        ctx->mailbox->hdrs[i]->edata = NULL;
-
-        int refno = ctx->mailbox->hdrs[i]->refno;
-        int index = ctx->mailbox->hdrs[i]->index;
-        /* - POP dynamically numbers headers and relies on e->refno
-         *   to map messages; so restore header and overwrite restored
-         *   refno with current refno, same for index
-         * - e->data needs to a separate pointer as it's driver-specific
-         *   data freed separately elsewhere
-         *   (the old e->data should point inside a malloc'd block from
-         *   hcache so there shouldn't be a memleak here)
-         */
-        struct Email *e = mutt_hcache_restore((unsigned char *) data);
-        mutt_hcache_free(hc, &data);
-        mutt_email_free(&ctx->mailbox->hdrs[i]);
-        ctx->mailbox->hdrs[i] = e;
-        ctx->mailbox->hdrs[i]->refno = refno;
-        ctx->mailbox->hdrs[i]->index = index;
-
-        /* Reattach the private data */
-        ctx->mailbox->hdrs[i]->edata = edata;
-        ctx->mailbox->hdrs[i]->free_edata = pop_edata_free;
-        ret = 0;
-        hcached = true;
-      }
-      else
+      if (!data)
+        continue;
+
+      /* Detach the private data */
+      ctx->mailbox->hdrs[i]->edata = NULL;
+
+      int refno = ctx->mailbox->hdrs[i]->refno;
+      int index = ctx->mailbox->hdrs[i]->index;
+      /* - POP dynamically numbers headers and relies on e->refno
+       *   to map messages; so restore header and overwrite restored
+       *   refno with current refno, same for index
+       * - e->data needs to a separate pointer as it's driver-specific
+       *   data freed separately elsewhere
+       *   (the old e->data should point inside a malloc'd block from
+       *   hcache so there shouldn't be a memleak here)
+       */
+      struct Email *e = mutt_hcache_restore((unsigned char *) data);
+      mutt_hcache_free(hc, &data);
+      mutt_email_free(&ctx->mailbox->hdrs[i]);
+      ctx->mailbox->hdrs[i] = e;
+      ctx->mailbox->hdrs[i]->refno = refno;
+      ctx->mailbox->hdrs[i]->index = index;
+
+      /* Reattach the private data */
+      ctx->mailbox->hdrs[i]->edata = edata;
+      ctx->mailbox->hdrs[i]->free_edata = pop_edata_free;
+      hcached[i - old_count] = true;
+    }
 #endif
-          if ((ret = pop_read_header(adata, ctx->mailbox->hdrs[i])) < 0)
-        break;
-#ifdef USE_HCACHE
-      else
+
+    /* With RFC2449 pipelining, a window of requests is kept in flight */
+    int next = old_count;
+    int pending = 0; /* number of messages whose answers haven't been read */
+    for (i = old_count; i < new_count; i++)
+    {
+      if (!ctx->mailbox->quiet)
+        mutt_progress_update(&progress, i + 1 - old_count, -1);
+      struct PopEmailData *edata = ctx->mailbox->hdrs[i]->edata;
+
+      if (!hcached[i - old_count])
       {
-        mutt_hcache_store(hc, edata->uid, strlen(edata->uid), ctx->mailbox->hdrs[i], 0);
+        for (; adata->pipelining && (next < new_count) && (next < i + POP_PIPELINE_DEPTH); next++)
+        {
+          if (hcached[next - old_count])
+            continue;
+          if (pop_request_header(adata, ctx->mailbox->hdrs[next]) < 0)
+          {
+            ret = -1;
+            break;
+          }
+          pending++;
+        }
+        if (ret == 0)
+        {
+          ret = pop_read_header(adata, ctx->mailbox->hdrs[i], adata->pipelining);
+          if (adata->pipelining)
+            pending--;
+        }
+        if (ret < 0)
+          break;
       }
-#endif
 
       /* faked support for flags works like this:
        * - if 'hcached' is true, we have the message in our hcache:
@@ -513,7 +577,7 @@ static int pop_fetch_headers(struct Context *ctx)
           (mutt_bcache_exists(adata->bcache, cache_id(edata->uid)) == 0);
       ctx->mailbox->hdrs[i]->old = false;
       ctx->mailbox->hdrs[i]->read = false;
-      if (hcached)
+      if (hcached[i - old_count])
       {
         if (bcached)
           ctx->mailbox->hdrs[i]->read = true;
@@ -529,6 +593,32 @@ static int pop_fetch_headers(struct Context *ctx)
       ctx->mailbox->msg_count++;
     }
 
+    /* Read the answers to the requests that are still in flight, so the
+     * connection is in step again.  If that fails, drop the connection;
+     * pop_reconnect() will start afresh. */
+    for (; pending > 0; pending--)
+    {
+      if ((pop_skip_recv(adata, "LIST", false) < 0) ||
+          (pop_skip_recv(adata, "TOP", true) < 0))
+      {
+        mutt_socket_close(adata->conn);
+        adata->status = POP_DISCONNECTED;
+        break;
+      }
+    }
+
+#ifdef USE_HCACHE
+    /* Hand the new headers to the header cache in one go */
+    for (int j = old_count; j < i; j++)
+    {
+      if (hcached[j - old_count])
+        continue;
+      struct PopEmailData *edata = ctx->mailbox->hdrs[j]->edata;
+      mutt_hcache_store(hc, edata->uid, strlen(edata->uid), ctx->mailbox->hdrs[j], 0);
+    }
+#endif
+    FREE(&hcached);
+
     if (i > old_count)
       mx_update_context(ctx, i - old_count);
   }
@@ -667,15 +757,45 @@ void pop_fetch_mail(void)
            bytes);
   mutt_message("%s", msgbuf);
 
-  for (int i = last + 1; i <= msgs; i++)
+  /* With RFC2449 pipelining, a window of requests is kept in flight */
+  const bool pipeline = adata->pipelining;
+  int requested = last;
+  int i;
+  bool retr_read = false; /* the answer to RETR i has been read */
+  bool dele_read = false; /* the answer to DELE i has been read */
+
+  for (i = last + 1; i <= msgs; i++)
   {
+    retr_read = false;
+    dele_read = false;
+
+    for (; pipeline && (requested < msgs) && (requested < i + POP_PIPELINE_DEPTH); requested++)
+    {
+      snprintf(buffer, sizeof(buffer), "RETR %d\r\n", requested + 1);
+      ret = pop_query_send(adata, buffer);
+      if ((ret == 0) && (delanswer == MUTT_YES))
+      {
+        snprintf(buffer, sizeof(buffer), "DELE %d\r\n", requested + 1);
+        ret = pop_query_send(adata, buffer);
+      }
+      if (ret < 0)
+      {
+        mx_mbox_close(&ctx, NULL);
+        goto fail;
+      }
+    }
+
+    snprintf(buffer, sizeof(buffer), "RETR %d\r\n", i);
     struct Message *msg = mx_msg_open_new(ctx, NULL, MUTT_ADD_FROM);
     if (!msg)
       ret = -3;
     else
     {
-      snprintf(buffer, sizeof(buffer), "RETR %d\r\n", i);
-      ret = pop_fetch_data(adata, buffer, NULL, fetch_message, msg->fp);
+      if (pipeline)
+        ret = pop_fetch_recv(adata, buffer, NULL, fetch_message, msg->fp);
+      else
+        ret = pop_fetch_data(adata, buffer, NULL, fetch_message, msg->fp);
+      retr_read = true;
       if (ret == -3)
         rset = 1;
 
@@ -692,7 +812,11 @@ void pop_fetch_mail(void)
     {
       /* delete the message on the server */
       snprintf(buffer, sizeof(buffer), "DELE %d\r\n", i);
-      ret = pop_query(adata, buffer, sizeof(buffer));
+      if (pipeline)
+        ret = pop_query_recv(adata, buffer, buffer, sizeof(buffer));
+      else
+        ret = pop_query(adata, buffer, sizeof(buffer));
+      dele_read = true;
     }
 
     if (ret == -1)
@@ -720,6 +844,28 @@ void pop_fetch_mail(void)
 
   mx_mbox_close(&ctx, NULL);
 
+  if (pipeline && (ret < 0))
+  {
+    /* The commands for the following messages have already been sent.  Read
+     * their answers, so that the connection is in step again. */
+    const bool dele = (delanswer == MUTT_YES);
+    if (!retr_read && (pop_skip_recv(adata, "RETR", true) < 0))
+      goto fail;
+    if (dele && !dele_read && (pop_skip_recv(adata, "DELE", false) < 0))
+      goto fail;
+    for (int j = i + 1; j <= requested; j++)
+    {
+      if (pop_skip_recv(adata, "RETR", true) < 0)
+        goto fail;
+      if (dele && (pop_skip_recv(adata, "DELE", false) < 0))
+        goto fail;
+    }
+
+    /* The server has deleted messages that weren't saved */
+    if (dele && ((requested > i) || !dele_read))
+      rset = 1;
+  }
+
   if (rset)
   {
     /* make sure no messages get deleted */
@@ -1294,6 +1440,8 @@ struct MxOps mx_pop_ops = {
   .msg_commit       = NULL,
   .msg_close        = pop_msg_close,
   .msg_padding_size = NULL,
+  .msg_save_parts   = NULL,
+  .msg_load_parts   = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = pop_path_probe,
@@ -153,6 +153,9 @@ static int fetch_capa(char *line, void *data)
   else if (mutt_str_strncasecmp(line, "TOP", 3) == 0)
     adata->cmd_top = 1;
 
+  else if (mutt_str_strncasecmp(line, "PIPELINING", 10) == 0)
+    adata->pipelining = true;
+
   return 0;
 }
 
@@ -205,6 +208,7 @@ static int pop_capabilities(struct PopAccountData *adata, int mode)
     adata->cmd_user = 0;
     adata->cmd_uidl = 0;
     adata->cmd_top = 0;
+    adata->pipelining = false;
     adata->resp_codes = false;
     adata->expire = true;
     adata->login_delay = 0;
@@ -450,6 +454,63 @@ void pop_logout(struct Mailbox *m)
   adata->status = POP_DISCONNECTED;
 }
 
+/**
+ * pop_query_send - Send a command without waiting for the answer
+ * @param adata POP Account data
+ * @param cmd   Command to send, including "\r\n"
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ *
+ * The answer must be collected with pop_query_recv() or pop_fetch_recv().
+ * Sending several commands before reading the answers is only allowed if the
+ * server supports RFC2449 PIPELINING.
+ */
+int pop_query_send(struct PopAccountData *adata, const char *cmd)
+{
+  if (adata->status != POP_CONNECTED)
+    return -1;
+
+  if (mutt_socket_send(adata->conn, cmd) < 0)
+  {
+    adata->status = POP_DISCONNECTED;
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * pop_query_recv - Receive the answer to a command
+ * @param adata  POP Account data
+ * @param cmd    Command that was sent, used for error messages
+ * @param buf    Buffer to store the answer
+ * @param buflen Buffer length
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ * @retval -2 Invalid command or execution error
+ *
+ * @note cmd and buf may be the same buffer
+ */
+int pop_query_recv(struct PopAccountData *adata, const char *cmd, char *buf, size_t buflen)
+{
+  if (adata->status != POP_CONNECTED)
+    return -1;
+
+  size_t len = strcspn(cmd, " \r\n");
+  snprintf(adata->err_msg, sizeof(adata->err_msg), "%.*s: ", (int) len, cmd);
+
+  if (mutt_socket_readln(buf, buflen, adata->conn) < 0)
+  {
+    adata->status = POP_DISCONNECTED;
+    return -1;
+  }
+  if (mutt_str_strncmp(buf, "+OK", 3) == 0)
+    return 0;
+
+  pop_error(adata, buf);
+  return -2;
+}
+
 /**
  * pop_query_d - Send data from buffer and receive answer to the same buffer
  * @param adata  POP Account data
@@ -476,47 +537,31 @@ int pop_query_d(struct PopAccountData *adata, char *buf, size_t buflen, char *ms
 
   mutt_socket_send_d(adata->conn, buf, dbg);
 
-  char *c = strpbrk(buf, " \r\n");
-  if (c)
-    *c = '\0';
-  snprintf(adata->err_msg, sizeof(adata->err_msg), "%s: ", buf);
-
-  if (mutt_socket_readln(buf, buflen, adata->conn) < 0)
-  {
-    adata->status = POP_DISCONNECTED;
-    return -1;
-  }
-  if (mutt_str_strncmp(buf, "+OK", 3) == 0)
-    return 0;
-
-  pop_error(adata, buf);
-  return -2;
+  return pop_query_recv(adata, buf, buf, buflen);
 }
 
 /**
- * pop_fetch_data - Read Headers with callback function
+ * pop_fetch_recv - Receive a multi-line answer with callback function
  * @param adata       POP Account data
- * @param query       POP query to send to server
+ * @param cmd         Command that was sent, used for error messages
  * @param progressbar Progress bar
- * @param func        Function called for each header read
+ * @param func        Function called for each line read
  * @param data        Data to pass to the callback
  * @retval  0 Successful
  * @retval -1 Connection lost
  * @retval -2 Invalid command or execution error
  * @retval -3 Error in func(*line, *data)
  *
- * This function calls  func(*line, *data)  for each received line,
- * func(NULL, *data)  if  rewind(*data)  needs, exits when fail or done.
+ * The command must already have been sent with pop_query_send().
  */
-int pop_fetch_data(struct PopAccountData *adata, const char *query,
+int pop_fetch_recv(struct PopAccountData *adata, const char *cmd,
                    struct Progress *progressbar, int (*func)(char *, void *), void *data)
 {
   char buf[LONG_STRING];
   long pos = 0;
   size_t lenbuf = 0;
 
-  mutt_str_strfcpy(buf, query, sizeof(buf));
-  int ret = pop_query(adata, buf, sizeof(buf));
+  int ret = pop_query_recv(adata, cmd, buf, sizeof(buf));
   if (ret < 0)
     return ret;
 
@@ -564,6 +609,68 @@ int pop_fetch_data(struct PopAccountData *adata, const char *query,
   return ret;
 }
 
+/**
+ * pop_fetch_data - Read Headers with callback function
+ * @param adata       POP Account data
+ * @param query       POP query to send to server
+ * @param progressbar Progress bar
+ * @param func        Function called for each header read
+ * @param data        Data to pass to the callback
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ * @retval -2 Invalid command or execution error
+ * @retval -3 Error in func(*line, *data)
+ *
+ * This function calls  func(*line, *data)  for each received line,
+ * func(NULL, *data)  if  rewind(*data)  needs, exits when fail or done.
+ */
+int pop_fetch_data(struct PopAccountData *adata, const char *query,
+                   struct Progress *progressbar, int (*func)(char *, void *), void *data)
+{
+  int ret = pop_query_send(adata, query);
+  if (ret < 0)
+    return ret;
+
+  return pop_fetch_recv(adata, query, progressbar, func, data);
+}
+
+/**
+ * skip_line - Discard a line of a multi-line answer
+ * @param line String to ignore
+ * @param data Unused
+ * @retval 0 Always
+ */
+static int skip_line(char *line, void *data)
+{
+  return 0;
+}
+
+/**
+ * pop_skip_recv - Read and discard the answer to a pipelined command
+ * @param adata     POP Account data
+ * @param cmd       Command that was sent, used for logging
+ * @param multiline If true, a successful answer has several lines
+ * @retval  0 Success, the whole answer was read
+ * @retval -1 Connection lost
+ *
+ * This keeps the connection in step after an error, when the answers to
+ * later commands are already on their way.  The server may have refused the
+ * command; that's not an error here.  The error message of the earlier
+ * failure is kept.
+ */
+int pop_skip_recv(struct PopAccountData *adata, const char *cmd, bool multiline)
+{
+  char buf[LONG_STRING];
+  char err_msg[POP_CMD_RESPONSE];
+  mutt_str_strfcpy(err_msg, adata->err_msg, sizeof(err_msg));
+
+  const int rc = multiline ? pop_fetch_recv(adata, cmd, NULL, skip_line, NULL) :
+                             pop_query_recv(adata, cmd, buf, sizeof(buf));
+
+  mutt_str_strfcpy(adata->err_msg, err_msg, sizeof(adata->err_msg));
+  return (rc == -1) ? -1 : 0;
+}
+
 /**
  * check_uidl - find message with this UIDL and set refno
  * @param line String containing UIDL
@@ -42,6 +42,9 @@ struct Progress;
 /* maximal length of the server response (RFC1939) */
 #define POP_CMD_RESPONSE 512
 
+/* number of messages requested at once, if the server supports pipelining */
+#define POP_PIPELINE_DEPTH 32
+
 /**
  * enum PopStatus - POP server responses
  */
@@ -88,6 +91,7 @@ struct PopAccountData
   unsigned int cmd_user : 2; /**< optional command USER */
   unsigned int cmd_uidl : 2; /**< optional command UIDL */
   unsigned int cmd_top : 2;  /**< optional command TOP */
+  bool pipelining : 1;       /**< server supports RFC2449 PIPELINING */
   bool resp_codes : 1;       /**< server supports extended response codes */
   bool expire : 1;           /**< expire is greater than 0 */
   bool clear_cache : 1;
@@ -131,8 +135,13 @@ int pop_parse_path(const char *path, struct ConnAccount *acct);
 int pop_connect(struct PopAccountData *adata);
 int pop_open_connection(struct PopAccountData *adata);
 int pop_query_d(struct PopAccountData *adata, char *buf, size_t buflen, char *msg);
+int pop_query_send(struct PopAccountData *adata, const char *cmd);
+int pop_query_recv(struct PopAccountData *adata, const char *cmd, char *buf, size_t buflen);
 int pop_fetch_data(struct PopAccountData *adata, const char *query, struct Progress *progressbar,
                    int (*func)(char *, void *), void *data);
+int pop_fetch_recv(struct PopAccountData *adata, const char *cmd, struct Progress *progressbar,
+                   int (*func)(char *, void *), void *data);
+int pop_skip_recv(struct PopAccountData *adata, const char *cmd, bool multiline);
 int pop_reconnect(struct Mailbox *m);
 void pop_logout(struct Mailbox *m);
 struct PopAccountData *pop_get_adata(struct Mailbox *m);
@@ -61,6 +61,9 @@ char *SmtpAuthenticators; ///< Config: (smtp) List of allowed authentication met
 #define SMTP_PORT 25
 #define SMTPS_PORT 465
 
+/* size of the blocks of message data sent to the server */
+#define SMTP_CHUNK_SIZE (64 * 1024)
+
 #define SMTP_AUTH_SUCCESS 0
 #define SMTP_AUTH_UNAVAIL 1
 #define SMTP_AUTH_FAIL -1
@@ -75,6 +78,8 @@ enum SmtpCapability
   DSN,
   EIGHTBITMIME,
   SMTPUTF8,
+  PIPELINING, /**< RFC2920: Command Pipelining */
+  CHUNKING,   /**< RFC3030: Transmission of Large and Binary MIME Messages */
 
   CAPMAX
 };
@@ -138,6 +143,10 @@ static int smtp_get_resp(struct Connection *conn)
       mutt_bit_set(Capabilities, STARTTLS);
     else if (mutt_str_strncasecmp("SMTPUTF8", buf + 4, 8) == 0)
       mutt_bit_set(Capabilities, SMTPUTF8);
+    else if (mutt_str_strncasecmp("PIPELINING", buf + 4, 10) == 0)
+      mutt_bit_set(Capabilities, PIPELINING);
+    else if (mutt_str_strncasecmp("CHUNKING", buf + 4, 8) == 0)
+      mutt_bit_set(Capabilities, CHUNKING);
 
     if (!valid_smtp_code(buf, n, &n))
       return SMTP_ERR_CODE;
@@ -151,14 +160,44 @@ static int smtp_get_resp(struct Connection *conn)
   return -1;
 }
 
+/**
+ * smtp_get_resps - Read the responses to pipelined commands
+ * @param conn    SMTP Connection
+ * @param pending Number of responses to read
+ * @retval  0 Success, every command succeeded
+ * @retval <0 Error, the first failure, e.g. #SMTP_ERR_READ
+ *
+ * All the responses are read, even after a failure, to keep the connection in
+ * step with the server.
+ */
+static int smtp_get_resps(struct Connection *conn, int pending)
+{
+  int rc = 0;
+
+  for (; pending > 0; pending--)
+  {
+    int r = smtp_get_resp(conn);
+    if (r == SMTP_ERR_READ || r == SMTP_ERR_CODE)
+      return r;
+    if (rc == 0)
+      rc = r;
+  }
+
+  return rc;
+}
+
 /**
  * smtp_rcpt_to - Set the recipient to an Address
- * @param conn Server Connection
- * @param a    Address to use
+ * @param conn    Server Connection
+ * @param a       Address to use
+ * @param pending If not NULL, don't wait for the replies, but count them
  * @retval  0 Success
  * @retval <0 Error, e.g. #SMTP_ERR_WRITE
+ *
+ * With RFC2920 pipelining, the caller collects the replies using
+ * smtp_get_resps().
  */
-static int smtp_rcpt_to(struct Connection *conn, const struct Address *a)
+static int smtp_rcpt_to(struct Connection *conn, const struct Address *a, int *pending)
 {
   char buf[1024];
   int r;
@@ -177,29 +216,69 @@ static int smtp_rcpt_to(struct Connection *conn, const struct Address *a)
       snprintf(buf, sizeof(buf), "RCPT TO:<%s>\r\n", a->mailbox);
     if (mutt_socket_send(conn, buf) == -1)
       return SMTP_ERR_WRITE;
-    r = smtp_get_resp(conn);
-    if (r != 0)
-      return r;
+    if (pending)
+      (*pending)++;
+    else
+    {
+      r = smtp_get_resp(conn);
+      if (r != 0)
+        return r;
+    }
     a = a->next;
   }
 
   return 0;
 }
 
+/**
+ * smtp_send_chunk - Send a block of message data to the server
+ * @param conn SMTP Connection
+ * @param buf  Message data
+ * @param bdat If true, wrap the data in a BDAT command (RFC3030)
+ * @param last If true, this is the final BDAT command
+ * @retval  0 Success
+ * @retval <0 Error, e.g. #SMTP_ERR_WRITE
+ */
+static int smtp_send_chunk(struct Connection *conn, struct Buffer *buf, bool bdat, bool last)
+{
+  size_t len = buf->dptr - buf->data;
+
+  if (bdat)
+  {
+    char cmd[STRING];
+    snprintf(cmd, sizeof(cmd), "BDAT %zu%s\r\n", len, last ? " LAST" : "");
+    if (mutt_socket_send(conn, cmd) == -1)
+      return SMTP_ERR_WRITE;
+  }
+
+  if ((len > 0) && (mutt_socket_write_d(conn, buf->data, len, MUTT_SOCK_LOG_FULL) == -1))
+    return SMTP_ERR_WRITE;
+
+  mutt_buffer_reset(buf);
+  return 0;
+}
+
 /**
  * smtp_data - Send data to an SMTP server
  * @param conn    SMTP Connection
  * @param msgfile Filename containing data
  * @retval  0 Success
  * @retval <0 Error, e.g. #SMTP_ERR_WRITE
+ *
+ * The message is sent in large blocks, rather than a line at a time.  If the
+ * server supports RFC3030 CHUNKING, each block is sent with BDAT, which saves
+ * the dot-stuffing and, with pipelining, the wait for the server.
  */
 static int smtp_data(struct Connection *conn, const char *msgfile)
 {
   char buf[1024];
   struct Progress progress;
   struct stat st;
-  int r, term = 0;
+  int r = 0, term = 0;
   size_t buflen = 0;
+  bool bdat = mutt_bit_isset(Capabilities, CHUNKING);
+  bool pipeline = mutt_bit_isset(Capabilities, PIPELINING);
+  int pending = 0;
 
   FILE *fp = fopen(msgfile, "r");
   if (!fp)
@@ -212,56 +291,65 @@ static int smtp_data(struct Connection *conn, const char *msgfile)
   mutt_progress_init(&progress, _("Sending message..."), MUTT_PROGRESS_SIZE,
                      NetInc, st.st_size);
 
-  snprintf(buf, sizeof(buf), "DATA\r\n");
-  if (mutt_socket_send(conn, buf) == -1)
-  {
-    mutt_file_fclose(&fp);
-    return SMTP_ERR_WRITE;
-  }
-  r = smtp_get_resp(conn);
-  if (r != 0)
+  if (!bdat)
   {
-    mutt_file_fclose(&fp);
-    return r;
+    snprintf(buf, sizeof(buf), "DATA\r\n");
+    if (mutt_socket_send(conn, buf) == -1)
+    {
+      mutt_file_fclose(&fp);
+      return SMTP_ERR_WRITE;
+    }
+    r = smtp_get_resp(conn);
+    if (r != 0)
+    {
+      mutt_file_fclose(&fp);
+      return r;
+    }
   }
 
+  struct Buffer *chunk = mutt_buffer_alloc(SMTP_CHUNK_SIZE + sizeof(buf));
+
   while (fgets(buf, sizeof(buf) - 1, fp))
   {
     buflen = mutt_str_strlen(buf);
     term = buflen && buf[buflen - 1] == '\n';
     if (term && (buflen == 1 || buf[buflen - 2] != '\r'))
       snprintf(buf + buflen - 1, sizeof(buf) - buflen + 1, "\r\n");
-    if (buf[0] == '.')
+    if (!bdat && (buf[0] == '.'))
+      mutt_buffer_addch(chunk, '.');
+    mutt_buffer_addstr(chunk, buf);
+
+    if (chunk->dptr - chunk->data >= SMTP_CHUNK_SIZE)
     {
-      if (mutt_socket_send_d(conn, ".", MUTT_SOCK_LOG_FULL) == -1)
+      r = smtp_send_chunk(conn, chunk, bdat, false);
+      if (r != 0)
+        break;
+      if (bdat)
       {
-        mutt_file_fclose(&fp);
-        return SMTP_ERR_WRITE;
+        if (pipeline)
+          pending++;
+        else if ((r = smtp_get_resp(conn)) != 0)
+          break;
       }
     }
-    if (mutt_socket_send_d(conn, buf, MUTT_SOCK_LOG_FULL) == -1)
-    {
-      mutt_file_fclose(&fp);
-      return SMTP_ERR_WRITE;
-    }
     mutt_progress_update(&progress, ftell(fp), -1);
   }
-  if (!term && buflen && mutt_socket_send_d(conn, "\r\n", MUTT_SOCK_LOG_FULL) == -1)
-  {
-    mutt_file_fclose(&fp);
-    return SMTP_ERR_WRITE;
-  }
   mutt_file_fclose(&fp);
 
-  /* terminate the message body */
-  if (mutt_socket_send(conn, ".\r\n") == -1)
-    return SMTP_ERR_WRITE;
-
-  r = smtp_get_resp(conn);
+  if (r == 0)
+  {
+    if (!term && buflen)
+      mutt_buffer_addstr(chunk, "\r\n");
+    /* terminate the message body */
+    if (!bdat)
+      mutt_buffer_addstr(chunk, ".\r\n");
+    r = smtp_send_chunk(conn, chunk, bdat, true);
+  }
+  mutt_buffer_free(&chunk);
   if (r != 0)
     return r;
 
-  return 0;
+  return smtp_get_resps(conn, pending + 1);
 }
 
 /**
@@ -792,16 +880,24 @@ int mutt_smtp_send(const struct Address *from, const struct Address *to,
       rc = SMTP_ERR_WRITE;
       break;
     }
-    rc = smtp_get_resp(conn);
-    if (rc != 0)
+
+    /* with RFC2920 pipelining, the envelope is sent in one go */
+    int pending = 0;
+    int *pipeline = mutt_bit_isset(Capabilities, PIPELINING) ? &pending : NULL;
+    if (pipeline)
+      pending++;
+    else if ((rc = smtp_get_resp(conn)) != 0)
       break;
 
     /* send the recipient list */
-    if ((rc = smtp_rcpt_to(conn, to)) || (rc = smtp_rcpt_to(conn, cc)) ||
-        (rc = smtp_rcpt_to(conn, bcc)))
+    if ((rc = smtp_rcpt_to(conn, to, pipeline)) || (rc = smtp_rcpt_to(conn, cc, pipeline)) ||
+        (rc = smtp_rcpt_to(conn, bcc, pipeline)))
     {
       break;
     }
+    rc = smtp_get_resps(conn, pending);
+    if (rc != 0)
+      break;
 
     /* send the message data */
     rc = smtp_data(conn, msgfile);
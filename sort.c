@@ -346,6 +346,102 @@ sort_t *mutt_get_sort_func(int method)
   /* not reached */
 }
 
+/**
+ * struct SortKey - The numeric fields of an Email that a sort compares
+ *
+ * Sorting on a number would otherwise follow a pointer to a different Email
+ * for every comparison.  Copying the keys into a dense array first keeps a
+ * large sort within the cache.
+ */
+struct SortKey
+{
+  long long key;       ///< Value of the primary sort field
+  long long aux;       ///< Value of the secondary sort field
+  struct Email *email; ///< Email the keys were copied from
+  int index;           ///< Email's index, to keep the sort stable
+};
+
+/**
+ * get_sort_key - Get the numeric sort key of an Email
+ * @param[in]  func Sort function, e.g. compare_date_sent()
+ * @param[in]  e    Email
+ * @param[out] key  Sort key
+ * @retval true  The sort function compares this number
+ * @retval false The sort function needs the whole Email
+ */
+static bool get_sort_key(sort_t *func, const struct Email *e, long long *key)
+{
+  if (func == compare_date_sent)
+    *key = e->date_sent;
+  else if (func == compare_date_received)
+    *key = e->received;
+  else if (func == compare_score)
+    *key = -e->score; /* compare_score() sorts in reverse */
+  else if (func == compare_size)
+    *key = e->content->length;
+  else if (func == compare_order)
+    *key = e->index;
+  else
+    return false;
+
+  return true;
+}
+
+/**
+ * compare_sort_keys - Compare the numeric keys of two emails - Implements ::sort_t
+ *
+ * The result matches the primary sort function and perform_auxsort().
+ */
+static int compare_sort_keys(const void *a, const void *b)
+{
+  const struct SortKey *ka = a;
+  const struct SortKey *kb = b;
+
+  int result = (ka->key > kb->key) - (ka->key < kb->key);
+  if (result == 0)
+  {
+    result = (ka->aux > kb->aux) - (ka->aux < kb->aux);
+    if (result == 0)
+      result = ka->index - kb->index;
+    if (SortAux & SORT_REVERSE)
+      result = -result;
+  }
+
+  return SORTCODE(result);
+}
+
+/**
+ * sort_by_key - Sort emails by numeric fields
+ * @param m    Mailbox
+ * @param func Sort function for the primary field
+ * @retval true  The emails have been sorted
+ * @retval false One of the sort functions doesn't compare a number
+ */
+static bool sort_by_key(struct Mailbox *m, sort_t *func)
+{
+  long long key = 0;
+  if (!get_sort_key(func, m->hdrs[0], &key) || !get_sort_key(AuxSort, m->hdrs[0], &key))
+    return false;
+
+  struct SortKey *keys = mutt_mem_malloc(m->msg_count * sizeof(struct SortKey));
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->hdrs[i];
+    get_sort_key(func, e, &keys[i].key);
+    get_sort_key(AuxSort, e, &keys[i].aux);
+    keys[i].email = e;
+    keys[i].index = e->index;
+  }
+
+  qsort(keys, m->msg_count, sizeof(struct SortKey), compare_sort_keys);
+
+  for (int i = 0; i < m->msg_count; i++)
+    m->hdrs[i] = keys[i].email;
+
+  FREE(&keys);
+  return true;
+}
+
 /**
  * mutt_sort_headers - Sort emails by their headers
  * @param ctx  Mailbox
@@ -414,7 +510,7 @@ void mutt_sort_headers(struct Context *ctx, bool init)
     mutt_error(_("Could not find sorting function [report this bug]"));
     return;
   }
-  else
+  else if (!sort_by_key(ctx->mailbox, sortfunc))
     qsort((void *) ctx->mailbox->hdrs, ctx->mailbox->msg_count,
           sizeof(struct Email *), sortfunc);
 
@@ -1,7 +1,9 @@
 #define TEST_NO_MAIN
 #include "acutest.h"
 #include "email/address.h"
+#include "mutt/intern.h"
 #include "mutt/memory.h"
+#include "mutt/string2.h"
 #include <string.h>
 
 #define TEST_CHECK_STR_EQ(expected, actual)                                    \
@@ -91,3 +93,66 @@ void test_addr_mbox_to_udomain(void)
     TEST_CHECK_STR_EQ(expected, actual);
   }
 }
+
+void test_addr_intern(void)
+{
+  struct Address *a1 = mutt_addr_parse_list(NULL, "Bob <bob@example.com>, jim@example.com");
+  struct Address *a2 = mutt_addr_parse_list(NULL, "Bob <bob@example.com>");
+  size_t count = mutt_str_intern_count();
+
+  mutt_addr_intern(a1);
+  mutt_addr_intern(a2);
+  TEST_CHECK(mutt_str_intern_count() == count + 3);
+  TEST_CHECK(a1->personal == a2->personal);
+  TEST_CHECK(a1->mailbox == a2->mailbox);
+  TEST_CHECK(a1->interned && a2->interned);
+
+  /* changing one address mustn't affect the other */
+  mutt_addr_qualify(a1->next, "example.org");
+  mutt_addr_set_local(a1, mutt_str_strdup("robert@example.com"));
+  TEST_CHECK(!a1->interned);
+  TEST_CHECK_STR_EQ("robert@example.com", a1->mailbox);
+  TEST_CHECK_STR_EQ("Bob", a1->personal);
+  TEST_CHECK_STR_EQ("bob@example.com", a2->mailbox);
+
+  mutt_addr_free(&a1);
+  mutt_addr_free(&a2);
+  TEST_CHECK(mutt_str_intern_count() == count);
+}
+
+void test_addr_parse_cache(void)
+{
+  static const char header[] = "Bob <bob@example.com>, (Jim) jim@example.com";
+
+  struct Address *a1 = mutt_addr_parse_list(NULL, header);
+  struct Address *a2 = mutt_addr_parse_list(NULL, header);
+  TEST_CHECK(AddressError == 0);
+
+  /* the second list is a private copy of the first */
+  TEST_CHECK(a1 && a2 && a1->next && a2->next && (a1 != a2));
+  TEST_CHECK(mutt_addr_cmp_strict(a1, a2));
+  TEST_CHECK(a1->mailbox != a2->mailbox);
+  TEST_CHECK_STR_EQ("Jim", a2->next->personal);
+
+  mutt_str_replace(&a1->mailbox, "robert@example.com");
+  mutt_addr_free(&a2);
+  a2 = mutt_addr_parse_list(NULL, header);
+  TEST_CHECK_STR_EQ("bob@example.com", a2->mailbox);
+
+  /* appending to a list still works */
+  a2 = mutt_addr_parse_list(a2, header);
+  TEST_CHECK(a2 && a2->next && a2->next->next && a2->next->next->next);
+  TEST_CHECK(!a2->next->next->next->next);
+
+  /* a list with errors isn't cached, so the error is reported every time */
+  for (int i = 0; i < 2; i++)
+  {
+    struct Address *a3 = mutt_addr_parse_list(NULL, "jim@example.com, bob@example.com@");
+    TEST_CHECK(AddressError == ERR_BAD_ADDR_SPEC);
+    mutt_addr_free(&a3);
+  }
+
+  mutt_addr_free(&a1);
+  mutt_addr_free(&a2);
+  mutt_addr_cache_cleanup();
+}
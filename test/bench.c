@@ -0,0 +1,36 @@
+#include "config.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench.h"
+
+/**
+ * bench_enabled - Has the user asked for benchmarks?
+ * @retval true NEOMUTT_BENCH is set
+ */
+bool bench_enabled(void)
+{
+  return getenv("NEOMUTT_BENCH") != NULL;
+}
+
+/**
+ * bench_rounds - How many times should a benchmark run?
+ * @param def Number of rounds for a normal test run
+ * @retval num Rounds from NEOMUTT_BENCH, or def if it isn't set
+ */
+long bench_rounds(long def)
+{
+  const char *bench = getenv("NEOMUTT_BENCH");
+  return bench ? atol(bench) : def;
+}
+
+/**
+ * bench_time - Read the monotonic clock
+ * @retval num Time in seconds
+ */
+double bench_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
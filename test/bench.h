@@ -0,0 +1,12 @@
+#ifndef MUTT_TEST_BENCH_H
+#define MUTT_TEST_BENCH_H
+
+#include <stdbool.h>
+
+/* Set NEOMUTT_BENCH=<rounds> to run the tests' benchmarks */
+
+bool   bench_enabled(void);
+long   bench_rounds(long def);
+double bench_time(void);
+
+#endif /* MUTT_TEST_BENCH_H */
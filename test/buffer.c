@@ -0,0 +1,58 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdio.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+#include "mutt/buffer.h"
+#include "mutt/memory.h"
+
+#ifdef USE_PTHREADS
+static void *pool_worker(void *arg)
+{
+  struct Buffer *bufs[20];
+  for (int round = 0; round < 1000; round++)
+  {
+    for (int i = 0; i < 20; i++)
+    {
+      bufs[i] = mutt_buffer_pool_get();
+      mutt_buffer_printf(bufs[i], "%d-%d", round, i);
+    }
+    /* release them in a different order, to mix up the caches */
+    for (int i = 19; i >= 0; i--)
+      mutt_buffer_pool_release(&bufs[i]);
+  }
+  return NULL;
+}
+#endif
+
+void test_buffer_pool(void)
+{
+  mutt_buffer_pool_init();
+
+  struct Buffer *a = mutt_buffer_pool_get();
+  struct Buffer *b = mutt_buffer_pool_get();
+  TEST_CHECK(a && b && (a != b));
+  mutt_buffer_addstr(a, "hello");
+  mutt_buffer_pool_release(&a);
+  TEST_CHECK(a == NULL);
+
+  /* a released Buffer comes back empty */
+  a = mutt_buffer_pool_get();
+  TEST_CHECK(mutt_buffer_is_empty(a));
+  mutt_buffer_pool_release(&a);
+  mutt_buffer_pool_release(&b);
+
+#ifdef USE_PTHREADS
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++)
+    TEST_CHECK(pthread_create(&threads[i], NULL, pool_worker, NULL) == 0);
+  pool_worker(NULL);
+  for (int i = 0; i < 4; i++)
+    pthread_join(threads[i], NULL);
+#endif
+
+  mutt_buffer_pool_free();
+}
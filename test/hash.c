@@ -0,0 +1,239 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include "mutt/hash.h"
+#include "mutt/memory.h"
+#include "mutt/string2.h"
+#include "bench.h"
+
+static int destroyed = 0;
+
+static void count_destroy(int type, void *obj, intptr_t data)
+{
+  destroyed++;
+}
+
+void test_hash_string(void)
+{
+  char key[32];
+  /* start small, to make the table grow several times */
+  struct Hash *table = mutt_hash_create(4, MUTT_HASH_STRDUP_KEYS);
+  mutt_hash_set_destructor(table, count_destroy, 0);
+
+  for (intptr_t i = 0; i < 5000; i++)
+  {
+    snprintf(key, sizeof(key), "<%ld@example.com>", (long) i);
+    TEST_CHECK(mutt_hash_insert(table, key, (void *) (i + 1)) != NULL);
+  }
+
+  /* duplicates are rejected */
+  TEST_CHECK(mutt_hash_insert(table, "<42@example.com>", NULL) == NULL);
+
+  for (intptr_t i = 0; i < 5000; i++)
+  {
+    snprintf(key, sizeof(key), "<%ld@example.com>", (long) i);
+    if (!TEST_CHECK(mutt_hash_find(table, key) == (void *) (i + 1)))
+      TEST_MSG("Key: %s", key);
+  }
+  TEST_CHECK(mutt_hash_find(table, "<5000@example.com>") == NULL);
+
+  /* delete every other key, the rest must still be found */
+  destroyed = 0;
+  for (intptr_t i = 0; i < 5000; i += 2)
+  {
+    snprintf(key, sizeof(key), "<%ld@example.com>", (long) i);
+    mutt_hash_delete(table, key, NULL);
+  }
+  TEST_CHECK(destroyed == 2500);
+
+  for (intptr_t i = 0; i < 5000; i++)
+  {
+    snprintf(key, sizeof(key), "<%ld@example.com>", (long) i);
+    void *expected = (i % 2) ? (void *) (i + 1) : NULL;
+    if (!TEST_CHECK(mutt_hash_find(table, key) == expected))
+      TEST_MSG("Key: %s", key);
+  }
+
+  size_t count = 0;
+  struct HashWalkState state = { 0 };
+  while (mutt_hash_walk(table, &state))
+    count++;
+  TEST_CHECK(count == 2500);
+
+  destroyed = 0;
+  mutt_hash_destroy(&table);
+  TEST_CHECK(destroyed == 2500);
+  TEST_CHECK(table == NULL);
+}
+
+void test_hash_dups(void)
+{
+  struct Hash *table = mutt_hash_create(16, MUTT_HASH_ALLOW_DUPS | MUTT_HASH_STRCASECMP);
+  int a = 1, b = 2, c = 3;
+
+  mutt_hash_insert(table, "Subject", &a);
+  mutt_hash_insert(table, "subject", &b);
+  mutt_hash_insert(table, "SUBJECT", &c);
+  mutt_hash_insert(table, "other", &a);
+
+  /* the newest entry is found first */
+  TEST_CHECK(mutt_hash_find(table, "sUbJeCt") == &c);
+
+  int count = 0;
+  for (struct HashElem *he = mutt_hash_find_bucket(table, "subject"); he; he = he->next)
+    count++;
+  TEST_CHECK(count == 3);
+
+  mutt_hash_delete(table, "subject", &c);
+  TEST_CHECK(mutt_hash_find(table, "subject") == &b);
+
+  mutt_hash_delete(table, "subject", NULL);
+  TEST_CHECK(mutt_hash_find(table, "subject") == NULL);
+  TEST_CHECK(mutt_hash_find_bucket(table, "subject") == NULL);
+  TEST_CHECK(mutt_hash_find(table, "OTHER") == &a);
+
+  mutt_hash_destroy(&table);
+}
+
+void test_hash_int(void)
+{
+  struct Hash *table = mutt_hash_int_create(0, 0);
+
+  for (uintptr_t i = 1; i <= 10000; i++)
+    mutt_hash_int_insert(table, i * 7, (void *) i);
+
+  for (uintptr_t i = 1; i <= 10000; i++)
+  {
+    if (!TEST_CHECK(mutt_hash_int_find(table, i * 7) == (void *) i))
+      TEST_MSG("Key: %lu", (unsigned long) (i * 7));
+  }
+  TEST_CHECK(mutt_hash_int_find(table, 8) == NULL);
+
+  /* deleting keys mustn't hide the ones that follow them */
+  for (uintptr_t i = 1; i < 10000; i++)
+  {
+    mutt_hash_int_delete(table, i * 7, NULL);
+    if (!TEST_CHECK(mutt_hash_int_find(table, (i + 1) * 7) == (void *) (i + 1)))
+      TEST_MSG("Key: %lu", (unsigned long) ((i + 1) * 7));
+  }
+  mutt_hash_int_delete(table, 70000, NULL);
+
+  struct HashWalkState state = { 0 };
+  TEST_CHECK(mutt_hash_walk(table, &state) == NULL);
+
+  mutt_hash_destroy(&table);
+}
+
+/**
+ * hash_bench_string - Time the operations on a string-keyed table
+ * @param keys   Keys to insert
+ * @param misses Keys that aren't in the table
+ * @param num    Number of keys
+ * @param size   Initial size of the table
+ * @param ns     Nanoseconds per insert, hit, miss and delete are added here
+ */
+static void hash_bench_string(char **keys, char **misses, size_t num, size_t size, double ns[4])
+{
+  double t[5];
+  size_t found = 0;
+
+  struct Hash *table = mutt_hash_create(size, 0);
+
+  t[0] = bench_time();
+  for (size_t i = 0; i < num; i++)
+    mutt_hash_insert(table, keys[i], keys[i]);
+  t[1] = bench_time();
+  for (size_t i = 0; i < num; i++)
+    found += (mutt_hash_find(table, keys[i]) == keys[i]);
+  t[2] = bench_time();
+  for (size_t i = 0; i < num; i++)
+    found += (mutt_hash_find(table, misses[i]) != NULL);
+  t[3] = bench_time();
+  for (size_t i = 0; i < num; i++)
+    mutt_hash_delete(table, keys[i], NULL);
+  t[4] = bench_time();
+
+  TEST_CHECK(found == num);
+  mutt_hash_destroy(&table);
+
+  for (int i = 0; i < 4; i++)
+  {
+    ns[i] += (t[i + 1] - t[i]) * 1e9 / num;
+  }
+}
+
+/**
+ * hash_bench_int - Time the operations on an integer-keyed table
+ * @param num  Number of keys
+ * @param size Initial size of the table
+ * @param ns   Nanoseconds per insert and hit are added here
+ */
+static void hash_bench_int(size_t num, size_t size, double ns[2])
+{
+  double t[3];
+  size_t found = 0;
+
+  struct Hash *table = mutt_hash_int_create(size, 0);
+
+  t[0] = bench_time();
+  for (uintptr_t i = 1; i <= num; i++)
+    mutt_hash_int_insert(table, i, (void *) i);
+  t[1] = bench_time();
+  for (uintptr_t i = 1; i <= num; i++)
+    found += (mutt_hash_int_find(table, i) == (void *) i);
+  t[2] = bench_time();
+
+  TEST_CHECK(found == num);
+  mutt_hash_destroy(&table);
+
+  for (int i = 0; i < 2; i++)
+  {
+    ns[i] += (t[i + 1] - t[i]) * 1e9 / num;
+  }
+}
+
+void test_hash_throughput(void)
+{
+  /* Set NEOMUTT_BENCH=<rounds> to measure the speed of the table */
+  long rounds = bench_rounds(1);
+  size_t num = bench_enabled() ? 200000 : 10000;
+  char key[64];
+
+  char **keys = mutt_mem_calloc(num, sizeof(char *));
+  char **misses = mutt_mem_calloc(num, sizeof(char *));
+  for (size_t i = 0; i < num; i++)
+  {
+    snprintf(key, sizeof(key), "<%zu.%08zx@mail.example.com>", i, i * 2654435761U);
+    keys[i] = mutt_str_strdup(key);
+    snprintf(key, sizeof(key), "<%zu.%08zx@mail.example.org>", i, i * 2654435761U);
+    misses[i] = mutt_str_strdup(key);
+  }
+
+  double sized[4] = { 0 }, small[4] = { 0 }, ints[2] = { 0 };
+  for (long r = 0; r < rounds; r++)
+  {
+    hash_bench_string(keys, misses, num, num * 2, sized);
+    hash_bench_string(keys, misses, num, 1009, small);
+    hash_bench_int(num, 30, ints);
+  }
+
+  if (bench_enabled())
+  {
+    printf("\n  %zu keys, ns per insert/hit/miss/delete\n", num);
+    printf("  sized 2N:    %6.0f %6.0f %6.0f %6.0f\n", sized[0] / rounds,
+           sized[1] / rounds, sized[2] / rounds, sized[3] / rounds);
+    printf("  sized 1009:  %6.0f %6.0f %6.0f %6.0f\n", small[0] / rounds,
+           small[1] / rounds, small[2] / rounds, small[3] / rounds);
+    printf("  int, sized 30: %4.0f %6.0f\n", ints[0] / rounds, ints[1] / rounds);
+  }
+
+  for (size_t i = 0; i < num; i++)
+  {
+    FREE(&keys[i]);
+    FREE(&misses[i]);
+  }
+  FREE(&keys);
+  FREE(&misses);
+}
@@ -0,0 +1,62 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdio.h>
+#include <time.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+#include "mutt/logging.h"
+
+#define LINES_PER_THREAD 1000
+
+static int lines_seen = 0;
+
+static int count_lines(time_t stamp, const char *file, int line,
+                       const char *function, int level, ...)
+{
+  lines_seen++;
+  return 0;
+}
+
+static void *queue_worker(void *arg)
+{
+  for (int i = 0; i < LINES_PER_THREAD; i++)
+    log_disp_queue(0, __FILE__, __LINE__, __func__, LL_DEBUG1, "line %d\n", i);
+  return NULL;
+}
+
+void test_log_queue(void)
+{
+  log_queue_empty();
+  log_queue_set_max_size(0);
+
+#ifdef USE_PTHREADS
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++)
+    TEST_CHECK(pthread_create(&threads[i], NULL, queue_worker, NULL) == 0);
+  queue_worker(NULL);
+  for (int i = 0; i < 4; i++)
+    pthread_join(threads[i], NULL);
+  const int total = 5 * LINES_PER_THREAD;
+#else
+  queue_worker(NULL);
+  const int total = LINES_PER_THREAD;
+#endif
+
+  /* no lines are lost */
+  lines_seen = 0;
+  log_queue_flush(count_lines);
+  TEST_CHECK(lines_seen == total);
+  TEST_MSG("Expected: %d, Actual: %d", total, lines_seen);
+
+  /* the oldest lines are dropped */
+  log_queue_set_max_size(10);
+  queue_worker(NULL);
+  lines_seen = 0;
+  log_queue_flush(count_lines);
+  TEST_CHECK(lines_seen == 10);
+
+  log_queue_set_max_size(0);
+}
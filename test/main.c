@@ -1,5 +1,12 @@
+#include "config.h"
 #include "acutest.h"
 
+#ifdef USE_HCACHE
+#define NEOMUTT_TEST_HCACHE NEOMUTT_TEST_ITEM(test_serial_parts)
+#else
+#define NEOMUTT_TEST_HCACHE
+#endif
+
 /******************************************************************************
  * Add your test cases to this list.
  *****************************************************************************/
@@ -8,16 +15,31 @@
   NEOMUTT_TEST_ITEM(test_base64_decode)                                        \
   NEOMUTT_TEST_ITEM(test_base64_lengths)                                       \
   NEOMUTT_TEST_ITEM(test_rfc2047)                                              \
+  NEOMUTT_TEST_ITEM(test_rfc2047_throughput)                                   \
+  NEOMUTT_TEST_ITEM(test_buffer_pool)                                          \
+  NEOMUTT_TEST_ITEM(test_hash_string)                                          \
+  NEOMUTT_TEST_ITEM(test_hash_dups)                                            \
+  NEOMUTT_TEST_ITEM(test_hash_int)                                             \
+  NEOMUTT_TEST_ITEM(test_hash_throughput)                                      \
+  NEOMUTT_TEST_ITEM(test_log_queue)                                            \
+  NEOMUTT_TEST_ITEM(test_mbox_parse_threads)                                   \
   NEOMUTT_TEST_ITEM(test_md5)                                                  \
   NEOMUTT_TEST_ITEM(test_md5_ctx)                                              \
   NEOMUTT_TEST_ITEM(test_md5_ctx_bytes)                                        \
+  NEOMUTT_TEST_ITEM(test_rfc822_parse_header)                                  \
+  NEOMUTT_TEST_ITEM(test_socket_buffer)                                        \
+  NEOMUTT_TEST_ITEM(test_socket_flush_read)                                    \
+  NEOMUTT_TEST_ITEM(test_socket_flush_fail)                                    \
   NEOMUTT_TEST_ITEM(test_string_strfcpy)                                       \
   NEOMUTT_TEST_ITEM(test_string_strnfcpy)                                      \
   NEOMUTT_TEST_ITEM(test_string_strcasestr)                                    \
   NEOMUTT_TEST_ITEM(test_addr_mbox_to_udomain)                                 \
+  NEOMUTT_TEST_ITEM(test_addr_intern)                                          \
+  NEOMUTT_TEST_ITEM(test_addr_parse_cache)                                     \
   NEOMUTT_TEST_ITEM(test_mutt_path_tidy_slash)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_path_tidy_dotdot)                                \
-  NEOMUTT_TEST_ITEM(test_mutt_path_tidy)
+  NEOMUTT_TEST_ITEM(test_mutt_path_tidy)                                       \
+  NEOMUTT_TEST_HCACHE
 
 /******************************************************************************
  * You probably don't need to touch what follows.
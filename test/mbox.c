@@ -0,0 +1,182 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "mbox/map.h"
+#include "bench.h"
+
+/**
+ * struct TestMbox - The Emails parsed from a test mailbox
+ */
+struct TestMbox
+{
+  struct Email **emails;
+  int count;
+  int max;
+};
+
+static void test_mbox_add(struct Email *e, void *data)
+{
+  struct TestMbox *tm = data;
+
+  if (tm->count == tm->max)
+  {
+    tm->max += 1024;
+    mutt_mem_realloc(&tm->emails, tm->max * sizeof(struct Email *));
+  }
+  e->index = tm->count;
+  tm->emails[tm->count++] = e;
+}
+
+static void test_mbox_free(struct TestMbox *tm)
+{
+  for (int i = 0; i < tm->count; i++)
+    mutt_email_free(&tm->emails[i]);
+  FREE(&tm->emails);
+  tm->count = 0;
+  tm->max = 0;
+}
+
+/**
+ * test_mbox_build - Create a large mailbox in memory
+ * @param[in]  size  Minimum size of the mailbox
+ * @param[out] count Number of messages
+ * @retval ptr Mailbox text
+ *
+ * The messages vary: some have a valid Content-Length, some a wrong one, some
+ * none at all, and some have a quoted ">From " line in their body.  Some of
+ * those with a valid Content-Length have a bare "From " separator in their
+ * body, which mustn't start a new message.
+ */
+static char *test_mbox_build(size_t size, int *count)
+{
+  struct Buffer *buf = mutt_buffer_alloc(size + 4096);
+  char body[1024];
+
+  int i;
+  for (i = 0; buf->dptr - buf->data < (ptrdiff_t) size; i++)
+  {
+    snprintf(body, sizeof(body), "Message %d\n%s%s%.*s\n", i,
+             (i % 7 == 0) ? ">From the body of a message\n" : "",
+             (i % 6 == 0) ? "\nFrom forwarded@example.com Sun Dec 31 23:59:59 2017\n" : "",
+             (i * 37) % 400,
+             "lorem ipsum dolor sit amet consectetur adipiscing elit sed do "
+             "eiusmod tempor incididunt ut labore et dolore magna aliqua ut "
+             "enim ad minim veniam quis nostrud exercitation ullamco laboris "
+             "nisi ut aliquip ex ea commodo consequat duis aute irure dolor in "
+             "reprehenderit in voluptate velit esse cillum dolore eu fugiat "
+             "nulla pariatur excepteur sint occaecat cupidatat non proident "
+             "sunt in culpa qui officia deserunt mollit anim id est laborum");
+
+    mutt_buffer_add_printf(buf, "From user%d@example.com Mon Jan %2d 12:%02d:%02d 2018\n",
+                           i % 13, (i % 28) + 1, (i / 60) % 60, i % 60);
+    mutt_buffer_add_printf(buf, "From: User %d <user%d@example.com>\n", i, i % 13);
+    mutt_buffer_add_printf(buf, "To: list@example.com, other%d@example.com\n", i % 5);
+    mutt_buffer_add_printf(buf, "Subject: Test message %d\n", i);
+    mutt_buffer_add_printf(buf, "Message-ID: <%d@example.com>\n", i);
+    if (i % 3 == 0)
+      mutt_buffer_add_printf(buf, "Content-Length: %zu\n", strlen(body));
+    else if (i % 11 == 0)
+      mutt_buffer_add_printf(buf, "Content-Length: %zu\n", strlen(body) + 5);
+    mutt_buffer_add_printf(buf, "\n%s\n", body);
+  }
+
+  *count = i;
+  char *map = buf->data;
+  buf->data = NULL;
+  mutt_buffer_free(&buf);
+  return map;
+}
+
+static double test_mbox_parse(const char *map, size_t size, int threads,
+                              struct TestMbox *tm)
+{
+  struct MboxMap mm = { map, size, test_mbox_add, NULL, tm };
+  LOFF_T pos = 0;
+
+  double start = bench_time();
+  int count = mbox_map_parse(&mm, &pos, threads);
+  double end = bench_time();
+
+  TEST_CHECK(count == tm->count);
+  TEST_CHECK(pos == (LOFF_T) size);
+  return end - start;
+}
+
+void test_mbox_parse_threads(void)
+{
+  size_t size = MBOX_PARSE_MIN_SIZE + (MBOX_PARSE_MIN_SIZE / 2);
+  int built = 0;
+  char *map = test_mbox_build(size, &built);
+  if (!TEST_CHECK(map != NULL))
+    return;
+  size = strlen(map);
+
+  struct TestMbox serial = { 0 };
+  struct TestMbox parallel = { 0 };
+  double t_serial = test_mbox_parse(map, size, 1, &serial);
+  double t_parallel = test_mbox_parse(map, size, 4, &parallel);
+
+  TEST_CHECK(serial.count > 1000);
+  TEST_CHECK((serial.count == built) && (parallel.count == built));
+  TEST_MSG("Built: %d, Serial: %d, Parallel: %d", built, serial.count, parallel.count);
+
+  for (int i = 0; (i < serial.count) && (i < parallel.count); i++)
+  {
+    struct Email *a = serial.emails[i];
+    struct Email *b = parallel.emails[i];
+    char subject[64];
+
+    /* neither a ">From " line in a body, nor a "From " line covered by the
+     * Content-Length, may start a new message */
+    snprintf(subject, sizeof(subject), "Test message %d", i);
+    if (!TEST_CHECK(mutt_str_strcmp(a->env->subject, subject) == 0))
+    {
+      TEST_MSG("Expected: %s, Actual: %s", subject, NONULL(a->env->subject));
+      break;
+    }
+
+    if (!TEST_CHECK((a->offset == b->offset) && (a->lines == b->lines) &&
+                    (a->received == b->received) &&
+                    (a->content->offset == b->content->offset) &&
+                    (a->content->length == b->content->length) &&
+                    (mutt_str_strcmp(a->env->subject, b->env->subject) == 0) &&
+                    (mutt_str_strcmp(a->env->message_id, b->env->message_id) == 0) &&
+                    a->env->from && b->env->from &&
+                    (mutt_str_strcmp(a->env->from->mailbox, b->env->from->mailbox) == 0) &&
+                    a->env->return_path && b->env->return_path &&
+                    (mutt_str_strcmp(a->env->return_path->mailbox,
+                                     b->env->return_path->mailbox) == 0)))
+    {
+      TEST_MSG("Email %d differs, offset " OFF_T_FMT " / " OFF_T_FMT, i,
+               a->offset, b->offset);
+      break;
+    }
+  }
+
+  /* Set NEOMUTT_BENCH=<rounds> to compare the speed of the two parsers */
+  long rounds = bench_rounds(0);
+  for (long r = 0; r < rounds; r++)
+  {
+    test_mbox_free(&serial);
+    test_mbox_free(&parallel);
+    t_serial += test_mbox_parse(map, size, 1, &serial);
+    t_parallel += test_mbox_parse(map, size, 4, &parallel);
+  }
+  if (bench_enabled())
+  {
+    rounds++;
+    printf("\n  %d messages, %zu bytes: serial %.3f s, parallel %.3f s\n",
+           serial.count, size, t_serial / rounds, t_parallel / rounds);
+  }
+
+  test_mbox_free(&serial);
+  test_mbox_free(&parallel);
+  FREE(&map);
+}
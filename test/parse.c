@@ -0,0 +1,57 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <inttypes.h>
+#include <string.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+
+void test_rfc822_parse_header(void)
+{
+  static const char header[] = "Return-Path: <bob@example.com>\n"
+                               "SUBJECT: Hello\n"
+                               "  World  \n"
+                               "\tagain\n"
+                               "Content-Length: 5\n"
+                               "X-Label:   \n"
+                               "x-label: tagged\n"
+                               "Message-ID: <1234@example.com>\n"
+                               "Content-Type: text/html; charset=utf-8\n"
+                               "X-Unknown: kept\n"
+                               "\n"
+                               "Body\n";
+
+  struct Email *e = mutt_email_new();
+  e->offset = 100;
+  e->env = mutt_rfc822_parse_header(header, sizeof(header) - 1, 1000, e, true, false);
+
+  TEST_CHECK(mutt_str_strcmp(e->env->subject, "Hello World again") == 0);
+  TEST_MSG("Subject: %s", NONULL(e->env->subject));
+  TEST_CHECK(mutt_str_strcmp(e->env->x_label, "tagged") == 0);
+  TEST_CHECK(mutt_str_strcmp(e->env->message_id, "<1234@example.com>") == 0);
+  TEST_CHECK(e->env->return_path &&
+             (mutt_str_strcmp(e->env->return_path->mailbox, "bob@example.com") == 0));
+  TEST_CHECK(e->content->type == TYPE_TEXT);
+  TEST_CHECK(mutt_str_strcmp(e->content->subtype, "html") == 0);
+  TEST_CHECK(e->content->length == 5);
+  TEST_CHECK(e->content->hdr_offset == 100);
+
+  /* the body starts after the blank line */
+  LOFF_T body = 1000 + (strstr(header, "Body") - header);
+  TEST_CHECK(e->content->offset == body);
+  TEST_MSG("Expected: " OFF_T_FMT ", Actual: " OFF_T_FMT, body, e->content->offset);
+
+  struct ListNode *np = STAILQ_FIRST(&e->env->userhdrs);
+  TEST_CHECK(np && (mutt_str_strcmp(np->data, "X-Unknown: kept") == 0));
+
+  mutt_email_free(&e);
+
+  /* a line that isn't a header field ends the header, and isn't consumed */
+  static const char bogus[] = "Subject: test\nnot a header\n\n";
+  e = mutt_email_new();
+  e->env = mutt_rfc822_parse_header(bogus, sizeof(bogus) - 1, 0, e, false, false);
+  TEST_CHECK(mutt_str_strcmp(e->env->subject, "test") == 0);
+  TEST_CHECK(e->content->offset == 14);
+  mutt_email_free(&e);
+}
@@ -5,8 +5,12 @@
 #include "mutt/memory.h"
 #include "mutt/string2.h"
 #include "email/rfc2047.h"
+#include "bench.h"
 
 #include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
 static const struct
 {
@@ -55,6 +59,66 @@ static const struct
       "=?UTF-8?Q?Sicherheitsl=C3=BCcke in praktisch allen IT-Systemen?="
     , "Sicherheitslücke in praktisch allen IT-Systemen"
     , "=?utf-8?Q?Sicherheitsl=C3=BCcke?= in praktisch allen IT-Systemen"
+  },
+  {
+    /* Plain ASCII isn't touched */
+      "Re: [neomutt/neomutt] Plain ASCII subject (#1234)"
+    , "Re: [neomutt/neomutt] Plain ASCII subject (#1234)"
+    , "Re: [neomutt/neomutt] Plain ASCII subject (#1234)"
+  },
+  {
+    /* ASCII in a Q word */
+      "=?utf-8?q?Plain_ASCII_in_a_Q_word?="
+    , "Plain ASCII in a Q word"
+    , "Plain ASCII in a Q word"
+  },
+  {
+    /* ASCII in a B word */
+      "=?US-ASCII?B?UGxhaW4gQVNDSUkgaW4gYSBCIHdvcmQ=?="
+    , "Plain ASCII in a B word"
+    , "Plain ASCII in a B word"
+  },
+  {
+    /* Adjacent B and Q words */
+      "=?utf-8?B?6IGq5piO55qE?= =?UTF-8?Q?l=C3=BCcke?="
+    , "聪明的lücke"
+    , "=?utf-8?B?6IGq5piO55qEbMO8Y2tl?="
+  },
+  {
+    /* A charset that needs converting */
+      "=?iso-8859-1?q?Gr=FC=DFe_aus_K=F6ln?="
+    , "Grüße aus Köln"
+    , "=?utf-8?B?R3LDvMOfZSBhdXMgS8O2bG4=?="
+  },
+  {
+    /* A charset that isn't ASCII-compatible in 0x80-0x9f */
+      "=?windows-1252?q?=93quoted=94?="
+    , "“quoted”"
+    , "=?utf-8?B?4oCccXVvdGVk4oCd?="
+  },
+  {
+    /* Invalid UTF-8 is replaced */
+      "=?utf-8?q?bad_=C3=28_=ED=A0=80?="
+    , "bad �( ���"
+    , "bad =?utf-8?B?77+9KCDvv73vv73vv70=?="
+  },
+  {
+    /* Control characters are replaced or dropped */
+      "=?utf-8?q?tab=09and_nul=00dropped?= tail"
+    , "tab?and nul tail"
+    , "tab?and nul tail"
+  },
+  {
+    /* A multi-byte sequence split between words */
+      "=?utf-8?q?split_=E2=82?= =?utf-8?q?=AC_euro?="
+    , "split € euro"
+    , "split =?utf-8?B?4oKs?= euro"
+  },
+  {
+    /* Invalid base64 keeps the original text */
+      "=?utf-8?b?!!!?= kept"
+    , "=?utf-8?b?!!!?= kept"
+    , "=?utf-8?B?PT91dGYtOD9iPyEhIT89?= kept"
   }
 };
 /* clang-format on */
@@ -68,7 +132,10 @@ void test_rfc2047(void)
     return;
   }
 
+  char *charset = Charset;
+  bool is_utf8 = CharsetIsUtf8;
   Charset = "utf-8";
+  CharsetIsUtf8 = true;
 
   for (size_t i = 0; i < mutt_array_size(test_data); ++i)
   {
@@ -105,4 +172,45 @@ void test_rfc2047(void)
     }
     FREE(&s);
   }
+
+  Charset = charset;
+  CharsetIsUtf8 = is_utf8;
+}
+
+void test_rfc2047_throughput(void)
+{
+  if (!TEST_CHECK((setlocale(LC_ALL, "en_US.UTF-8") != NULL) ||
+                  (setlocale(LC_ALL, "C.UTF-8") != NULL)))
+  {
+    TEST_MSG("Cannot set locale to (en_US|C).UTF-8");
+    return;
+  }
+
+  char *charset = Charset;
+  bool is_utf8 = CharsetIsUtf8;
+  Charset = "utf-8";
+  CharsetIsUtf8 = true;
+
+  /* Set NEOMUTT_BENCH=<rounds> to measure the decoding speed */
+  long rounds = bench_rounds(1000);
+  size_t bytes = 0;
+
+  double start = bench_time();
+  for (long r = 0; r < rounds; r++)
+  {
+    for (size_t i = 0; i < mutt_array_size(test_data); ++i)
+    {
+      char *s = mutt_str_strdup(test_data[i].original);
+      bytes += strlen(s);
+      rfc2047_decode(&s);
+      FREE(&s);
+    }
+  }
+  double secs = bench_time() - start;
+
+  if (bench_enabled())
+    printf("\n  %ld rounds: %.3f s, %.1f MB/s\n", rounds, secs, bytes / secs / 1e6);
+
+  Charset = charset;
+  CharsetIsUtf8 = is_utf8;
 }
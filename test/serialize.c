@@ -0,0 +1,151 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdbool.h>
+#include <string.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "hcache/serialize.h"
+
+static struct Body *new_part(int type, const char *subtype, LOFF_T offset, LOFF_T length)
+{
+  struct Body *b = mutt_body_new();
+  b->type = type;
+  b->subtype = mutt_str_strdup(subtype);
+  b->encoding = ENC_7BIT;
+  b->hdr_offset = offset;
+  b->offset = offset + 40;
+  b->length = length;
+  return b;
+}
+
+/**
+ * new_tree - Create a nested MIME tree
+ * @retval ptr Parts of a multipart/mixed message
+ *
+ * The tree is:
+ * - text/plain
+ * - message/rfc822
+ *   - multipart/alternative
+ *     - text/plain
+ *     - text/html
+ * - application/pdf
+ */
+static struct Body *new_tree(void)
+{
+  struct Body *text = new_part(TYPE_TEXT, "plain", 100, 50);
+  mutt_param_set(&text->parameter, "charset", "utf-8");
+
+  struct Body *msg = new_part(TYPE_MESSAGE, "rfc822", 200, 400);
+  msg->description = mutt_str_strdup("Forwarded message");
+  msg->email = mutt_email_new();
+  msg->email->env = mutt_env_new();
+  msg->email->env->subject = mutt_str_strdup("Inner subject");
+  msg->email->env->from = mutt_addr_parse_list(NULL, "Bob <bob@example.com>");
+  msg->email->env->message_id = mutt_str_strdup("<inner@example.com>");
+  msg->email->offset = 240;
+  msg->email->lines = 12;
+
+  struct Body *alt = new_part(TYPE_MULTIPART, "alternative", 300, 280);
+  mutt_param_set(&alt->parameter, "boundary", "inner-boundary");
+  alt->parts = new_part(TYPE_TEXT, "plain", 340, 60);
+  alt->parts->next = new_part(TYPE_TEXT, "html", 460, 90);
+  alt->parts->next->encoding = ENC_QUOTED_PRINTABLE;
+  msg->parts = alt;
+  msg->email->content = alt;
+
+  struct Body *pdf = new_part(TYPE_APPLICATION, "pdf", 650, 3000);
+  pdf->encoding = ENC_BASE64;
+  pdf->disposition = DISP_ATTACH;
+  pdf->filename = mutt_str_strdup("report.pdf");
+  mutt_param_set(&pdf->parameter, "name", "report.pdf");
+
+  text->next = msg;
+  msg->next = pdf;
+  return text;
+}
+
+static bool parts_equal(const struct Body *a, const struct Body *b, int depth)
+{
+  for (; a && b; a = a->next, b = b->next)
+  {
+    if (!TEST_CHECK(mutt_body_cmp_strict(a, b)) ||
+        !TEST_CHECK((a->hdr_offset == b->hdr_offset) && (a->offset == b->offset) &&
+                    (a->length == b->length) && (a->encoding == b->encoding) &&
+                    (a->disposition == b->disposition)) ||
+        !TEST_CHECK(mutt_str_strcmp(a->filename, b->filename) == 0) ||
+        !TEST_CHECK(!a->email == !b->email))
+    {
+      TEST_MSG("Depth %d, part %s/%s differs", depth, a->subtype, b->subtype);
+      return false;
+    }
+
+    if (a->email)
+    {
+      if (!TEST_CHECK(mutt_env_cmp_strict(a->email->env, b->email->env)) ||
+          !TEST_CHECK((a->email->offset == b->email->offset) &&
+                      (a->email->lines == b->email->lines)) ||
+          !TEST_CHECK(b->email->content == b->parts))
+      {
+        TEST_MSG("Depth %d, embedded email differs", depth);
+        return false;
+      }
+    }
+
+    if (!parts_equal(a->parts, b->parts, depth + 1))
+      return false;
+  }
+
+  return TEST_CHECK(!a && !b);
+}
+
+void test_serial_parts(void)
+{
+  struct Body *parts = new_tree();
+  struct EmailCache hc = { NULL, 0x5eed, NULL };
+
+  /* the parts are a record of their own: validity, CRC, then the tree */
+  int len = 0;
+  unsigned char *d = mutt_hcache_dump_parts(&hc, parts, &len, 42);
+  TEST_CHECK(d && (len > (int) (sizeof(union Validate) + sizeof(unsigned int))));
+  TEST_CHECK(*(unsigned int *) d == 42);
+  TEST_CHECK(*(unsigned int *) (d + sizeof(union Validate)) == hc.crc);
+
+  struct Body *copy = mutt_hcache_restore_parts(d);
+  parts_equal(parts, copy, 0);
+
+  /* no parts at all */
+  int len2 = 0;
+  unsigned char *d2 = mutt_hcache_dump_parts(&hc, NULL, &len2, 42);
+  TEST_CHECK(!mutt_hcache_restore_parts(d2));
+
+  /* the header's record doesn't contain the parts, so storing the header,
+   * e.g. after a flag change, can't overwrite them */
+  struct Email *e = mutt_email_new();
+  e->env = mutt_env_new();
+  e->env->subject = mutt_str_strdup("Outer subject");
+  e->content = new_part(TYPE_MULTIPART, "mixed", 0, 4000);
+  e->content->parts = parts;
+
+  int hlen = 0;
+  unsigned char *h = mutt_hcache_dump(&hc, e, &hlen, 42);
+  e->content->parts = NULL;
+  int hlen2 = 0;
+  unsigned char *h2 = mutt_hcache_dump(&hc, e, &hlen2, 42);
+  if (!TEST_CHECK((hlen == hlen2) && (memcmp(h, h2, hlen) == 0)))
+    TEST_MSG("Header record: %d bytes with parts, %d without", hlen, hlen2);
+
+  struct Email *e2 = mutt_hcache_restore(h);
+  TEST_CHECK(e2->content && !e2->content->parts);
+  TEST_CHECK(mutt_str_strcmp(e2->env->subject, "Outer subject") == 0);
+
+  FREE(&d);
+  FREE(&d2);
+  FREE(&h);
+  FREE(&h2);
+  mutt_email_free(&e2);
+  mutt_email_free(&e);
+  mutt_body_free(&copy);
+  mutt_body_free(&parts);
+}
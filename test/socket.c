@@ -0,0 +1,249 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include "mutt/mutt.h"
+#include "conn/connection.h"
+#include "conn/socket.h"
+#include "conn/ssl.h"
+#include "conn/tunnel.h"
+#include "mutt_socket.h"
+#include "protos.h"
+
+/* The test never opens a real socket, so the transports are stubs */
+int mutt_system(const char *cmd)
+{
+  return -1;
+}
+
+#ifdef USE_SSL
+int mutt_ssl_socket_setup(struct Connection *conn)
+{
+  return -1;
+}
+#endif
+
+void mutt_tunnel_socket_setup(struct Connection *conn)
+{
+}
+
+int raw_socket_open(struct Connection *conn)
+{
+  return -1;
+}
+
+int raw_socket_close(struct Connection *conn)
+{
+  return -1;
+}
+
+int raw_socket_read(struct Connection *conn, char *buf, size_t len)
+{
+  return -1;
+}
+
+int raw_socket_write(struct Connection *conn, const char *buf, size_t count)
+{
+  return -1;
+}
+
+int raw_socket_poll(struct Connection *conn, time_t wait_secs)
+{
+  return -1;
+}
+
+/**
+ * struct FakeServer - Record what a Connection does to its transport
+ */
+struct FakeServer
+{
+  char sent[32768];  ///< Everything that was written
+  size_t sent_len;
+  char events[64];   ///< 'w' write, 'r' read, 'c' close, in order
+  int num_events;
+  int writes;
+  int reads;
+  int closes;
+  bool fail;         ///< Make every write fail
+  const char *reply; ///< What conn_read returns
+};
+
+static void fake_event(struct FakeServer *fs, char ev)
+{
+  if (fs->num_events < (int) sizeof(fs->events) - 1)
+    fs->events[fs->num_events++] = ev;
+}
+
+static int fake_write(struct Connection *conn, const char *buf, size_t count)
+{
+  struct FakeServer *fs = conn->sockdata;
+  fs->writes++;
+  fake_event(fs, 'w');
+  if (fs->fail)
+  {
+    errno = EPIPE;
+    return -1;
+  }
+  if (fs->sent_len + count <= sizeof(fs->sent))
+    memcpy(fs->sent + fs->sent_len, buf, count);
+  fs->sent_len += count;
+  return count;
+}
+
+static int fake_read(struct Connection *conn, char *buf, size_t count)
+{
+  struct FakeServer *fs = conn->sockdata;
+  fs->reads++;
+  fake_event(fs, 'r');
+  size_t len = mutt_str_strlen(fs->reply);
+  if (len > count)
+    len = count;
+  memcpy(buf, fs->reply, len);
+  fs->reply += len;
+  return len;
+}
+
+static int fake_close(struct Connection *conn)
+{
+  struct FakeServer *fs = conn->sockdata;
+  fs->closes++;
+  fake_event(fs, 'c');
+  return 0;
+}
+
+static void fake_conn_init(struct Connection *conn, struct FakeServer *fs)
+{
+  memset(conn, 0, sizeof(*conn));
+  memset(fs, 0, sizeof(*fs));
+  conn->fd = 1;
+  conn->sockdata = fs;
+  conn->conn_write = fake_write;
+  conn->conn_read = fake_read;
+  conn->conn_close = fake_close;
+}
+
+void test_socket_buffer(void)
+{
+  struct Connection conn;
+  struct FakeServer fs;
+  fake_conn_init(&conn, &fs);
+
+  /* Many small commands are collected, then sent in one write */
+  char cmd[32];
+  for (int i = 0; i < 50; i++)
+  {
+    snprintf(cmd, sizeof(cmd), "a%04d NOOP\r\n", i);
+    TEST_CHECK(mutt_socket_send(&conn, cmd) == (int) strlen(cmd));
+  }
+  if (!TEST_CHECK(fs.writes == 0))
+    TEST_MSG("Expected: 0 writes, Actual: %d", fs.writes);
+
+  TEST_CHECK(mutt_socket_flush(&conn) == 0);
+  if (!TEST_CHECK(fs.writes == 1))
+    TEST_MSG("Expected: 1 write, Actual: %d", fs.writes);
+  TEST_CHECK(fs.sent_len == 50 * strlen(cmd));
+  TEST_CHECK(strncmp(fs.sent, "a0000 NOOP\r\na0001 NOOP\r\n", 24) == 0);
+  TEST_CHECK(strncmp(fs.sent + fs.sent_len - 12, "a0049 NOOP\r\n", 12) == 0);
+
+  /* Nothing left to send */
+  TEST_CHECK(mutt_socket_flush(&conn) == 0);
+  TEST_CHECK(fs.writes == 1);
+
+  /* Filling the buffer sends what's already there, in order */
+  char line[1024];
+  memset(line, 'x', sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  const int per_buf = sizeof(conn.outbuf) / strlen(line);
+  for (int i = 0; i <= per_buf; i++)
+    mutt_socket_send(&conn, line);
+  TEST_CHECK(fs.writes == 2);
+  TEST_CHECK(conn.outlen == (int) strlen(line));
+
+  /* A write larger than the buffer goes straight out, after the buffer */
+  char big[sizeof(conn.outbuf) + 1];
+  memset(big, 'y', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+  size_t before = fs.sent_len;
+  TEST_CHECK(mutt_socket_send(&conn, big) == (int) strlen(big));
+  TEST_CHECK(fs.writes == 4);
+  TEST_CHECK(conn.outlen == 0);
+  TEST_CHECK(fs.sent_len == before + strlen(line) + strlen(big));
+  if (fs.sent_len <= sizeof(fs.sent))
+    TEST_CHECK(fs.sent[before] == 'x' && fs.sent[fs.sent_len - 1] == 'y');
+
+  TEST_CHECK(fs.closes == 0);
+}
+
+void test_socket_flush_read(void)
+{
+  struct Connection conn;
+  struct FakeServer fs;
+  fake_conn_init(&conn, &fs);
+  fs.reply = "a0001 OK NOOP completed\r\n";
+
+  /* The command must be sent before we wait for its reply */
+  mutt_socket_send(&conn, "a0001 NOOP\r\n");
+  TEST_CHECK(fs.writes == 0);
+
+  char buf[128];
+  TEST_CHECK(mutt_socket_readln(buf, sizeof(buf), &conn) > 0);
+  TEST_CHECK(mutt_str_strcmp(buf, "a0001 OK NOOP completed") == 0);
+  if (!TEST_CHECK(strcmp(fs.events, "wr") == 0))
+    TEST_MSG("Expected: wr, Actual: %s", fs.events);
+
+  /* Polling flushes too */
+  mutt_socket_send(&conn, "a0002 NOOP\r\n");
+  mutt_socket_poll(&conn, 0);
+  TEST_CHECK(fs.writes == 2);
+
+  /* So does a plain read */
+  fs.reply = "* OK\r\n";
+  mutt_socket_send(&conn, "a0003 NOOP\r\n");
+  TEST_CHECK(mutt_socket_read(&conn, buf, sizeof(buf)) == 6);
+  if (!TEST_CHECK(strcmp(fs.events, "wrwwr") == 0))
+    TEST_MSG("Expected: wrwwr, Actual: %s", fs.events);
+}
+
+void test_socket_flush_fail(void)
+{
+  struct Connection conn;
+  struct FakeServer fs;
+  char buf[128];
+
+  /* A failed flush closes the connection once */
+  fake_conn_init(&conn, &fs);
+  fs.fail = true;
+  mutt_socket_send(&conn, "a0001 LOGOUT\r\n");
+  TEST_CHECK(mutt_socket_flush(&conn) == -1);
+  TEST_CHECK(fs.closes == 1);
+  TEST_CHECK(conn.fd == -1);
+  TEST_CHECK(conn.outlen == 0);
+
+  /* Closing it again, or using it, doesn't touch the transport */
+  mutt_socket_close(&conn);
+  TEST_CHECK(mutt_socket_send(&conn, "a0002 NOOP\r\n") == -1);
+  TEST_CHECK(mutt_socket_readchar(&conn, buf) == -1);
+  if (!TEST_CHECK((fs.closes == 1) && (fs.writes == 1) && (fs.reads == 0)))
+    TEST_MSG("closes %d, writes %d, reads %d", fs.closes, fs.writes, fs.reads);
+
+  /* The same when the flush is triggered by a read */
+  fake_conn_init(&conn, &fs);
+  fs.fail = true;
+  mutt_socket_send(&conn, "a0001 NOOP\r\n");
+  TEST_CHECK(mutt_socket_readln(buf, sizeof(buf), &conn) < 0);
+  if (!TEST_CHECK(strcmp(fs.events, "wc") == 0))
+    TEST_MSG("Expected: wc, Actual: %s", fs.events);
+
+  /* Closing with data still buffered sends it, then closes once, even if the
+   * write fails */
+  fake_conn_init(&conn, &fs);
+  fs.fail = true;
+  mutt_socket_send(&conn, "a0001 LOGOUT\r\n");
+  TEST_CHECK(mutt_socket_close(&conn) == 0);
+  if (!TEST_CHECK(strcmp(fs.events, "wc") == 0))
+    TEST_MSG("Expected: wc, Actual: %s", fs.events);
+  TEST_CHECK(conn.fd == -1);
+}